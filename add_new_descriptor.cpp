@@ -10,11 +10,15 @@
 #include <QMessageBox>
 #include <QFile>
 #include <QIODevice>
+#include "imagehash.hpp"
+#include "librarymanagement.hpp"
+#include "libraryfile.hpp"
 
 
-Add_New_Descriptor::Add_New_Descriptor(QString Librarypath, QWidget *parent)
+Add_New_Descriptor::Add_New_Descriptor(QString Librarypath, ManageLibrary *library, QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::Add_New_Descriptor)
+    , library(library)
 {
     ui->setupUi(this);
     ui->Image_path_hidden->setVisible(false);
@@ -105,6 +109,47 @@ void Add_New_Descriptor::on_save_the_descriptor_clicked()
         return;
     }
 
+    // Flag near-duplicates of images already in the library before copying anything
+    uint64_t hash;
+    try {
+        hash = differenceHashOfFile(imagePath.toStdString());
+    } catch (const std::exception&) {
+        QMessageBox::warning(this, "File Error", "Could not read the image file.");
+        isProcessing = false;
+        return;
+    }
+
+    // The library keeps its hash tree between adds: only the first check of a session builds it
+    vector<pair<unsigned int, int>> matches;
+    if (library != nullptr) {
+        matches = library->findNearDuplicates(hash);
+    }
+    if (!matches.empty()) {
+        QString message = "This image looks like images already in the library:\n";
+        for (const pair<unsigned int, int>& match : matches) {
+            Descriptor *existing = library->searchDescriptor(match.first);
+            QString title = existing != nullptr ? existing->getTitle() : QString();
+            message += QString("\n#%1 %2 (%3 bits differ)").arg(match.first).arg(title).arg(match.second);
+        }
+        message += "\n\nSave it anyway?";
+        if (QMessageBox::question(this, "Possible duplicate", message) != QMessageBox::Yes) {
+            isProcessing = false;
+            return;
+        }
+    }
+
+    // Read after the duplicate check, which may have written the hashes of older entries to the library
+    // (the library may be JSON or binary)
+    bool readOk = false;
+    QJsonObject obj = readLibraryDocument(Librarypath, &readOk);
+    if (!readOk) {
+        QMessageBox::warning(this, "File Error", "Could not open the library file.");
+        isProcessing = false;
+        return;
+    }
+
+    QJsonArray array = obj["library"].toArray();
+
     QString appPath = QCoreApplication::applicationDirPath();
     QString destinationDir = appPath + "/Images/";
     // QString destinationPath = destinationDir + QFileInfo(imagePath).fileName();
@@ -143,19 +188,6 @@ void Add_New_Descriptor::on_save_the_descriptor_clicked()
     Descriptor descriptor(0, cost.toDouble(), title, source, access, image);
 
     // Save descriptor to JSON
-    QFile jsonFile(Librarypath);
-    if (!jsonFile.open(QIODevice::ReadOnly)) {
-        QMessageBox::warning(this, "File Error", "Could not open the library file.");
-        isProcessing = false;
-        return;
-    }
-
-    QJsonDocument doc = QJsonDocument::fromJson(jsonFile.readAll());
-    jsonFile.close();
-
-    QJsonObject obj = doc.object();
-    QJsonArray array = obj["library"].toArray();
-
     QJsonObject newDescriptor;
     newDescriptor["id"] = array.size() + 1;
     newDescriptor["cost"] = cost.toDouble();
@@ -164,19 +196,23 @@ void Add_New_Descriptor::on_save_the_descriptor_clicked()
     newDescriptor["access"] = QString(access);
     // newDescriptor["Imagepath"] = "/Images/" + QFileInfo(imagePath).fileName();
     newDescriptor["Imagepath"] = "/Images/" + uniqueFileName;
+    // Probed once here, so that loading the library does not have to read the image again
+    newDescriptor["imageMetadata"] = image.metadataToJson();
+    newDescriptor["dhash"] = QString::fromStdString(hashToHex(hash));
     
 
     array.append(newDescriptor);
     obj["library"] = array;
 
-    if (!jsonFile.open(QIODevice::WriteOnly)) {
+    if (!writeLibraryDocument(Librarypath, obj)) {
         QMessageBox::warning(this, "File Error", "Could not open the library file for writing.");
         isProcessing = false;
         return;
     }
 
-    jsonFile.write(QJsonDocument(obj).toJson());
-    jsonFile.close();
+    addedId = static_cast<unsigned int>(newDescriptor["id"].toInt());
+    addedImagePath = newDescriptor["Imagepath"].toString();
+    addedPerceptualHash = newDescriptor["dhash"].toString();
 
     // Close the dialog
     accept();
@@ -189,3 +225,18 @@ void Add_New_Descriptor::setLibraryPath(QString Librarypath)
 {
     this->Librarypath = Librarypath;
 }
+
+unsigned int Add_New_Descriptor::getAddedId() const
+{
+    return addedId;
+}
+
+QString Add_New_Descriptor::getAddedImagePath() const
+{
+    return addedImagePath;
+}
+
+QString Add_New_Descriptor::getAddedPerceptualHash() const
+{
+    return addedPerceptualHash;
+}
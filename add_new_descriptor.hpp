@@ -3,6 +3,8 @@
 
 #include <QDialog>
 
+class ManageLibrary;
+
 namespace Ui {
 class Add_New_Descriptor;
 }
@@ -12,9 +14,14 @@ class Add_New_Descriptor : public QDialog
     Q_OBJECT
 
 public:
-    explicit Add_New_Descriptor(QString Librarypath,QWidget *parent = nullptr);
+    // Near-duplicates of the new image are looked up in library (the one open in the window)
+    explicit Add_New_Descriptor(QString Librarypath, ManageLibrary *library, QWidget *parent = nullptr);
     ~Add_New_Descriptor();
     void setLibraryPath(QString Librarypath);
+    // The descriptor written by the last successful save
+    unsigned int getAddedId() const;
+    QString getAddedImagePath() const;
+    QString getAddedPerceptualHash() const;
 
 private slots:
     void on_loadImageButton_clicked();
@@ -24,6 +31,10 @@ private slots:
 private:
     Ui::Add_New_Descriptor *ui;
     QString Librarypath;
+    ManageLibrary *library;
+    unsigned int addedId = 0;
+    QString addedImagePath;
+    QString addedPerceptualHash;
 
 };
 
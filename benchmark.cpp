@@ -0,0 +1,265 @@
+#include "benchmark.hpp"
+#include "imageproccessing.hpp"
+#include "gaussianblur.hpp"
+#include "medianfilter.hpp"
+#include "edgedetection.hpp"
+#include "threadpool.hpp"
+#include "pipeline.hpp"
+#include "bufferpool.hpp"
+#include "rotation.hpp"
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Mesure le temps moyen (en millisecondes) d'une fonction sur `iterations` exécutions.
+ */
+double timeIt(const function<void()>& fn, int iterations) {
+    fn(); // échauffement (caches, allocations)
+    double start = static_cast<double>(getTickCount());
+    for (int i = 0; i < iterations; i++) {
+        fn();
+    }
+    double elapsed = (static_cast<double>(getTickCount()) - start) / getTickFrequency();
+    return elapsed * 1000.0 / iterations;
+}
+
+bool sameBytes(const Mat& a, const Mat& b) {
+    if (a.size() != b.size() || a.type() != b.type()) {
+        return false;
+    }
+    size_t rowBytes = a.cols * a.elemSize();
+    for (int y = 0; y < a.rows; y++) {
+        if (!equal(a.ptr<uchar>(y), a.ptr<uchar>(y) + rowBytes, b.ptr<uchar>(y))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void printResults(const string& title, const vector<BenchmarkResult>& results) {
+    cout << title << endl;
+    for (const BenchmarkResult& result : results) {
+        cout << "  " << left << setw(44) << result.name
+             << right << fixed << setprecision(2) << setw(10) << result.milliseconds << " ms" << endl;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Compare l'ancien flou gaussien (2D, split/merge) au moteur séparable.
+ *
+ * Mesure aussi le moteur séparable sur des noyaux plus grands, que l'ancien chemin ne supportait pas.
+ * Chaque nom indique l'accélération par rapport à l'ancien flou 3x3 (`GaussianBlurMultiChannel`).
+ *
+ * @param image L'image de test (8 bits).
+ * @param iterations Le nombre d'exécutions par mesure.
+ * @return Les temps moyens, dans l'ordre des mesures.
+ */
+vector<BenchmarkResult> benchmarkGaussianFilter(const Mat& image, int iterations) {
+    vector<BenchmarkResult> results;
+    Mat output;
+
+    const double legacy = timeIt([&]() { GaussianBlurMultiChannel(image, output); }, iterations);
+    results.push_back({"Legacy 3x3 (GaussianBlurMultiChannel)", legacy});
+
+    const int sizes[] = {3, 7, 15, 31};
+    for (int size : sizes) {
+        double sigma = (size == 3) ? 1.0 : 0.0;
+        double ms = timeIt([&]() { separableGaussianBlur(image, output, size, sigma); }, iterations);
+        ostringstream name;
+        name << "Separable " << size << "x" << size << " (x" << fixed << setprecision(1) << legacy / ms << ")";
+        results.push_back({name.str(), ms});
+    }
+
+    return results;
+}
+
+/**
+ * @brief Mesure le filtre médian à coût constant pour plusieurs tailles de noyau.
+ *
+ * Les temps doivent rester du même ordre de 3x3 à 31x31.
+ */
+vector<BenchmarkResult> benchmarkMedianFilter(const Mat& image, int iterations) {
+    vector<BenchmarkResult> results;
+    Mat output;
+
+    const int sizes[] = {3, 9, 31};
+    for (int size : sizes) {
+        results.push_back({"Constant-time median " + to_string(size) + "x" + to_string(size),
+                           timeIt([&]() { constantTimeMedianFilter(image, output, size); }, iterations)});
+    }
+
+    return results;
+}
+
+/**
+ * @brief Mesure le Sobel fusionné, avec et sans calcul de la direction.
+ */
+vector<BenchmarkResult> benchmarkEdgeDetection(const Mat& image, int iterations) {
+    vector<BenchmarkResult> results;
+    Mat gray, magnitude, direction;
+    cvtColor(image, gray, COLOR_BGR2GRAY);
+
+    results.push_back({"Fused Sobel (magnitude)",
+                       timeIt([&]() { fusedSobel(gray, magnitude); }, iterations)});
+    results.push_back({"Fused Sobel (magnitude + direction)",
+                       timeIt([&]() { fusedSobel(gray, magnitude, &direction); }, iterations)});
+
+    return results;
+}
+
+/**
+ * @brief Courbe de montée en charge : les filtres parallèles mesurés avec 1, 2, 4, ... threads.
+ *
+ * Chaque nom indique le nombre de threads et l'accélération par rapport à un seul thread.
+ * Le nombre de threads du pool est restauré à la fin.
+ */
+vector<BenchmarkResult> benchmarkParallelScaling(const Mat& image, int iterations) {
+    vector<BenchmarkResult> results;
+    ImageProccessing processing;
+    Mat gray = processing.toGrayScale(image);
+    Mat output;
+
+    const vector<pair<string, function<void()>>> filters = {
+        {"Gaussian 7x7", [&]() { separableGaussianBlur(image, output, 7, 0); }},
+        {"Median 9x9", [&]() { constantTimeMedianFilter(image, output, 9); }},
+        {"Erosion 15x15", [&]() { output = processing.applyErosion(image, 15); }},
+        {"Sobel", [&]() { fusedSobel(gray, output); }},
+        {"Threshold", [&]() { output = processing.applyThreshold(gray, 128); }},
+        {"Grayscale", [&]() { output = processing.toGrayScale(image); }},
+    };
+
+    const int savedThreads = parallelThreadCount();
+    const int maxThreads = max(1, static_cast<int>(thread::hardware_concurrency()));
+    vector<int> threadCounts;
+    for (int threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    for (const auto& filter : filters) {
+        double singleThread = 0;
+        for (int threads : threadCounts) {
+            setParallelThreadCount(threads);
+            double ms = timeIt(filter.second, iterations);
+            if (threads == 1) {
+                singleThread = ms;
+            }
+            ostringstream name;
+            name << filter.first << ", " << threads << " thread(s) (x"
+                 << fixed << setprecision(1) << singleThread / ms << ")";
+            results.push_back({name.str(), ms});
+        }
+    }
+
+    setParallelThreadCount(savedThreads);
+    return results;
+}
+
+/**
+ * @brief Compare la chaîne gris -> flou 5x5 -> seuil appliquée filtre par filtre à la chaîne fusionnée.
+ *
+ * Ajoute le temps de chaque étape fusionnée (cumulé sur les threads) pour la dernière exécution.
+ */
+vector<BenchmarkResult> benchmarkPipeline(const Mat& image, int iterations) {
+    vector<BenchmarkResult> results;
+    ImageProccessing processing;
+    Mat separate, fused;
+
+    results.push_back({"Gray + Gaussian 5x5 + Threshold, one call each", timeIt([&]() {
+        separate = processing.applyThreshold(processing.applyGaussianFilter(processing.toGrayScale(image), 5, 1.0), 128);
+    }, iterations)});
+
+    FilterPipeline pipeline;
+    pipeline.grayscale().gaussian(5, 1.0).threshold(128);
+    vector<StageTiming> timings;
+    results.push_back({"Gray + Gaussian 5x5 + Threshold, fused", timeIt([&]() {
+        fused = pipeline.run(image, &timings);
+    }, iterations)});
+    for (const StageTiming& timing : timings) {
+        results.push_back({"  stage: " + timing.name, timing.milliseconds});
+    }
+
+    if (!sameBytes(separate, fused)) {
+        cerr << "Fused pipeline output differs from the separate filters" << endl;
+    }
+    return results;
+}
+
+/**
+ * @brief Compare l'ancienne rotation de 90 degrés (transpose + flip) au passage unique par tuiles,
+ *        et mesure les rotations d'angle quelconque.
+ */
+vector<BenchmarkResult> benchmarkRotation(const Mat& image, int iterations) {
+    vector<BenchmarkResult> results;
+    Mat output;
+
+    results.push_back({"Rotate 90, transpose + flip", timeIt([&]() {
+        transpose(image, output);
+        flip(output, output, 1);
+    }, iterations)});
+    results.push_back({"Rotate 90, blocked single pass",
+                       timeIt([&]() { rotateQuarterTurns(image, output, 1); }, iterations)});
+    results.push_back({"Rotate 180, single pass",
+                       timeIt([&]() { rotateQuarterTurns(image, output, 2); }, iterations)});
+    results.push_back({"Rotate 3 degrees, bilinear",
+                       timeIt([&]() { rotateArbitrary(image, output, 3.0, RotationInterpolation::Bilinear); }, iterations)});
+    results.push_back({"Rotate 3 degrees, bicubic",
+                       timeIt([&]() { rotateArbitrary(image, output, 3.0, RotationInterpolation::Bicubic); }, iterations)});
+
+    return results;
+}
+
+/**
+ * @brief Point d'entrée des benchmarks (`Library --benchmark <image>`).
+ *
+ * @return Le code de sortie du processus.
+ */
+int runBenchmarks(const string& imagePath) {
+    Mat image = imread(imagePath, IMREAD_COLOR);
+    if (image.empty()) {
+        cerr << "Error while loading the image: " << imagePath << endl;
+        return 1;
+    }
+    cout << "Image: " << imagePath << " (" << image.cols << "x" << image.rows
+         << ", " << image.channels() << " channels)" << endl;
+
+    const int iterations = 5;
+    printResults("Gaussian filter", benchmarkGaussianFilter(image, iterations));
+    printResults("Median filter", benchmarkMedianFilter(image, iterations));
+    printResults("Edge detection", benchmarkEdgeDetection(image, iterations));
+    printResults("Parallel scaling", benchmarkParallelScaling(image, iterations));
+    printResults("Filter pipeline", benchmarkPipeline(image, iterations));
+    printResults("Rotation", benchmarkRotation(image, iterations));
+
+    // Le moteur séparable doit produire exactement les mêmes octets quel que soit le découpage en bandes.
+    Mat first, second;
+    const int savedThreads = parallelThreadCount();
+    setParallelThreadCount(1);
+    separableGaussianBlur(image, first, 7, 0);
+    setParallelThreadCount(savedThreads);
+    separableGaussianBlur(image, second, 7, 0);
+    cout << "Separable output identical with 1 and " << savedThreads << " thread(s): "
+         << (sameBytes(first, second) ? "yes" : "no") << endl;
+
+    // En régime établi, un filtre reprend son tampon de sortie dans le pool au lieu de l'allouer.
+    BufferPool& pool = BufferPool::instance();
+    BufferPoolStats before = pool.stats();
+    separableGaussianBlur(image, first, 7, 0);
+    BufferPoolStats after = pool.stats();
+    const size_t heapAllocations = (after.allocations - before.allocations) - (after.reuses - before.reuses);
+    cout << "Buffer pool: peak " << fixed << setprecision(1) << after.peakBytesInUse / (1024.0 * 1024.0) << " MB, "
+         << after.reuses << "/" << after.allocations << " buffers reused, "
+         << heapAllocations << " heap allocation(s) for a repeated Gaussian blur" << endl;
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+struct BenchmarkResult {
+    string name;
+    double milliseconds;   // temps moyen par exécution
+};
+
+vector<BenchmarkResult> benchmarkGaussianFilter(const Mat& image, int iterations);
+vector<BenchmarkResult> benchmarkMedianFilter(const Mat& image, int iterations);
+vector<BenchmarkResult> benchmarkEdgeDetection(const Mat& image, int iterations);
+vector<BenchmarkResult> benchmarkParallelScaling(const Mat& image, int iterations);
+vector<BenchmarkResult> benchmarkPipeline(const Mat& image, int iterations);
+vector<BenchmarkResult> benchmarkRotation(const Mat& image, int iterations);
+int runBenchmarks(const string& imagePath);
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,184 @@
+#include "bufferpool.hpp"
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Classe de taille d'une demande : arrondie au multiple supérieur de 2^(k-2), où 2^k <= bytes.
+ *
+ * Les petites demandes (< BUFFER_POOL_MIN_BYTES) ne sont pas arrondies : elles ne passent pas par la réserve.
+ */
+size_t sizeClass(size_t bytes) {
+    if (bytes < BUFFER_POOL_MIN_BYTES) {
+        return bytes;
+    }
+    int shift = 0;
+    while ((bytes >> (shift + 1)) != 0) {
+        shift++;
+    }
+    const size_t step = static_cast<size_t>(1) << (shift - 2);
+    return (bytes + step - 1) / step * step;
+}
+
+} // namespace
+
+BufferPool& BufferPool::instance() {
+    // Jamais détruit : des Mat statiques ou encore affichées peuvent être libérées après main().
+    static BufferPool* pool = new BufferPool();
+    return *pool;
+}
+
+/**
+ * @brief Alloue le tampon d'une Mat, en reprenant si possible un tampon libre de la même classe de taille.
+ *
+ * Même calcul des pas que l'allocateur standard d'OpenCV ; un tampon fourni par l'appelant (`data` non nul)
+ * est simplement enveloppé.
+ */
+UMatData* BufferPool::allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                               AccessFlag, UMatUsageFlags) const {
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; i--) {
+        if (step) {
+            if (data && step[i] != CV_AUTOSTEP) {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            } else {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    UMatData* u = new UMatData(this);
+    u->size = total;
+    if (data) {
+        u->data = u->origdata = static_cast<uchar*>(data);
+        u->flags |= UMatData::USER_ALLOCATED;
+        return u;
+    }
+
+    const size_t bytes = sizeClass(total);
+    void* buffer = nullptr;
+    {
+        lock_guard<mutex> lock(poolMutex);
+        counters.allocations++;
+        auto it = freeLists.find(bytes);
+        if (it != freeLists.end() && !it->second.empty()) {
+            buffer = it->second.back();
+            it->second.pop_back();
+            counters.bytesCached -= bytes;
+            counters.reuses++;
+        }
+    }
+    if (!buffer) {
+        try {
+            buffer = fastMalloc(bytes);
+        } catch (...) {
+            delete u;
+            throw;
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(poolMutex);
+        counters.bytesInUse += bytes;
+        counters.peakBytesInUse = max(counters.peakBytesInUse, counters.bytesInUse);
+    }
+    u->data = u->origdata = static_cast<uchar*>(buffer);
+    return u;
+}
+
+bool BufferPool::allocate(UMatData* data, AccessFlag, UMatUsageFlags) const {
+    return data != nullptr;
+}
+
+/**
+ * @brief Remet le tampon dans la liste de sa classe, ou le libère si la réserve est pleine.
+ */
+void BufferPool::deallocate(UMatData* u) const {
+    if (!u) {
+        return;
+    }
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+
+    if (!(u->flags & UMatData::USER_ALLOCATED)) {
+        const size_t bytes = sizeClass(u->size);
+        void* release = u->origdata;
+        {
+            lock_guard<mutex> lock(poolMutex);
+            counters.bytesInUse -= bytes;
+            if (bytes >= BUFFER_POOL_MIN_BYTES && counters.bytesCached + bytes <= maxCachedBytes) {
+                freeLists[bytes].push_back(u->origdata);
+                counters.bytesCached += bytes;
+                release = nullptr;
+            }
+        }
+        if (release) {
+            fastFree(release);
+        }
+        u->origdata = nullptr;
+    }
+    delete u;
+}
+
+BufferPoolStats BufferPool::stats() const {
+    lock_guard<mutex> lock(poolMutex);
+    return counters;
+}
+
+/**
+ * @brief Repart de l'occupation actuelle pour mesurer le pic d'une nouvelle série d'appels.
+ */
+void BufferPool::resetPeak() {
+    lock_guard<mutex> lock(poolMutex);
+    counters.peakBytesInUse = counters.bytesInUse;
+}
+
+/**
+ * @brief Fixe le nombre d'octets gardés en réserve au plus ; l'excédent est libéré immédiatement.
+ */
+void BufferPool::setCapacity(size_t bytes) {
+    lock_guard<mutex> lock(poolMutex);
+    maxCachedBytes = bytes;
+    trimLocked(bytes);
+}
+
+size_t BufferPool::capacity() const {
+    lock_guard<mutex> lock(poolMutex);
+    return maxCachedBytes;
+}
+
+/**
+ * @brief Rend au système tous les tampons en réserve (les Mat vivantes ne sont pas touchées).
+ */
+void BufferPool::releaseCached() {
+    lock_guard<mutex> lock(poolMutex);
+    trimLocked(0);
+}
+
+// Libère les plus grands tampons en réserve jusqu'à ce qu'il en reste au plus `limit` octets.
+void BufferPool::trimLocked(size_t limit) const {
+    for (auto it = freeLists.rbegin(); it != freeLists.rend() && counters.bytesCached > limit; ++it) {
+        vector<void*>& buffers = it->second;
+        while (!buffers.empty() && counters.bytesCached > limit) {
+            fastFree(buffers.back());
+            buffers.pop_back();
+            counters.bytesCached -= it->first;
+        }
+    }
+}
+
+/**
+ * @brief Crée une Mat dont le tampon vient du pool partagé.
+ *
+ * La Mat garde le pool comme allocateur : un `create` ultérieur sur elle (ou sur une copie) y retourne aussi.
+ */
+Mat pooledMat(int rows, int cols, int type) {
+    Mat mat;
+    mat.allocator = &BufferPool::instance();
+    mat.create(rows, cols, type);
+    return mat;
+}
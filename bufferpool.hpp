@@ -0,0 +1,69 @@
+#ifndef BUFFERPOOL_HPP
+#define BUFFERPOOL_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// En dessous de cette taille, les tampons sont alloués et libérés normalement (noyaux, petites tables).
+const size_t BUFFER_POOL_MIN_BYTES = 16 * 1024;
+
+// Octets gardés en réserve au plus par défaut (tampons libérés, prêts à être réutilisés).
+const size_t BUFFER_POOL_DEFAULT_CAPACITY = 256 * 1024 * 1024;
+
+struct BufferPoolStats {
+    size_t bytesInUse = 0;        // octets des Mat vivantes allouées par le pool
+    size_t peakBytesInUse = 0;    // maximum de bytesInUse depuis le dernier resetPeak()
+    size_t bytesCached = 0;       // octets libérés gardés en réserve
+    size_t allocations = 0;       // tampons demandés
+    size_t reuses = 0;            // tampons servis depuis la réserve, sans allocation sur le tas
+};
+
+/**
+ * @brief Allocateur de Mat qui recycle les tampons par classes de taille.
+ *
+ * Les tailles sont arrondies à quatre classes par puissance de deux (2^k, 1.25 * 2^k, 1.5 * 2^k,
+ * 1.75 * 2^k : au plus 25 % de perte). Quand une Mat est libérée, son tampon retourne dans la liste de
+ * sa classe au lieu d'être rendu au système ; la prochaine demande de la même classe le reprend. En
+ * régime établi (mêmes tailles d'image d'un appel à l'autre), les filtres n'allouent donc plus de
+ * tampons de la taille de l'image.
+ *
+ * L'instance partagée n'est jamais détruite : les Mat qu'elle a allouées peuvent lui survivre sans risque
+ * (variables statiques, images renvoyées à l'interface). Toutes les méthodes sont thread-safe.
+ */
+class BufferPool : public MatAllocator {
+public:
+    static BufferPool& instance();
+
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                       AccessFlag flags, UMatUsageFlags usageFlags) const override;
+    bool allocate(UMatData* data, AccessFlag accessFlags, UMatUsageFlags usageFlags) const override;
+    void deallocate(UMatData* data) const override;
+
+    BufferPoolStats stats() const;
+    void resetPeak();
+    void setCapacity(size_t bytes);
+    size_t capacity() const;
+    void releaseCached();
+
+private:
+    BufferPool() = default;
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    void trimLocked(size_t limit) const;
+
+    mutable mutex poolMutex;
+    mutable map<size_t, vector<void*>> freeLists;   // classe de taille -> tampons libres
+    mutable BufferPoolStats counters;
+    size_t maxCachedBytes = BUFFER_POOL_DEFAULT_CAPACITY;
+};
+
+Mat pooledMat(int rows, int cols, int type);
+
+#endif // BUFFERPOOL_HPP
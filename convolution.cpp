@@ -0,0 +1,108 @@
+#include "convolution.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+ZeroPaddedRowWindow::ZeroPaddedRowWindow(const Mat& src, int kernelRows, int kernelCols)
+    : src(src),
+      kernelRows(kernelRows),
+      radiusY(kernelRows / 2),
+      radiusX(kernelCols / 2),
+      paddedWidth(src.cols + kernelCols - 1),
+      nextRow(0),
+      started(false),
+      storage(static_cast<size_t>(kernelRows) * paddedWidth, 0),
+      zeroRow(paddedWidth, 0),
+      pointers(kernelRows) {
+}
+
+/**
+ * @brief Retourne les `kernelRows` lignes élargies centrées sur y (lignes hors de l'image = zéros).
+ *
+ * Les marges gauche et droite de chaque emplacement ne sont jamais écrites et restent donc nulles.
+ */
+const uchar* const* ZeroPaddedRowWindow::rowsFor(int y) {
+    auto slotOf = [&](int row) {
+        return storage.data() + static_cast<size_t>((row % kernelRows + kernelRows) % kernelRows) * paddedWidth;
+    };
+
+    if (!started) {
+        nextRow = y - radiusY;
+        started = true;
+    }
+    for (; nextRow <= y + radiusY; nextRow++) {
+        if (nextRow >= 0 && nextRow < src.rows) {
+            const uchar* row = src.ptr<uchar>(nextRow);
+            copy(row, row + src.cols, slotOf(nextRow) + radiusX);
+        }
+    }
+
+    for (int j = 0; j < kernelRows; j++) {
+        int row = y - radiusY + j;
+        pointers[j] = (row < 0 || row >= src.rows) ? zeroRow.data() : slotOf(row);
+    }
+    return pointers.data();
+}
+
+/**
+ * @brief Convolution par un noyau de taille quelconque sur les lignes [rowStart, rowEnd) (sortie déjà allouée).
+ *
+ * La boucle sur les pixels est la plus interne : chaque coefficient non nul est appliqué à une ligne
+ * entière, sans test de bordure (les lignes sont élargies de zéros), ce que le compilateur vectorise.
+ */
+void convolveGenericRows(const Mat& src, Mat& dst, const Mat& kernel, int rowStart, int rowEnd) {
+    const int width = src.cols;
+    ZeroPaddedRowWindow window(src, kernel.rows, kernel.cols);
+
+    for (int y = rowStart; y < rowEnd; y++) {
+        const uchar* const* rows = window.rowsFor(y);
+        float* out = dst.ptr<float>(y);
+        fill(out, out + width, 0.0f);
+
+        for (int j = 0; j < kernel.rows; j++) {
+            const float* coeffs = kernel.ptr<float>(j);
+            for (int i = 0; i < kernel.cols; i++) {
+                const float c = coeffs[i];
+                if (c == 0.0f) {
+                    continue;
+                }
+                const uchar* row = rows[j] + i;
+                for (int x = 0; x < width; x++) {
+                    out[x] += c * row[x];
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Applique une convolution dont le noyau n'est connu qu'à l'exécution.
+ *
+ * Chemin générique du moteur de convolution, pour les noyaux qui ne sont pas des `FixedKernel`
+ * (grandes tailles, coefficients calculés). Les pixels hors de l'image valent 0.
+ *
+ * @param src L'image d'entrée (CV_8UC1).
+ * @param dst L'image de sortie (CV_32FC1), valeurs non saturées.
+ * @param kernel Le noyau (CV_32FC1, dimensions impaires).
+ *
+ * @throws std::invalid_argument Si le noyau est vide, n'est pas en float ou a une dimension paire.
+ * @throws std::runtime_error Si l'image est vide ou n'a pas un seul canal 8 bits.
+ */
+void convolveGeneric(const Mat& src, Mat& dst, const Mat& kernel) {
+    if (kernel.empty() || kernel.type() != CV_32FC1 || kernel.rows % 2 == 0 || kernel.cols % 2 == 0) {
+        throw invalid_argument("Le noyau doit être une matrice float de dimensions impaires.");
+    }
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.type() != CV_8UC1) {
+        throw runtime_error("La convolution attend une image en niveaux de gris 8 bits.");
+    }
+
+    Mat output = pooledMat(src.rows, src.cols, CV_32FC1);
+    convolveGenericRows(src, output, kernel, 0, src.rows);
+    dst = output;
+}
@@ -0,0 +1,202 @@
+#ifndef CONVOLUTION_HPP
+#define CONVOLUTION_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "kernels.hpp"
+#include "simd.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Moteur de convolution.
+//
+// - Noyaux de taille fixe (`FixedKernel`, voir kernels.hpp) : le noyau est un paramètre de template,
+//   la boucle sur les coefficients est entièrement déroulée, les coefficients nuls disparaissent et
+//   ±1/±2 deviennent des additions/soustractions. Calcul entier sur 16 bits (SSE2/AVX2).
+// - Noyaux de taille quelconque connue à l'exécution : `convolveGeneric` (calcul en float).
+//
+// Convention commune : `rows[j]` pointe sur la ligne source (y + j - rayon vertical), élargie de
+// `cols / 2` pixels nuls à gauche ; la réponse au pixel x lit donc rows[j][x + i].
+
+namespace convolution_detail {
+
+template <const auto& K>
+using KernelOf = decay_t<decltype(K)>;
+
+template <const auto& K, size_t N>
+constexpr int tapRow() { return static_cast<int>(N) / KernelOf<K>::cols; }
+
+template <const auto& K, size_t N>
+constexpr int tapCol() { return static_cast<int>(N) % KernelOf<K>::cols; }
+
+template <const auto& K, size_t N>
+constexpr int tapCoeff() { return K.coeffs[tapRow<K, N>()][tapCol<K, N>()]; }
+
+template <const auto& K, size_t N, typename T>
+inline int scalarTerm(const T* const* rows, int x) {
+    constexpr int c = tapCoeff<K, N>();
+    const T* p = rows[tapRow<K, N>()] + x + tapCol<K, N>();
+    if constexpr (c == 0) {
+        return 0;
+    } else if constexpr (c == 1) {
+        return *p;
+    } else if constexpr (c == -1) {
+        return -static_cast<int>(*p);
+    } else {
+        return c * *p;
+    }
+}
+
+template <const auto& K, typename T, size_t... N>
+inline int scalarResponse(const T* const* rows, int x, index_sequence<N...>) {
+    return (0 + ... + scalarTerm<K, N>(rows, x));
+}
+
+#if defined(LIBRARY_HAVE_SSE2)
+template <const auto& K, size_t N>
+inline void accumulate8(__m128i& acc, const uchar* const* rows, int x) {
+    constexpr int c = tapCoeff<K, N>();
+    if constexpr (c != 0) {
+        const uchar* p = rows[tapRow<K, N>()] + x + tapCol<K, N>();
+        __m128i v = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+        if constexpr (c == 1) {
+            acc = _mm_add_epi16(acc, v);
+        } else if constexpr (c == -1) {
+            acc = _mm_sub_epi16(acc, v);
+        } else if constexpr (c == 2) {
+            acc = _mm_add_epi16(acc, _mm_add_epi16(v, v));
+        } else if constexpr (c == -2) {
+            acc = _mm_sub_epi16(acc, _mm_add_epi16(v, v));
+        } else {
+            acc = _mm_add_epi16(acc, _mm_mullo_epi16(v, _mm_set1_epi16(static_cast<short>(c))));
+        }
+    }
+}
+
+template <const auto& K, size_t... N>
+inline __m128i response8(const uchar* const* rows, int x, index_sequence<N...>) {
+    __m128i acc = _mm_setzero_si128();
+    (accumulate8<K, N>(acc, rows, x), ...);
+    return acc;
+}
+#endif
+
+#if defined(LIBRARY_HAVE_AVX2)
+template <const auto& K, size_t N>
+inline void accumulate16(__m256i& acc, const uchar* const* rows, int x) {
+    constexpr int c = tapCoeff<K, N>();
+    if constexpr (c != 0) {
+        const uchar* p = rows[tapRow<K, N>()] + x + tapCol<K, N>();
+        __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        if constexpr (c == 1) {
+            acc = _mm256_add_epi16(acc, v);
+        } else if constexpr (c == -1) {
+            acc = _mm256_sub_epi16(acc, v);
+        } else if constexpr (c == 2) {
+            acc = _mm256_add_epi16(acc, _mm256_add_epi16(v, v));
+        } else if constexpr (c == -2) {
+            acc = _mm256_sub_epi16(acc, _mm256_add_epi16(v, v));
+        } else {
+            acc = _mm256_add_epi16(acc, _mm256_mullo_epi16(v, _mm256_set1_epi16(static_cast<short>(c))));
+        }
+    }
+}
+
+template <const auto& K, size_t... N>
+inline __m256i response16(const uchar* const* rows, int x, index_sequence<N...>) {
+    __m256i acc = _mm256_setzero_si256();
+    (accumulate16<K, N>(acc, rows, x), ...);
+    return acc;
+}
+#endif
+
+template <const auto& K>
+using TapSequence = make_index_sequence<KernelOf<K>::rows * KernelOf<K>::cols>;
+
+} // namespace convolution_detail
+
+// Les réponses sur 8 bits doivent tenir dans un int16 pour les chemins vectorisés.
+template <const auto& K>
+constexpr bool fitsInt16Response() {
+    return K.absSum() * 255 <= 32767;
+}
+
+/**
+ * @brief Réponse du noyau K au pixel x (chemin scalaire, entièrement déroulé).
+ */
+template <const auto& K, typename T>
+inline int fixedResponse(const T* const* rows, int x) {
+    return convolution_detail::scalarResponse<K>(rows, x, convolution_detail::TapSequence<K>{});
+}
+
+#if defined(LIBRARY_HAVE_SSE2)
+/**
+ * @brief Réponses du noyau K aux pixels [x, x + 8), en int16.
+ */
+template <const auto& K>
+inline __m128i fixedResponse8(const uchar* const* rows, int x) {
+    static_assert(fitsInt16Response<K>(), "La réponse du noyau dépasse 16 bits.");
+    return convolution_detail::response8<K>(rows, x, convolution_detail::TapSequence<K>{});
+}
+#endif
+
+#if defined(LIBRARY_HAVE_AVX2)
+/**
+ * @brief Réponses du noyau K aux pixels [x, x + 16), en int16.
+ */
+template <const auto& K>
+inline __m256i fixedResponse16(const uchar* const* rows, int x) {
+    static_assert(fitsInt16Response<K>(), "La réponse du noyau dépasse 16 bits.");
+    return convolution_detail::response16<K>(rows, x, convolution_detail::TapSequence<K>{});
+}
+#endif
+
+/**
+ * @brief Fenêtre glissante de lignes élargies de zéros (bordure nulle) pour une convolution ligne par ligne.
+ *
+ * Seules `kernelRows` lignes sont gardées en mémoire ; la ligne source s occupe l'emplacement
+ * s mod kernelRows, donc une seule nouvelle ligne est copiée par ligne produite.
+ * `rowsFor` doit être appelée avec des y croissants.
+ */
+class ZeroPaddedRowWindow {
+public:
+    ZeroPaddedRowWindow(const Mat& src, int kernelRows, int kernelCols);
+
+    const uchar* const* rowsFor(int y);
+
+private:
+    const Mat& src;
+    int kernelRows;
+    int radiusY;
+    int radiusX;
+    int paddedWidth;
+    int nextRow;
+    bool started;
+    vector<uchar> storage;
+    vector<uchar> zeroRow;
+    vector<const uchar*> pointers;
+};
+
+/**
+ * @brief Appelle f(integral_constant<int, N>) si `size` fait partie de `Sizes`, sinon f(integral_constant<int, 0>).
+ *
+ * Permet d'instancier un chemin spécialisé pour les petites tailles de noyau courantes et de garder
+ * un chemin générique (taille 0 = connue seulement à l'exécution) pour les autres.
+ */
+template <int... Sizes, typename F>
+void dispatchKernelSize(int size, F&& f) {
+    bool specialized = ((size == Sizes ? (f(integral_constant<int, Sizes>{}), true) : false) || ...);
+    if (!specialized) {
+        f(integral_constant<int, 0>{});
+    }
+}
+
+void convolveGeneric(const Mat& src, Mat& dst, const Mat& kernel);
+void convolveGenericRows(const Mat& src, Mat& dst, const Mat& kernel, int rowStart, int rowEnd);
+
+#endif // CONVOLUTION_HPP
@@ -38,6 +38,8 @@ char Descriptor::getAccess() const { return this->access; }
 Image Descriptor::getImage() const { return this->image; }
 
 Descriptor* Descriptor::getNextDescriptor() const { return this->nextDescriptor; }
+// dHash of the image as 16 hex digits, empty if it has not been computed yet.
+QString Descriptor::getPerceptualHash() const { return this->perceptualHash; }
 
 void Descriptor::setIdDescriptor(int newIdDes) { this->idDes = newIdDes; }
 void Descriptor::setCost(double newCost)  { this->cost = newCost; }
@@ -47,6 +49,7 @@ void Descriptor::setAccess(const char& descAccess) { this->access = descAccess;
 void Descriptor::setImage(const Image& img) { this->image = img; }
 
 void Descriptor::setNextDescriptor(Descriptor* nextDesc) { this->nextDescriptor = nextDesc; }
+void Descriptor::setPerceptualHash(const QString& hash) { this->perceptualHash = hash; }
 
 QPixmap Descriptor::cvMatToQPixmap(const cv::Mat &mat) const {
     // Step 1: Convert cv::Mat to QImage
@@ -99,11 +102,15 @@ void Descriptor::display() const {
 QJsonObject Descriptor::toJson() const {
     QJsonObject json;
     json["Imagepath"] = image.getPath();
+    json["imageMetadata"] = image.metadataToJson();
     json["access"] = QString(access);
     json["cost"] = cost;
     json["id"] = static_cast<int>(idDes);
     json["source"] = source;
     json["title"] = title;
+    if (!perceptualHash.isEmpty()) {
+        json["dhash"] = perceptualHash;
+    }
    
     return json;
 }
@@ -13,6 +13,7 @@ private:
     QString source;
     char access;
     Image image;
+    QString perceptualHash;
 
 public:
     Descriptor(const Image& img);
@@ -29,6 +30,7 @@ public:
     char getAccess() const;
     Image getImage() const;
     Descriptor* getNextDescriptor() const;
+    QString getPerceptualHash() const;
 
     void setIdDescriptor(int newIdDes);
     void setCost(double newCost);
@@ -37,6 +39,7 @@ public:
     void setAccess(const char& descAccess);
     void setImage(const Image& img);
     void setNextDescriptor(Descriptor* nextDesc);
+    void setPerceptualHash(const QString& hash);
 
     void display() const;
     QPixmap cvMatToQPixmap(const cv::Mat& mat) const;
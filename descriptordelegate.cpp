@@ -0,0 +1,135 @@
+#include "descriptordelegate.hpp"
+#include "descriptorlistmodel.hpp"
+#include <QPainter>
+
+namespace {
+
+// Same geometry and colours as the former widget cells
+const int CELL_WIDTH = 250;
+const int CELL_HEIGHT = 350;
+const int MARGIN = 10;
+const int CONTENT_WIDTH = CELL_WIDTH - 2 * MARGIN;
+const int IMAGE_HEIGHT = 200;
+const int IMAGE_HEIGHT_WITH_INFO = 100;
+const int INFO_HEIGHT = 33;
+const int SPACING = 6;
+const int BUTTON_HEIGHT = 26;
+const int BUTTON_SPACING = 4;
+
+const QColor CARD_BORDER("#dddddd");
+const QColor IMAGE_BORDER("#cccccc");
+const QColor INFO_BACKGROUND("#f9f9f9");
+const QColor TEXT_COLOR("#333333");
+const QColor PLACEHOLDER_COLOR("#888888");
+const QColor BUTTON_COLOR(153, 193, 241);
+
+} // namespace
+
+DescriptorDelegate::DescriptorDelegate(bool showAdminButtons, QObject *parent)
+    : QStyledItemDelegate(parent), showAdminButtons(showAdminButtons)
+{
+}
+
+void DescriptorDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing);
+
+    // Card
+    const QRect card = option.rect.adjusted(0, 0, -1, -1);
+    painter->setPen(CARD_BORDER);
+    painter->setBrush(Qt::white);
+    painter->drawRoundedRect(card, 10, 10);
+
+    // Thumbnail, or a placeholder while it is decoded
+    const bool infoVisible = index.data(DescriptorListModel::InfoVisibleRole).toBool();
+    const int imageHeight = infoVisible ? IMAGE_HEIGHT_WITH_INFO : IMAGE_HEIGHT;
+    const QRect imageRect(card.x() + MARGIN, card.y() + MARGIN, CONTENT_WIDTH, imageHeight);
+    painter->setPen(IMAGE_BORDER);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(imageRect);
+
+    const QPixmap pixmap = qvariant_cast<QPixmap>(index.data(Qt::DecorationRole));
+    const QRect imageArea = imageRect.adjusted(5, 5, -5, -5);
+    if (!pixmap.isNull())
+    {
+        QSize size = pixmap.size();
+        if (size.width() > imageArea.width() || size.height() > imageArea.height())
+        {
+            size.scale(imageArea.size(), Qt::KeepAspectRatio);
+        }
+        QRect target(QPoint(0, 0), size);
+        target.moveCenter(imageArea.center());
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+        painter->drawPixmap(target, pixmap);
+    }
+    else
+    {
+        const bool missing = index.data(DescriptorListModel::ThumbnailStateRole).toInt() == DescriptorListModel::ThumbnailMissing;
+        painter->setPen(PLACEHOLDER_COLOR);
+        painter->drawText(imageArea, Qt::AlignCenter, missing ? "No preview" : "Loading...");
+    }
+
+    // Information box ("ID: x", plus cost, title, source and access once expanded)
+    const QRect infoRect(card.x() + MARGIN, imageRect.bottom() + SPACING, CONTENT_WIDTH,
+                         INFO_HEIGHT + IMAGE_HEIGHT - imageHeight);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(INFO_BACKGROUND);
+    painter->drawRoundedRect(infoRect, 5, 5);
+    painter->setPen(TEXT_COLOR);
+    painter->drawText(infoRect.adjusted(10, 5, -10, -5), Qt::AlignLeft | Qt::AlignVCenter | Qt::TextWordWrap,
+                      index.data(Qt::DisplayRole).toString());
+
+    // Buttons
+    QFont font = option.font;
+    font.setBold(true);
+    font.setPixelSize(14);
+    painter->setFont(font);
+    const Button buttons[] = {InfoButton, DeleteButton, EditButton};
+    const char *labels[] = {"Show/Hide Info", "Delete", "Edit"};
+    for (int i = 0; i < 3; i++)
+    {
+        const QRect rect = buttonRect(option.rect, buttons[i]);
+        if (rect.isNull())
+        {
+            continue;
+        }
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(BUTTON_COLOR);
+        painter->drawRoundedRect(rect, 5, 5);
+        painter->setPen(Qt::white);
+        painter->drawText(rect, Qt::AlignCenter, labels[i]);
+    }
+
+    painter->restore();
+}
+
+QSize DescriptorDelegate::sizeHint(const QStyleOptionViewItem &, const QModelIndex &) const
+{
+    return QSize(CELL_WIDTH, CELL_HEIGHT);
+}
+
+// Which button of the cell painted in cellRect is under position (view coordinates).
+DescriptorDelegate::Button DescriptorDelegate::buttonAt(const QRect &cellRect, const QPoint &position) const
+{
+    for (Button button : {InfoButton, DeleteButton, EditButton})
+    {
+        if (buttonRect(cellRect, button).contains(position))
+        {
+            return button;
+        }
+    }
+    return NoButton;
+}
+
+QRect DescriptorDelegate::buttonRect(const QRect &cellRect, Button button) const
+{
+    // Delete and Edit are only offered to administrators
+    if (button == NoButton || (!showAdminButtons && button != InfoButton))
+    {
+        return QRect();
+    }
+    const int top = cellRect.y() + MARGIN + IMAGE_HEIGHT + SPACING + INFO_HEIGHT + SPACING;
+    const int slot = static_cast<int>(button) - static_cast<int>(InfoButton);
+    return QRect(cellRect.x() + MARGIN, top + slot * (BUTTON_HEIGHT + BUTTON_SPACING), CONTENT_WIDTH, BUTTON_HEIGHT);
+}
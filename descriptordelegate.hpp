@@ -0,0 +1,31 @@
+#ifndef DESCRIPTORDELEGATE_HPP
+#define DESCRIPTORDELEGATE_HPP
+
+#include <QStyledItemDelegate>
+
+// Paints a grid cell (thumbnail, info box and buttons) directly, instead of one widget tree per descriptor.
+class DescriptorDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    enum Button {
+        NoButton,
+        InfoButton,
+        DeleteButton,
+        EditButton
+    };
+
+    explicit DescriptorDelegate(bool showAdminButtons, QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+    Button buttonAt(const QRect &cellRect, const QPoint &position) const;
+
+private:
+    QRect buttonRect(const QRect &cellRect, Button button) const;
+
+    bool showAdminButtons;
+};
+
+#endif // DESCRIPTORDELEGATE_HPP
@@ -2,11 +2,20 @@
 #include "ui_descriptordetails.h"
 #include <QMessageBox>
 #include "imageproccessing.hpp"
+#include "preview.hpp"
 #include "ClickableLabel.hpp"
 #include <QFile>
 #include <QJsonArray>
+#include "libraryfile.hpp"
 #include <QJsonDocument>
 #include <QFileDialog>
+#include <QProgressDialog>
+
+// Filters of the morphology family, which all take a kernel size
+static bool isMorphologyFilter(const QString& filter) {
+    return filter == "Erosion" || filter == "Dilation" || filter == "Opening"
+           || filter == "Closing" || filter == "Morphological Gradient";
+}
 
 DescriptorDetails::DescriptorDetails(QWidget *parent , bool access,QString LibraryPath )
 
@@ -27,9 +36,19 @@ DescriptorDetails::DescriptorDetails(QWidget *parent , bool access,QString Libra
         ui->comboBox_2->addItem("Right");
         ui->comboBox_2->addItem("Down");
         ui->comboBox_2->addItem("Up");
+        ui->comboBox_2->addItem("Custom angle");
         ui->comboBox->addItem("SIFT");
         ui->comboBox->addItem("Histogram");
         ui->comboBox->addItem("Erosion");
+        ui->comboBox->addItem("Dilation");
+        ui->comboBox->addItem("Opening");
+        ui->comboBox->addItem("Closing");
+        ui->comboBox->addItem("Morphological Gradient");
+        ui->comboBox->addItem("Invert");
+        ui->comboBox->addItem("Gamma Correction");
+        ui->comboBox->addItem("Histogram Equalization");
+        ui->comboBox->addItem("Otsu Threshold");
+        ui->comboBox->addItem("CLAHE");
 
 
         ui->filtreButton->setVisible(true);
@@ -46,6 +65,15 @@ DescriptorDetails::DescriptorDetails(QWidget *parent , bool access,QString Libra
         ui->Kernelsizeinput->setVisible(false);
 
         connect(ui->comboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &DescriptorDetails::onFilterSelectionChanged);
+        // The custom angle is typed in the value field, below the rotation choice
+        connect(ui->comboBox_2, &QComboBox::currentTextChanged, this, [this](const QString& text) {
+            bool custom = ui->comboBox_2->isVisible() && text == "Custom angle";
+            ui->thresholdLabel->setText("Angle:");
+            ui->thresholdLabel->setVisible(custom);
+            ui->thresholdInput->setVisible(custom);
+            ui->thresholdInput->setPlaceholderText(custom ? "Angle (degrees)" : QString());
+        });
+        connect(ui->stackFilters, &QCheckBox::toggled, this, &DescriptorDetails::onStackToggled);
         connect(ui->FilteredImageLabel, &ClickableLabel::clicked, this, [this]() {onLabelClicked(ui->FilteredImageLabel);});
         connect(ui->ImageLabel, &ClickableLabel::clicked, this, [this]() {onLabelClicked(ui->ImageLabel);});
         
@@ -80,15 +108,17 @@ void DescriptorDetails::setDescriptor(Descriptor* descriptor) {
     // ui->accessLabel->setText(QString(descriptor->getAccess()));
     QString appPath = QCoreApplication::applicationDirPath();
 
-    // Load the image directly from the file path
-    QPixmap pixmap(appPath + descriptor->getImage().getPath());
-    if (pixmap.isNull()) {
+    // Decode the image at the label size only (reduced resolution level for JPEG 2000)
+    Mat preview = loadPreview((appPath + descriptor->getImage().getPath()).toStdString(),
+                              Size(ui->ImageLabel->width(), ui->ImageLabel->height()));
+    if (preview.empty()) {
         QMessageBox::warning(this, "Error", "Failed to load the image. Check the file path or format.");
         return;
     }
 
-    ui->ImageLabel->setPixmap(pixmap.scaled(ui->ImageLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    ui->ImageLabel->setPixmap(descriptor->cvMatToQPixmap(preview));
     ui->ImageLabel->setAlignment(Qt::AlignCenter);
+ pipeline.clear();
  if(access){
     // Clear the filtered image label
     ui->FilteredImageLabel->clear();
@@ -99,8 +129,9 @@ void DescriptorDetails::setDescriptor(Descriptor* descriptor) {
 void DescriptorDetails::onFilterSelectionChanged(int index) {
     QString selectedFilter = ui->comboBox->itemText(index);
 
-    // Si le filtre "Seuillage" est sélectionné, afficher le champ de saisie du seuil
-    if (selectedFilter == "Seuillage") {
+    // Si le filtre "Seuillage" ou "Gamma Correction" est sélectionné, afficher le champ de saisie de la valeur
+    if (selectedFilter == "Seuillage" || selectedFilter == "Gamma Correction") {
+        ui->thresholdLabel->setText(selectedFilter == "Seuillage" ? "Threshold:" : "Gamma:");
         ui->thresholdLabel->setVisible(true);
         ui->thresholdInput->setVisible(true);
     } else {
@@ -110,11 +141,16 @@ void DescriptorDetails::onFilterSelectionChanged(int index) {
     }
     if (selectedFilter == "Rotation") {
         ui->comboBox_2->setVisible(true);
+        if (ui->comboBox_2->currentText() == "Custom angle") {
+            ui->thresholdLabel->setText("Angle:");
+            ui->thresholdLabel->setVisible(true);
+            ui->thresholdInput->setVisible(true);
+        }
     } else {
         // Cacher le champ pour tous les autres filtres
         ui->comboBox_2->setVisible(false);
     }
-    if (selectedFilter =="Erosion") {
+    if (isMorphologyFilter(selectedFilter) || selectedFilter == "Median Filter") {
         ui->Kernelsizeinput->setVisible(true);
         ui->kernelsizelabel->setVisible(true);
     } else {
@@ -126,6 +162,71 @@ void DescriptorDetails::onFilterSelectionChanged(int index) {
 }   
 
 
+void DescriptorDetails::onStackToggled(bool checked) {
+    // Start a new stack each time stacking is enabled
+    if (!checked) {
+        pipeline.clear();
+        ui->FilteredImageLabel->setToolTip(QString());
+    }
+}
+
+// Adds the selected filter to stack; returns false (after warning) if it cannot be stacked
+bool DescriptorDetails::appendToPipeline(FilterPipeline& stack, const QString& filter) {
+    int kernelSize = 3;
+    if (ui->Kernelsizeinput->isVisible() && !ui->Kernelsizeinput->text().isEmpty()) {
+        bool ok;
+        kernelSize = ui->Kernelsizeinput->text().toInt(&ok);
+        if (!ok) {
+            QMessageBox::warning(this, "Erreur", "Taille de noyau invalide.");
+            return false;
+        }
+    }
+
+    if (filter == "Gaussien Filter") {
+        stack.gaussian();
+    } else if (filter == "Median Filter") {
+        stack.median(kernelSize);
+    } else if (filter == "To GrayScale") {
+        stack.grayscale();
+    } else if (filter == "Edge Detection") {
+        stack.sobel();
+    } else if (filter == "Seuillage") {
+        bool ok;
+        int thresholdValue = ui->thresholdInput->text().toInt(&ok);
+        if (!ok) {
+            QMessageBox::warning(this, "Erreur", "Valeur de seuil invalide.");
+            return false;
+        }
+        // Same behaviour as applyThreshold, which works on the gray image
+        stack.grayscale().threshold(thresholdValue);
+    } else if (filter == "Invert") {
+        stack.invert();
+    } else if (filter == "Gamma Correction") {
+        double gamma = 1.0;
+        if (!ui->thresholdInput->text().isEmpty()) {
+            bool ok;
+            gamma = ui->thresholdInput->text().toDouble(&ok);
+            if (!ok || gamma <= 0) {
+                QMessageBox::warning(this, "Erreur", "Valeur de gamma invalide.");
+                return false;
+            }
+        }
+        stack.gamma(gamma);
+    } else if (filter == "Erosion") {
+        stack.erode(kernelSize);
+    } else if (filter == "Dilation") {
+        stack.dilate(kernelSize);
+    } else if (filter == "Opening") {
+        stack.erode(kernelSize).dilate(kernelSize);
+    } else if (filter == "Closing") {
+        stack.dilate(kernelSize).erode(kernelSize);
+    } else {
+        QMessageBox::warning(this, "Erreur", QString("Le filtre \"%1\" ne peut pas être empilé.").arg(filter));
+        return false;
+    }
+    return true;
+}
+
 void DescriptorDetails::on_filtreButton_clicked() {
     QString filter = ui->comboBox->currentText();
     QString Rotate = ui->comboBox_2->currentText();
@@ -136,7 +237,9 @@ void DescriptorDetails::on_filtreButton_clicked() {
 
     QString appPath = QCoreApplication::applicationDirPath();
     imagePath = appPath + imagePath;
-    Mat inputImage = cv::imread(imagePath.toStdString());
+    // Huge rasters are edited on their overview; the full image is only processed when saving
+    Mat inputImage = currentDescriptor->getImage().isReduced() ? currentDescriptor->getImage().getContent()
+                                                               : cv::imread(imagePath.toStdString());
 
     if (inputImage.empty()) {
         QMessageBox::warning(this, "Error", "Failed to convert QPixmap to cv::Mat.");
@@ -148,7 +251,24 @@ void DescriptorDetails::on_filtreButton_clicked() {
     try {
         Mat outputImage;
 
-        if (filter == "Gaussien Filter") {
+        if (ui->stackFilters->isChecked()) {
+            // Run the whole stack on the original image in one fused pass, and show per-stage timings
+            // The stage is only kept once the stack has run with it, so a failing filter is not left stacked
+            FilterPipeline stacked = pipeline;
+            if (!appendToPipeline(stacked, filter)) {
+                return;
+            }
+            vector<StageTiming> timings;
+            outputImage = processor.applyPipeline(inputImage, stacked, &timings);
+            pipeline = stacked;
+
+            QStringList lines;
+            for (const StageTiming& timing : timings) {
+                lines << QString("%1: %2 ms").arg(QString::fromStdString(timing.name)).arg(timing.milliseconds, 0, 'f', 2);
+            }
+            ui->FilteredImageLabel->setToolTip(lines.join("\n"));
+
+        } else if (filter == "Gaussien Filter") {
             // // Apply Gaussian filter with 5x5 kernel and sigma = 1.0
             outputImage = processor.applyGaussianFilter(inputImage);
             // imwrite(outputImage,"test.jpg")
@@ -157,8 +277,17 @@ void DescriptorDetails::on_filtreButton_clicked() {
             outputImage = processor.applyEdgeDetection(inputImage);
 
         } else if (filter == "Median Filter") {
-            // Apply Median filter with kernel size = 5
-            outputImage = processor.applyCustomMedianFilter(inputImage, 3);
+            // Apply Median filter, kernel size = 3 unless one is entered
+            int Kernelsize = 3;
+            if (ui->Kernelsizeinput->isVisible() && !ui->Kernelsizeinput->text().isEmpty()) {
+                bool ok;
+                Kernelsize = ui->Kernelsizeinput->text().toInt(&ok);
+                if (!ok) {
+                    QMessageBox::warning(this, "Erreur", "Taille de noyau invalide.");
+                    return;
+                }
+            }
+            outputImage = processor.applyCustomMedianFilter(inputImage, Kernelsize);
 
         } else if (filter == "Rotation") {
 
@@ -170,6 +299,15 @@ void DescriptorDetails::on_filtreButton_clicked() {
                 outputImage = processor.rotateImage(inputImage, 270);
             }else if(Rotate=="Right"){
                 outputImage = processor.rotateImage(inputImage, 90);
+            }else if(Rotate=="Custom angle"){
+                // Any angle (clockwise), e.g. to straighten a scan
+                bool ok;
+                double angle = ui->thresholdInput->text().toDouble(&ok);
+                if (!ok) {
+                    QMessageBox::warning(this, "Erreur", "Angle de rotation invalide.");
+                    return;
+                }
+                outputImage = processor.rotateImage(inputImage, angle, RotationInterpolation::Bicubic);
             }
 
         } else if (filter == "To GrayScale") {
@@ -177,7 +315,7 @@ void DescriptorDetails::on_filtreButton_clicked() {
             outputImage = processor.toGrayScale(inputImage);
 
         } else if (filter == "SIFT") {
-            outputImage = processor.applySIFT(inputImage);
+            outputImage = processor.applySIFT(inputImage, imagePath.toStdString());
 
         } else if (filter == "Seuillage") {   
 
@@ -192,25 +330,58 @@ void DescriptorDetails::on_filtreButton_clicked() {
             }
             outputImage = processor.applyThreshold(inputImage,thresholdValue);
 
+        } else if (filter == "Invert") {
+            outputImage = processor.applyInvert(inputImage);
+
+        } else if (filter == "Gamma Correction") {
+            // Gamma = 1 (no change) unless one is entered
+            double gamma = 1.0;
+            if (ui->thresholdInput->isVisible() && !ui->thresholdInput->text().isEmpty()) {
+                bool ok;
+                gamma = ui->thresholdInput->text().toDouble(&ok);
+                if (!ok || gamma <= 0) {
+                    QMessageBox::warning(this, "Erreur", "Valeur de gamma invalide.");
+                    return;
+                }
+            }
+            outputImage = processor.applyGammaCorrection(inputImage, gamma);
+
+        } else if (filter == "Histogram Equalization") {
+            outputImage = processor.applyHistogramEqualization(inputImage);
+
+        } else if (filter == "Otsu Threshold") {
+            outputImage = processor.applyOtsuThreshold(inputImage);
+
+        } else if (filter == "CLAHE") {
+            outputImage = processor.applyCLAHE(inputImage);
+
         } else if (filter == "Histogram") {
             // Calcul de l'histogramme
             outputImage = processor.calculateHistogram(inputImage);
 
-        } else if (filter =="Erosion") {
+        } else if (isMorphologyFilter(filter)) {
 
             int Kernelsize ; 
             if (ui->Kernelsizeinput->isVisible()) {
                 bool ok;
                 Kernelsize = ui->Kernelsizeinput->text().toInt(&ok);
                 if (!ok) {
-                    QMessageBox::warning(this, "Erreur", "Valeur de seuil invalide.");
+                    QMessageBox::warning(this, "Erreur", "Taille de noyau invalide.");
                     return;
                 }
             }
-            outputImage = processor.applyErosion(inputImage,Kernelsize);
 
-        } else if (filter =="Erosion"){ 
-            outputImage = processor.applyErosion(inputImage,25);
+            if (filter == "Erosion") {
+                outputImage = processor.applyErosion(inputImage, Kernelsize);
+            } else if (filter == "Dilation") {
+                outputImage = processor.applyDilation(inputImage, Kernelsize);
+            } else if (filter == "Opening") {
+                outputImage = processor.applyOpening(inputImage, Kernelsize);
+            } else if (filter == "Closing") {
+                outputImage = processor.applyClosing(inputImage, Kernelsize);
+            } else {
+                outputImage = processor.applyMorphologicalGradient(inputImage, Kernelsize);
+            }
 
         } else {    
             throw invalid_argument("Invalid filter selected.");
@@ -264,18 +435,13 @@ void DescriptorDetails::on_SaveChanges_clicked()
     // load the library
     qDebug() << "Library to edit";
     qDebug() << libraryPath;
-    QFile file( libraryPath);
-
-    if (!file.open(QIODevice::ReadOnly)) {
+    // Read the existing library (JSON or binary)
+    bool readOk = false;
+    QJsonObject obj = readLibraryDocument(libraryPath, &readOk);
+    if (!readOk) {
         qDebug() << "Error: Could not open file";
         return;
     }
-
-    // Read the existing JSON file
-    QByteArray data = file.readAll();
-    file.close();
-    QJsonDocument doc(QJsonDocument::fromJson(data));
-    QJsonObject obj = doc.object();
     QJsonArray array = obj["library"].toArray();
     QJsonArray newArray;
 
@@ -294,13 +460,36 @@ void DescriptorDetails::on_SaveChanges_clicked()
     }
     obj["library"] = newArray;
 
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!writeLibraryDocument(libraryPath, obj)) {
         qDebug() << "Error: Could not open file";
         return;
     }
 
-    file.write(QJsonDocument(obj).toJson());
-    file.close();
+    // The filters were previewed on an overview: run the stacked ones on the full image, tile by tile
+    if (currentDescriptor->getImage().isReduced() && ui->stackFilters->isChecked() && !pipeline.empty()) {
+        QString savePath = QFileDialog::getSaveFileName(this, "Save Filtered Image", "", "GeoTIFF (*.tif)");
+        if (savePath.isEmpty()) {
+            return;
+        }
+        if (!savePath.contains('.')) {
+            savePath.append(".tif");
+        }
+
+        QProgressDialog progress("Filtering the full-resolution image...", QString(), 0, 1, this);
+        progress.setWindowModality(Qt::WindowModal);
+        ImageProccessing processor;
+        try {
+            processor.applyPipelineTiled((appPath + currentDescriptor->getImage().getPath()).toStdString(), savePath.toStdString(),
+                                         pipeline, RASTER_TILE_SIZE, [&progress](int done, int total) {
+                                             progress.setMaximum(total);
+                                             progress.setValue(done);
+                                         });
+        } catch (const exception& e) {
+            QMessageBox::warning(this, "Erreur", QString::fromStdString(e.what()));
+        }
+        qDebug() << "Saved to path:" << savePath;
+        return;
+    }
 
     QPixmap pixmap = ui->FilteredImageLabel->pixmap(Qt::ReturnByValue);
 
@@ -330,7 +519,16 @@ void DescriptorDetails::on_SaveChanges_clicked()
 void DescriptorDetails::onLabelClicked(QLabel *clickedLabel) {
     // Vérifiez si une image est chargée dans le QLabel cliqué
     QPixmap pixmap = clickedLabel->pixmap(Qt::ReturnByValue);
-    
+
+    // L'original est relu à la taille de la fenêtre plutôt qu'agrandi depuis l'aperçu
+    if (clickedLabel == ui->ImageLabel && currentDescriptor) {
+        QString appPath = QCoreApplication::applicationDirPath();
+        Mat enlarged = loadPreview((appPath + currentDescriptor->getImage().getPath()).toStdString(), Size(800, 600));
+        if (!enlarged.empty()) {
+            pixmap = currentDescriptor->cvMatToQPixmap(enlarged);
+        }
+    }
+
     if (pixmap.isNull()) {
         QMessageBox::warning(this, "Erreur", "Aucune image à afficher.");
         return;
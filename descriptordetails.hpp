@@ -7,6 +7,7 @@
 #include <QLabel>
 
 #include "descriptor.hpp"
+#include "pipeline.hpp"
 
 namespace Ui {
 class DescriptorDetails;
@@ -29,11 +30,15 @@ private slots:
     void onFilterSelectionChanged(int index);
     void on_SaveChanges_clicked();
     void onLabelClicked(QLabel *clickedLabel); 
+    void onStackToggled(bool checked);
 
 private:
     Ui::DescriptorDetails *ui;
     Descriptor* currentDescriptor;
     QString LibraryPath;
+    FilterPipeline pipeline; // filters stacked while "Stack" is checked
+
+    bool appendToPipeline(FilterPipeline& stack, const QString& filter);
 
 };
 
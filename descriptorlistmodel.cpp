@@ -0,0 +1,188 @@
+#include "descriptorlistmodel.hpp"
+#include "preview.hpp"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTimer>
+
+namespace {
+
+// In-memory thumbnails, in KB (a 210 px thumbnail is about 130 KB)
+const int THUMBNAIL_MEMORY_KB = 64 * 1024;
+
+} // namespace
+
+DescriptorListModel::DescriptorListModel(QObject *parent)
+    : QAbstractListModel(parent),
+      appPath(QCoreApplication::applicationDirPath()),
+      loader(new ThumbnailLoader(this)),
+      thumbnails(THUMBNAIL_MEMORY_KB),
+      prioritizeScheduled(false)
+{
+    connect(loader, &ThumbnailLoader::thumbnailReady, this, &DescriptorListModel::onThumbnailReady, Qt::QueuedConnection);
+}
+
+int DescriptorListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : descriptors.size();
+}
+
+QVariant DescriptorListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= descriptors.size())
+    {
+        return QVariant();
+    }
+    const Descriptor *descriptor = descriptors[index.row()];
+
+    switch (role)
+    {
+    case Qt::DisplayRole:
+    {
+        QString text = QString("ID: %1").arg(descriptor->getIdDescriptor());
+        if (infoVisible.contains(descriptor))
+        {
+            text += QString("\nCost: %1\nTitle: %2\nSource: %3\nAccess: %4")
+                        .arg(descriptor->getCost())
+                        .arg(descriptor->getTitle())
+                        .arg(descriptor->getSource())
+                        .arg(descriptor->getAccess());
+        }
+        return text;
+    }
+    case Qt::DecorationRole:
+    {
+        const QString path = thumbnailPath(descriptor);
+        if (QPixmap *pixmap = thumbnails.object(path))
+        {
+            return *pixmap;
+        }
+        if (!missing.contains(path))
+        {
+            requestThumbnail(path);
+        }
+        return QVariant();
+    }
+    case InfoVisibleRole:
+        return infoVisible.contains(descriptor);
+    case ThumbnailStateRole:
+    {
+        const QString path = thumbnailPath(descriptor);
+        if (thumbnails.contains(path))
+        {
+            return ThumbnailReady;
+        }
+        return missing.contains(path) ? ThumbnailMissing : ThumbnailLoading;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+// Replace the displayed descriptors; thumbnails still being decoded for the previous list are cancelled.
+void DescriptorListModel::setDescriptors(const QVector<Descriptor*> &newDescriptors)
+{
+    beginResetModel();
+    loader->cancelAll();
+    pendingTickets.clear();
+    ticketPaths.clear();
+    paintedTickets.clear();
+    infoVisible.clear();
+
+    descriptors = newDescriptors;
+    rowsByPath.clear();
+    for (int row = 0; row < descriptors.size(); row++)
+    {
+        rowsByPath[thumbnailPath(descriptors[row])].append(row);
+    }
+    endResetModel();
+}
+
+Descriptor *DescriptorListModel::descriptorAt(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= descriptors.size())
+    {
+        return nullptr;
+    }
+    return descriptors[index.row()];
+}
+
+void DescriptorListModel::toggleInfo(const QModelIndex &index)
+{
+    const Descriptor *descriptor = descriptorAt(index);
+    if (descriptor == nullptr)
+    {
+        return;
+    }
+    if (!infoVisible.remove(descriptor))
+    {
+        infoVisible.insert(descriptor);
+    }
+    emit dataChanged(index, index, {Qt::DisplayRole, InfoVisibleRole});
+}
+
+// Forget the in-memory thumbnails (e.g. when another library is opened or images were modified).
+void DescriptorListModel::clearThumbnails()
+{
+    thumbnails.clear();
+    missing.clear();
+}
+
+void DescriptorListModel::onThumbnailReady(int ticket, const QImage &image)
+{
+    const QString path = ticketPaths.take(ticket);
+    if (path.isEmpty())
+    {
+        return; // The list was replaced in the meantime
+    }
+    pendingTickets.remove(path);
+    if (image.isNull())
+    {
+        qWarning() << "Failed to load image: " << path;
+        missing.insert(path);
+    }
+    else
+    {
+        const int costKB = qMax(1, static_cast<int>(image.sizeInBytes() / 1024));
+        thumbnails.insert(path, new QPixmap(QPixmap::fromImage(image)), costKB);
+    }
+    for (int row : rowsByPath.value(path))
+    {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, {Qt::DecorationRole, ThumbnailStateRole});
+    }
+}
+
+// The cells painted last are the visible ones: serve their thumbnails first.
+void DescriptorListModel::prioritizePainted()
+{
+    prioritizeScheduled = false;
+    loader->prioritize(paintedTickets);
+    paintedTickets.clear();
+}
+
+QString DescriptorListModel::thumbnailPath(const Descriptor *descriptor) const
+{
+    return appPath + descriptor->getImage().getPath();
+}
+
+void DescriptorListModel::requestThumbnail(const QString &path) const
+{
+    auto pending = pendingTickets.constFind(path);
+    int ticket;
+    if (pending != pendingTickets.constEnd())
+    {
+        ticket = pending.value();
+    }
+    else
+    {
+        ticket = loader->request(path, THUMBNAIL_SIDE);
+        pendingTickets.insert(path, ticket);
+        ticketPaths.insert(ticket, path);
+    }
+    paintedTickets.append(ticket);
+    if (!prioritizeScheduled)
+    {
+        prioritizeScheduled = true;
+        QTimer::singleShot(0, const_cast<DescriptorListModel*>(this), &DescriptorListModel::prioritizePainted);
+    }
+}
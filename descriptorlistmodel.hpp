@@ -0,0 +1,63 @@
+#ifndef DESCRIPTORLISTMODEL_HPP
+#define DESCRIPTORLISTMODEL_HPP
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QPixmap>
+#include <QSet>
+#include <QVector>
+#include "descriptor.hpp"
+#include "thumbnailloader.hpp"
+
+// Descriptors shown in the main grid. Thumbnails are requested the first time a cell is painted
+// and kept in a bounded in-memory cache, so the cost follows the viewport, not the library size.
+class DescriptorListModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles {
+        InfoVisibleRole = Qt::UserRole + 1,
+        ThumbnailStateRole
+    };
+    enum ThumbnailState {
+        ThumbnailLoading,
+        ThumbnailReady,
+        ThumbnailMissing
+    };
+
+    explicit DescriptorListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void setDescriptors(const QVector<Descriptor*> &descriptors);
+    Descriptor *descriptorAt(const QModelIndex &index) const;
+    void toggleInfo(const QModelIndex &index);
+    void clearThumbnails();
+
+private slots:
+    void onThumbnailReady(int ticket, const QImage &image);
+    void prioritizePainted();
+
+private:
+    QString thumbnailPath(const Descriptor *descriptor) const;
+    void requestThumbnail(const QString &path) const;
+
+    QVector<Descriptor*> descriptors;
+    QHash<QString, QVector<int>> rowsByPath;
+    QSet<const Descriptor*> infoVisible;
+    QString appPath;
+    ThumbnailLoader *loader;
+
+    // Filled from data(), which the view calls while painting
+    mutable QCache<QString, QPixmap> thumbnails;
+    mutable QHash<QString, int> pendingTickets;
+    mutable QHash<int, QString> ticketPaths;
+    mutable QSet<QString> missing;
+    mutable QList<int> paintedTickets;
+    mutable bool prioritizeScheduled;
+};
+
+#endif // DESCRIPTORLISTMODEL_HPP
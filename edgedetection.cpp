@@ -0,0 +1,141 @@
+#include "edgedetection.hpp"
+#include "convolution.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+/**
+ * @brief Calcule gx, gy et la magnitude d'une ligne à partir de trois lignes élargies d'un pixel nul à chaque bout.
+ *
+ * gx et gy sont produits par le moteur de convolution (SOBEL_X/SOBEL_Y déroulés à la compilation) et
+ * tiennent sur 16 bits (|g| <= 4 * 255) ; gx² + gy² est obtenu en 32 bits par un seul madd sur (gx, gy)
+ * entrelacés. La racine est calculée en float puis tronquée et saturée à 255, exactement comme
+ * l'ancienne version scalaire.
+ *
+ * Si `WithGradients` est vrai, gx et gy sont aussi écrits dans `gxRow`/`gyRow` (une ligne) pour
+ * le calcul de la direction.
+ */
+template <bool WithGradients>
+void sobelRow(const uchar* const* rows, uchar* out, int width, int16_t* gxRow, int16_t* gyRow) {
+    int x = 0;
+
+#if defined(LIBRARY_HAVE_AVX2)
+    for (; x + 16 <= width; x += 16) {
+        __m256i gx = fixedResponse16<SOBEL_X>(rows, x);
+        __m256i gy = fixedResponse16<SOBEL_Y>(rows, x);
+
+        if (WithGradients) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(gxRow + x), gx);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(gyRow + x), gy);
+        }
+
+        __m256i lo = _mm256_unpacklo_epi16(gx, gy);
+        __m256i hi = _mm256_unpackhi_epi16(gx, gy);
+        __m256i magLo = _mm256_cvttps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(lo, lo))));
+        __m256i magHi = _mm256_cvttps_epi32(_mm256_sqrt_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(hi, hi))));
+        __m256i words = _mm256_packs_epi32(magLo, magHi);
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm256_castsi256_si128(bytes));
+    }
+#endif
+
+#if defined(LIBRARY_HAVE_SSE2)
+    for (; x + 8 <= width; x += 8) {
+        __m128i gx = fixedResponse8<SOBEL_X>(rows, x);
+        __m128i gy = fixedResponse8<SOBEL_Y>(rows, x);
+
+        if (WithGradients) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(gxRow + x), gx);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(gyRow + x), gy);
+        }
+
+        __m128i lo = _mm_unpacklo_epi16(gx, gy);
+        __m128i hi = _mm_unpackhi_epi16(gx, gy);
+        __m128i magLo = _mm_cvttps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(lo, lo))));
+        __m128i magHi = _mm_cvttps_epi32(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(hi, hi))));
+        __m128i words = _mm_packs_epi32(magLo, magHi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(words, words));
+    }
+#endif
+
+    for (; x < width; x++) {
+        int gx = fixedResponse<SOBEL_X>(rows, x);
+        int gy = fixedResponse<SOBEL_Y>(rows, x);
+        if (WithGradients) {
+            gxRow[x] = static_cast<int16_t>(gx);
+            gyRow[x] = static_cast<int16_t>(gy);
+        }
+        float magnitude = sqrt(static_cast<float>(gx * gx + gy * gy));
+        out[x] = static_cast<uchar>(min(magnitude, 255.0f));
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Sobel fusionné sur les lignes [rowStart, rowEnd) : gx, gy et magnitude en une seule passe.
+ *
+ * Seules trois lignes élargies (un pixel nul de chaque côté) sont gardées en mémoire. Les pixels hors
+ * de l'image valent 0, comme dans l'ancienne convolution. `magnitude` (CV_8UC1) et, si demandé,
+ * `direction` (CV_32FC1) doivent déjà être alloués.
+ */
+void fusedSobelRows(const Mat& gray, Mat& magnitude, Mat* direction, int rowStart, int rowEnd) {
+    const int width = gray.cols;
+    ZeroPaddedRowWindow window(gray, SOBEL_X.rows, SOBEL_X.cols);
+    vector<int16_t> gx, gy;
+    if (direction) {
+        gx.resize(width);
+        gy.resize(width);
+    }
+
+    for (int y = rowStart; y < rowEnd; y++) {
+        const uchar* const* rows = window.rowsFor(y);
+        uchar* out = magnitude.ptr<uchar>(y);
+
+        if (direction) {
+            sobelRow<true>(rows, out, width, gx.data(), gy.data());
+            float* angles = direction->ptr<float>(y);
+            for (int x = 0; x < width; x++) {
+                angles[x] = fastAtan2(gy[x], gx[x]);
+            }
+        } else {
+            sobelRow<false>(rows, out, width, nullptr, nullptr);
+        }
+    }
+}
+
+/**
+ * @brief Détection des contours de Sobel en une seule passe, sans tampon intermédiaire de la taille de l'image.
+ *
+ * @param gray L'image d'entrée en niveaux de gris (CV_8UC1).
+ * @param magnitude L'image de sortie (CV_8UC1) : magnitude du gradient, tronquée et saturée à 255.
+ * @param direction Si non nul, reçoit la direction du gradient en degrés [0, 360) (CV_32FC1).
+ *
+ * @throws std::runtime_error Si l'image est vide ou n'a pas un seul canal 8 bits.
+ */
+void fusedSobel(const Mat& gray, Mat& magnitude, Mat* direction) {
+    if (gray.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (gray.type() != CV_8UC1) {
+        throw runtime_error("La détection des contours attend une image en niveaux de gris 8 bits.");
+    }
+
+    Mat output = pooledMat(gray.rows, gray.cols, CV_8UC1);
+    if (direction) {
+        direction->create(gray.size(), CV_32FC1);
+    }
+    parallelForRows(gray.rows, 1, [&](int rowStart, int rowEnd) {
+        fusedSobelRows(gray, output, direction, rowStart, rowEnd);
+    });
+    magnitude = output;
+}
@@ -0,0 +1,12 @@
+#ifndef EDGEDETECTION_HPP
+#define EDGEDETECTION_HPP
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+void fusedSobel(const Mat& gray, Mat& magnitude, Mat* direction = nullptr);
+void fusedSobelRows(const Mat& gray, Mat& magnitude, Mat* direction, int rowStart, int rowEnd);
+
+#endif // EDGEDETECTION_HPP
@@ -0,0 +1,301 @@
+#include "gaussianblur.hpp"
+#include "convolution.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cstdint>
+
+using namespace cv;
+using namespace std;
+
+// Défini dans imageproccessing.cpp (noyau gaussien 1D normalisé).
+Mat getGaussianKernel(int n, double sigma, int ktype);
+
+namespace {
+
+// La passe horizontale accumule sur 20 bits (255 << 12) puis descend sur 16 bits
+// pour que le tampon intermédiaire tienne en uint16_t.
+const int HORIZONTAL_SHIFT = 4;
+const int VERTICAL_SHIFT = 2 * GAUSSIAN_COEFF_BITS - HORIZONTAL_SHIFT;
+
+/**
+ * @brief Réflexion d'un indice hors de l'image (équivalent de BORDER_REFLECT_101).
+ */
+int reflect101(int p, int len) {
+    if (len == 1) {
+        return 0;
+    }
+    while (p < 0 || p >= len) {
+        p = p < 0 ? -p : 2 * len - 2 - p;
+    }
+    return p;
+}
+
+/**
+ * @brief Copie une ligne dans un tampon élargi de `radius` pixels de chaque côté (bords réfléchis).
+ */
+void padRow(const uchar* row, uchar* padded, int width, int cn, int radius) {
+    copy(row, row + width * cn, padded + radius * cn);
+    for (int i = 1; i <= radius; i++) {
+        const uchar* left = row + reflect101(-i, width) * cn;
+        const uchar* right = row + reflect101(width - 1 + i, width) * cn;
+        copy(left, left + cn, padded + (radius - i) * cn);
+        copy(right, right + cn, padded + (radius + width - 1 + i) * cn);
+    }
+}
+
+/**
+ * @brief Passe horizontale sur une ligne élargie, directement sur les canaux entrelacés.
+ *
+ * Le voisin k d'un élément i se trouve à i + k * cn, ce qui évite tout split/merge.
+ * Les chemins AVX2, SSE2 et scalaire effectuent exactement les mêmes opérations entières,
+ * le résultat est donc identique au bit près quel que soit le chemin exécuté.
+ *
+ * `KSize` fixe le nombre de coefficients à la compilation (boucles sur k entièrement déroulées) ;
+ * 0 correspond au chemin générique où la taille est lue dans `weights`.
+ */
+template <int KSize>
+void horizontalPass(const uchar* padded, uint16_t* out, int length, int cn, const vector<int>& weights) {
+    const int ksize = KSize > 0 ? KSize : static_cast<int>(weights.size());
+    const int32_t rounding = 1 << (HORIZONTAL_SHIFT - 1);
+    int i = 0;
+
+#if defined(LIBRARY_HAVE_AVX2)
+    const __m256i round256 = _mm256_set1_epi32(rounding);
+    for (; i + 16 <= length; i += 16) {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (int k = 0; k < ksize; k++) {
+            __m256i p = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(padded + i + k * cn)));
+            __m256i w = _mm256_set1_epi16(static_cast<short>(weights[k]));
+            __m256i lo = _mm256_mullo_epi16(p, w);
+            __m256i hi = _mm256_mulhi_epu16(p, w);
+            acc0 = _mm256_add_epi32(acc0, _mm256_unpacklo_epi16(lo, hi));
+            acc1 = _mm256_add_epi32(acc1, _mm256_unpackhi_epi16(lo, hi));
+        }
+        acc0 = _mm256_srli_epi32(_mm256_add_epi32(acc0, round256), HORIZONTAL_SHIFT);
+        acc1 = _mm256_srli_epi32(_mm256_add_epi32(acc1, round256), HORIZONTAL_SHIFT);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_packus_epi32(acc0, acc1));
+    }
+#endif
+
+#if defined(LIBRARY_HAVE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round128 = _mm_set1_epi32(rounding);
+    const __m128i bias32 = _mm_set1_epi32(32768);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (; i + 8 <= length; i += 8) {
+        __m128i acc0 = zero;
+        __m128i acc1 = zero;
+        for (int k = 0; k < ksize; k++) {
+            __m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(padded + i + k * cn)), zero);
+            __m128i w = _mm_set1_epi16(static_cast<short>(weights[k]));
+            __m128i lo = _mm_mullo_epi16(p, w);
+            __m128i hi = _mm_mulhi_epu16(p, w);
+            acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(lo, hi));
+            acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(lo, hi));
+        }
+        acc0 = _mm_srli_epi32(_mm_add_epi32(acc0, round128), HORIZONTAL_SHIFT);
+        acc1 = _mm_srli_epi32(_mm_add_epi32(acc1, round128), HORIZONTAL_SHIFT);
+        // SSE2 n'a pas de packus_epi32 : on recentre autour de 0 avant le pack signé.
+        __m128i packed = _mm_packs_epi32(_mm_sub_epi32(acc0, bias32), _mm_sub_epi32(acc1, bias32));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(packed, bias16));
+    }
+#endif
+
+    for (; i < length; i++) {
+        int32_t acc = 0;
+        for (int k = 0; k < ksize; k++) {
+            acc += weights[k] * padded[i + k * cn];
+        }
+        out[i] = static_cast<uint16_t>((acc + rounding) >> HORIZONTAL_SHIFT);
+    }
+}
+
+/**
+ * @brief Passe verticale : combine les `ksize` lignes intermédiaires en une ligne de sortie 8 bits.
+ */
+template <int KSize>
+void verticalPass(const vector<const uint16_t*>& rows, uchar* out, int length, const vector<int>& weights) {
+    const int ksize = KSize > 0 ? KSize : static_cast<int>(weights.size());
+    const int32_t rounding = 1 << (VERTICAL_SHIFT - 1);
+    int i = 0;
+
+#if defined(LIBRARY_HAVE_AVX2)
+    const __m256i round256 = _mm256_set1_epi32(rounding);
+    for (; i + 16 <= length; i += 16) {
+        __m256i acc0 = _mm256_setzero_si256();
+        __m256i acc1 = _mm256_setzero_si256();
+        for (int k = 0; k < ksize; k++) {
+            __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows[k] + i));
+            __m256i w = _mm256_set1_epi16(static_cast<short>(weights[k]));
+            __m256i lo = _mm256_mullo_epi16(h, w);
+            __m256i hi = _mm256_mulhi_epu16(h, w);
+            acc0 = _mm256_add_epi32(acc0, _mm256_unpacklo_epi16(lo, hi));
+            acc1 = _mm256_add_epi32(acc1, _mm256_unpackhi_epi16(lo, hi));
+        }
+        acc0 = _mm256_srli_epi32(_mm256_add_epi32(acc0, round256), VERTICAL_SHIFT);
+        acc1 = _mm256_srli_epi32(_mm256_add_epi32(acc1, round256), VERTICAL_SHIFT);
+        __m256i words = _mm256_packus_epi32(acc0, acc1);
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(bytes));
+    }
+#endif
+
+#if defined(LIBRARY_HAVE_SSE2)
+    const __m128i round128 = _mm_set1_epi32(rounding);
+    for (; i + 8 <= length; i += 8) {
+        __m128i acc0 = _mm_setzero_si128();
+        __m128i acc1 = _mm_setzero_si128();
+        for (int k = 0; k < ksize; k++) {
+            __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows[k] + i));
+            __m128i w = _mm_set1_epi16(static_cast<short>(weights[k]));
+            __m128i lo = _mm_mullo_epi16(h, w);
+            __m128i hi = _mm_mulhi_epu16(h, w);
+            acc0 = _mm_add_epi32(acc0, _mm_unpacklo_epi16(lo, hi));
+            acc1 = _mm_add_epi32(acc1, _mm_unpackhi_epi16(lo, hi));
+        }
+        acc0 = _mm_srli_epi32(_mm_add_epi32(acc0, round128), VERTICAL_SHIFT);
+        acc1 = _mm_srli_epi32(_mm_add_epi32(acc1, round128), VERTICAL_SHIFT);
+        __m128i words = _mm_packs_epi32(acc0, acc1);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+    }
+#endif
+
+    for (; i < length; i++) {
+        int32_t acc = 0;
+        for (int k = 0; k < ksize; k++) {
+            acc += weights[k] * rows[k][i];
+        }
+        out[i] = static_cast<uchar>((acc + rounding) >> VERTICAL_SHIFT);
+    }
+}
+
+// Corps de separableGaussianBlurRows, instancié pour chaque taille spécialisée (KSize = 0 : générique).
+template <int KSize>
+void separableGaussianBlurRowsImpl(const Mat& src, Mat& dst, const SeparableKernel& kernel, int rowStart, int rowEnd) {
+    const int width = src.cols;
+    const int cn = src.channels();
+    const int radius = kernel.radius;
+    const int ksize = 2 * radius + 1;
+    const int length = width * cn;
+
+    vector<uchar> padded((width + 2 * radius) * cn);
+    vector<uint16_t> ring(static_cast<size_t>(ksize) * length);
+    vector<const uint16_t*> rows(ksize);
+
+    // La ligne logique l (éventuellement hors de l'image) occupe l'emplacement l mod ksize.
+    auto slot = [&](int logicalRow) {
+        int index = (logicalRow - (rowStart - radius)) % ksize;
+        return ring.data() + static_cast<size_t>(index) * length;
+    };
+    auto filterRow = [&](int logicalRow) {
+        int y = reflect101(logicalRow, src.rows);
+        padRow(src.ptr<uchar>(y), padded.data(), width, cn, radius);
+        horizontalPass<KSize>(padded.data(), slot(logicalRow), length, cn, kernel.weights);
+    };
+
+    for (int l = rowStart - radius; l < rowStart + radius; l++) {
+        filterRow(l);
+    }
+
+    for (int y = rowStart; y < rowEnd; y++) {
+        filterRow(y + radius);
+        for (int k = 0; k < ksize; k++) {
+            rows[k] = slot(y - radius + k);
+        }
+        verticalPass<KSize>(rows, dst.ptr<uchar>(y), length, kernel.weights);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Construit un noyau gaussien 1D quantifié en virgule fixe.
+ *
+ * Les poids sont calculés par `getGaussianKernel`, arrondis sur GAUSSIAN_COEFF_BITS bits,
+ * puis l'erreur d'arrondi est reportée sur le coefficient central pour que la somme soit exacte
+ * (une image uniforme reste donc inchangée).
+ *
+ * @param kernelSize La taille du noyau (impaire). Si elle est <= 0, elle est déduite de `sigma`.
+ * @param sigma L'écart-type. Si <= 0, il est déduit de `kernelSize`.
+ *
+ * @throws std::invalid_argument Si aucune taille valide ne peut être déterminée.
+ */
+SeparableKernel makeFixedPointGaussianKernel(int kernelSize, double sigma) {
+    if (kernelSize <= 0 && sigma > 0) {
+        kernelSize = cvRound(sigma * 3 * 2 + 1) | 1;
+    }
+    if (kernelSize <= 0 || kernelSize % 2 == 0) {
+        throw invalid_argument("La taille du noyau gaussien doit être un entier positif impair.");
+    }
+
+    Mat kernel = ::getGaussianKernel(kernelSize, sigma, CV_64F);
+    const double* coeffs = kernel.ptr<double>();
+
+    SeparableKernel result;
+    result.radius = kernelSize / 2;
+    result.weights.resize(kernelSize);
+
+    const int one = 1 << GAUSSIAN_COEFF_BITS;
+    int sum = 0;
+    for (int i = 0; i < kernelSize; i++) {
+        result.weights[i] = cvRound(coeffs[i] * one);
+        sum += result.weights[i];
+    }
+    result.weights[result.radius] += one - sum;
+
+    return result;
+}
+
+/**
+ * @brief Applique le flou gaussien séparable sur les lignes [rowStart, rowEnd) de l'image de sortie.
+ *
+ * Chaque ligne source n'est filtrée horizontalement qu'une seule fois : les résultats sont conservés
+ * dans un tampon circulaire de `2 * radius + 1` lignes, puis combinés par la passe verticale.
+ * La sortie `dst` doit déjà être allouée (même taille et même type que `src`). Les tailles de noyau
+ * courantes (3, 5, 7) utilisent des passes spécialisées à la compilation.
+ *
+ * @param src L'image d'entrée 8 bits (1 à 4 canaux entrelacés).
+ * @param dst L'image de sortie.
+ * @param kernel Le noyau en virgule fixe.
+ * @param rowStart Première ligne à produire.
+ * @param rowEnd Ligne de fin (exclue).
+ */
+void separableGaussianBlurRows(const Mat& src, Mat& dst, const SeparableKernel& kernel, int rowStart, int rowEnd) {
+    dispatchKernelSize<3, 5, 7>(2 * kernel.radius + 1, [&](auto size) {
+        separableGaussianBlurRowsImpl<decltype(size)::value>(src, dst, kernel, rowStart, rowEnd);
+    });
+}
+
+/**
+ * @brief Flou gaussien séparable sur une image 8 bits à canaux entrelacés.
+ *
+ * Remplace le parcours 2D (split, `at<>` par échantillon, `normalize`) par deux passes 1D en
+ * virgule fixe avec des chemins SSE2/AVX2. Les bandes de lignes sont réparties sur le pool de threads ;
+ * le résultat est reproductible au bit près quel que soit le nombre de threads.
+ *
+ * @param src L'image d'entrée (CV_8U, 1 à 4 canaux).
+ * @param dst L'image de sortie, de même taille et de même type.
+ * @param kernelSize La taille du noyau (impaire, ou <= 0 pour la déduire de `sigma`).
+ * @param sigma L'écart-type (ou <= 0 pour le déduire de `kernelSize`).
+ *
+ * @throws std::runtime_error Si l'image d'entrée est vide ou n'est pas en 8 bits.
+ */
+void separableGaussianBlur(const Mat& src, Mat& dst, int kernelSize, double sigma) {
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.depth() != CV_8U) {
+        throw runtime_error("Le flou gaussien séparable n'accepte que des images 8 bits.");
+    }
+
+    SeparableKernel kernel = makeFixedPointGaussianKernel(kernelSize, sigma);
+
+    Mat output = pooledMat(src.rows, src.cols, src.type());
+    parallelForRows(src.rows, kernel.radius, [&](int rowStart, int rowEnd) {
+        separableGaussianBlurRows(src, output, kernel, rowStart, rowEnd);
+    });
+    dst = output;
+}
@@ -0,0 +1,24 @@
+#ifndef GAUSSIANBLUR_HPP
+#define GAUSSIANBLUR_HPP
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// Nombre de bits des coefficients en virgule fixe : leur somme vaut 1 << GAUSSIAN_COEFF_BITS.
+const int GAUSSIAN_COEFF_BITS = 12;
+
+// Noyau gaussien 1D en virgule fixe, utilisé pour les passes horizontale et verticale.
+struct SeparableKernel {
+    vector<int> weights;
+    int radius;
+};
+
+SeparableKernel makeFixedPointGaussianKernel(int kernelSize, double sigma);
+
+void separableGaussianBlur(const Mat& src, Mat& dst, int kernelSize, double sigma);
+void separableGaussianBlurRows(const Mat& src, Mat& dst, const SeparableKernel& kernel, int rowStart, int rowEnd);
+
+#endif // GAUSSIANBLUR_HPP
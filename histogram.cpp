@@ -0,0 +1,391 @@
+#include "histogram.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+// Nombre de sous-histogrammes entrelacés : deux échantillons consécutifs égaux n'incrémentent pas
+// le même compteur, ce qui évite d'attendre l'écriture précédente (conflit store-to-load).
+const int SUB_HISTOGRAMS = 4;
+
+// Les sous-histogrammes sont en 32 bits : ils sont reversés dans les totaux avant de pouvoir déborder.
+const uint64_t FLUSH_SAMPLES = 1u << 30;
+
+/**
+ * @brief Compte les échantillons des lignes [rowStart, rowEnd) de `src` et les ajoute à `totals` (cn * 256).
+ */
+void countRows(const Mat& src, int rowStart, int rowEnd, vector<uint64_t>& totals) {
+    const int cn = src.channels();
+    const int width = src.cols;
+    const size_t tableSize = static_cast<size_t>(cn) * HISTOGRAM_BINS;
+
+    vector<uint32_t> sub(SUB_HISTOGRAMS * tableSize, 0);
+    uint32_t* s0 = sub.data();
+    uint32_t* s1 = s0 + tableSize;
+    uint32_t* s2 = s1 + tableSize;
+    uint32_t* s3 = s2 + tableSize;
+
+    auto flush = [&]() {
+        for (size_t i = 0; i < tableSize; i++) {
+            totals[i] += static_cast<uint64_t>(s0[i]) + s1[i] + s2[i] + s3[i];
+        }
+        fill(sub.begin(), sub.end(), 0);
+    };
+
+    uint64_t pending = 0;
+    for (int y = rowStart; y < rowEnd; y++) {
+        const uchar* row = src.ptr<uchar>(y);
+        int x = 0;
+        for (; x + SUB_HISTOGRAMS <= width; x += SUB_HISTOGRAMS) {
+            const uchar* p = row + x * cn;
+            for (int c = 0; c < cn; c++) {
+                const int offset = c * HISTOGRAM_BINS;
+                s0[offset + p[c]]++;
+                s1[offset + p[cn + c]]++;
+                s2[offset + p[2 * cn + c]]++;
+                s3[offset + p[3 * cn + c]]++;
+            }
+        }
+        for (; x < width; x++) {
+            for (int c = 0; c < cn; c++) {
+                s0[c * HISTOGRAM_BINS + row[x * cn + c]]++;
+            }
+        }
+
+        pending += width;
+        if (pending >= FLUSH_SAMPLES) {
+            flush();
+            pending = 0;
+        }
+    }
+    flush();
+}
+
+void checkGray(const Mat& gray) {
+    if (gray.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (gray.type() != CV_8UC1) {
+        throw runtime_error("Cette opération attend une image en niveaux de gris 8 bits.");
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Ajoute à `histogram` les comptes des lignes [rowStart, rowEnd) de `src` (sans parallélisme).
+ *
+ * Utilisé pour les histogrammes de sous-régions (tuiles de CLAHE) ; `histogram` est initialisé
+ * au nombre de canaux de `src` s'il est vide.
+ */
+void accumulateHistogram(const Mat& src, int rowStart, int rowEnd, Histogram& histogram) {
+    const int cn = src.channels();
+    if (histogram.counts.empty()) {
+        histogram.counts.assign(cn, ChannelHistogram{});
+    }
+
+    vector<uint64_t> totals(static_cast<size_t>(cn) * HISTOGRAM_BINS, 0);
+    countRows(src, rowStart, rowEnd, totals);
+    for (int c = 0; c < cn; c++) {
+        for (int v = 0; v < HISTOGRAM_BINS; v++) {
+            histogram.counts[c][v] += totals[c * HISTOGRAM_BINS + v];
+        }
+    }
+    histogram.pixels += static_cast<uint64_t>(rowEnd - rowStart) * src.cols;
+}
+
+/**
+ * @brief Calcule l'histogramme de chaque canal d'une image 8 bits.
+ *
+ * Les bandes de lignes sont comptées en parallèle, chacune dans ses propres sous-histogrammes,
+ * puis fusionnées : aucun compteur n'est partagé entre threads pendant le parcours.
+ *
+ * @param src L'image d'entrée (CV_8U, 1 à 4 canaux).
+ * @return Les comptes par canal.
+ *
+ * @throws std::runtime_error Si l'image est vide ou n'est pas en 8 bits.
+ */
+Histogram computeHistogram(const Mat& src) {
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.depth() != CV_8U) {
+        throw runtime_error("L'histogramme n'accepte que des images 8 bits.");
+    }
+
+    Histogram histogram;
+    histogram.counts.assign(src.channels(), ChannelHistogram{});
+    histogram.pixels = static_cast<uint64_t>(src.rows) * src.cols;
+
+    const int cn = src.channels();
+    mutex mergeMutex;
+    parallelForRows(src.rows, 0, [&](int rowStart, int rowEnd) {
+        vector<uint64_t> totals(static_cast<size_t>(cn) * HISTOGRAM_BINS, 0);
+        countRows(src, rowStart, rowEnd, totals);
+
+        lock_guard<mutex> lock(mergeMutex);
+        for (int c = 0; c < cn; c++) {
+            for (int v = 0; v < HISTOGRAM_BINS; v++) {
+                histogram.counts[c][v] += totals[c * HISTOGRAM_BINS + v];
+            }
+        }
+    });
+
+    return histogram;
+}
+
+/**
+ * @brief Dessine l'histogramme (barres pour une image en niveaux de gris, une courbe par canal sinon).
+ *
+ * @param histogram Les comptes à dessiner.
+ * @return Mat Le graphique (CV_8UC3, fond blanc), ou une image vide si l'histogramme est vide.
+ */
+Mat renderHistogram(const Histogram& histogram) {
+    uint64_t maxVal = 0;
+    for (const ChannelHistogram& counts : histogram.counts) {
+        maxVal = max(maxVal, *max_element(counts.begin(), counts.end()));
+    }
+
+    if (maxVal == 0) {
+        return Mat(); // Retourner une image vide en cas de problème
+    }
+
+    int histWidth = 512, histHeight = 400;
+    Mat histImage(histHeight + 50, histWidth + 50, CV_8UC3, Scalar(255, 255, 255)); // Fond blanc
+
+    // Normalisation pour que les valeurs soient entre 0 et histHeight
+    auto barHeight = [&](uint64_t count) {
+        return static_cast<int>(static_cast<double>(count) / maxVal * histHeight);
+    };
+
+    int binWidth = cvRound((double)histWidth / HISTOGRAM_BINS);
+    if (histogram.channels() == 1) {
+        Scalar barColor = Scalar(50, 50, 150); // Bleu foncé pour les barres
+        for (int i = 0; i < HISTOGRAM_BINS; i++) {
+            rectangle(histImage,
+                      Point(25 + binWidth * i, histHeight + 25),
+                      Point(25 + binWidth * (i + 1), histHeight + 25 - barHeight(histogram.counts[0][i])),
+                      barColor, FILLED);
+        }
+    } else {
+        const Scalar channelColors[] = {Scalar(255, 0, 0), Scalar(0, 160, 0), Scalar(0, 0, 255), Scalar(128, 128, 128)};
+        for (int c = 0; c < histogram.channels(); c++) {
+            for (int i = 1; i < HISTOGRAM_BINS; i++) {
+                line(histImage,
+                     Point(25 + binWidth * (i - 1), histHeight + 25 - barHeight(histogram.counts[c][i - 1])),
+                     Point(25 + binWidth * i, histHeight + 25 - barHeight(histogram.counts[c][i])),
+                     channelColors[min(c, 3)], 2);
+            }
+        }
+    }
+
+    // Ajouter les axes
+    line(histImage, Point(25, 25), Point(25, histHeight + 25), Scalar(0, 0, 0), 2); // Axe vertical
+    line(histImage, Point(25, histHeight + 25), Point(histWidth + 25, histHeight + 25), Scalar(0, 0, 0), 2); // Axe horizontal
+
+    // Ajouter des annotations pour les axes
+    putText(histImage, "Intensite", Point(histWidth / 2, histHeight + 45), FONT_HERSHEY_SIMPLEX, 0.6, Scalar(0, 0, 0), 1);
+    putText(histImage, "0", Point(20, histHeight + 30), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 0, 0), 1);
+    putText(histImage, "255", Point(histWidth, histHeight + 30), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 0, 0), 1);
+
+    // Ajouter des valeurs sur l'axe des ordonnées (0, max/2, max)
+    putText(histImage, "0", Point(5, histHeight + 25), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 0, 0), 1);
+    putText(histImage, to_string(maxVal / 2), Point(5, (histHeight + 25) / 2), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 0, 0), 1);
+    putText(histImage, to_string(maxVal), Point(5, 25), FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 0, 0), 1);
+
+    return histImage;
+}
+
+/**
+ * @brief Table d'égalisation d'histogramme : la fonction de répartition étirée sur [0, 255].
+ *
+ * La première valeur présente est envoyée sur 0 ; une image uniforme reste inchangée.
+ */
+PointOperation equalizationOperation(const ChannelHistogram& counts, uint64_t pixels) {
+    uint64_t cdfMin = 0;
+    for (int v = 0; v < HISTOGRAM_BINS && cdfMin == 0; v++) {
+        cdfMin = counts[v];
+    }
+    if (pixels <= cdfMin) {
+        return PointOperation();
+    }
+
+    array<uchar, 256> table;
+    uint64_t cdf = 0;
+    const double scale = 255.0 / static_cast<double>(pixels - cdfMin);
+    for (int v = 0; v < HISTOGRAM_BINS; v++) {
+        cdf += counts[v];
+        table[v] = cdf < cdfMin ? 0 : static_cast<uchar>(lround((cdf - cdfMin) * scale));
+    }
+    return PointOperation::fromTable(table);
+}
+
+/**
+ * @brief Seuil d'Otsu : la valeur t qui maximise la variance inter-classes entre [0, t] et ]t, 255].
+ *
+ * Le seuil s'utilise comme `PointOperation::threshold(t)` (pixels > t en blanc).
+ */
+int otsuThreshold(const ChannelHistogram& counts, uint64_t pixels) {
+    double sumAll = 0;
+    for (int v = 0; v < HISTOGRAM_BINS; v++) {
+        sumAll += static_cast<double>(v) * counts[v];
+    }
+
+    double sumBackground = 0;
+    uint64_t weightBackground = 0;
+    double bestVariance = -1;
+    int threshold = 0;
+    for (int v = 0; v < HISTOGRAM_BINS; v++) {
+        weightBackground += counts[v];
+        if (weightBackground == 0) {
+            continue;
+        }
+        uint64_t weightForeground = pixels - weightBackground;
+        if (weightForeground == 0) {
+            break;
+        }
+        sumBackground += static_cast<double>(v) * counts[v];
+        double meanBackground = sumBackground / weightBackground;
+        double meanForeground = (sumAll - sumBackground) / weightForeground;
+        double delta = meanBackground - meanForeground;
+        double variance = static_cast<double>(weightBackground) * weightForeground * delta * delta;
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            threshold = v;
+        }
+    }
+    return threshold;
+}
+
+/**
+ * @brief Égalisation d'histogramme d'une image en niveaux de gris (un comptage, puis une table).
+ *
+ * @throws std::runtime_error Si l'image est vide ou n'est pas en niveaux de gris 8 bits.
+ */
+void equalizeHistogram(const Mat& gray, Mat& dst) {
+    checkGray(gray);
+    Histogram histogram = computeHistogram(gray);
+    applyPointOperation(gray, dst, equalizationOperation(histogram.counts[0], histogram.pixels));
+}
+
+/**
+ * @brief Seuillage d'Otsu d'une image en niveaux de gris.
+ *
+ * @param thresholdValue Si non nul, reçoit le seuil choisi.
+ *
+ * @throws std::runtime_error Si l'image est vide ou n'est pas en niveaux de gris 8 bits.
+ */
+void otsuThresholdImage(const Mat& gray, Mat& dst, int* thresholdValue) {
+    checkGray(gray);
+    Histogram histogram = computeHistogram(gray);
+    int threshold = otsuThreshold(histogram.counts[0], histogram.pixels);
+    if (thresholdValue) {
+        *thresholdValue = threshold;
+    }
+    applyPointOperation(gray, dst, PointOperation::threshold(threshold));
+}
+
+/**
+ * @brief Égalisation adaptative à contraste limité (CLAHE).
+ *
+ * L'image est découpée en tileGridSize x tileGridSize tuiles. L'histogramme de chaque tuile est écrêté
+ * à clipLimit fois la hauteur moyenne d'une case, l'excédent étant redistribué uniformément, puis
+ * transformé en table d'égalisation. Chaque pixel interpole bilinéairement les tables des quatre tuiles
+ * dont les centres l'entourent. Tuiles et bandes de lignes sont traitées en parallèle.
+ *
+ * @param gray L'image d'entrée (CV_8UC1).
+ * @param dst L'image de sortie (CV_8UC1).
+ * @param clipLimit La limite d'écrêtage (<= 0 : pas d'écrêtage).
+ * @param tileGridSize Le nombre de tuiles par côté.
+ *
+ * @throws std::invalid_argument Si tileGridSize < 1.
+ * @throws std::runtime_error Si l'image est vide ou n'est pas en niveaux de gris 8 bits.
+ */
+void claheFilter(const Mat& gray, Mat& dst, double clipLimit, int tileGridSize) {
+    if (tileGridSize < 1) {
+        throw invalid_argument("La grille de tuiles doit contenir au moins une tuile.");
+    }
+    checkGray(gray);
+
+    const int tilesX = min(tileGridSize, gray.cols);
+    const int tilesY = min(tileGridSize, gray.rows);
+    vector<array<uchar, 256>> luts(static_cast<size_t>(tilesX) * tilesY);
+
+    ThreadPool::instance().parallelFor(tilesX * tilesY, [&](int tile) {
+        const int tx = tile % tilesX;
+        const int ty = tile / tilesX;
+        const int x0 = tx * gray.cols / tilesX, x1 = (tx + 1) * gray.cols / tilesX;
+        const int y0 = ty * gray.rows / tilesY, y1 = (ty + 1) * gray.rows / tilesY;
+
+        Histogram histogram;
+        Mat region = gray(Rect(x0, y0, x1 - x0, y1 - y0));
+        accumulateHistogram(region, 0, region.rows, histogram);
+        ChannelHistogram& counts = histogram.counts[0];
+        const uint64_t area = histogram.pixels;
+
+        if (clipLimit > 0) {
+            const uint64_t limit = max<uint64_t>(1, static_cast<uint64_t>(clipLimit * area / HISTOGRAM_BINS));
+            uint64_t excess = 0;
+            for (uint64_t& count : counts) {
+                if (count > limit) {
+                    excess += count - limit;
+                    count = limit;
+                }
+            }
+            const uint64_t spread = excess / HISTOGRAM_BINS;
+            const uint64_t residual = excess % HISTOGRAM_BINS;
+            for (int v = 0; v < HISTOGRAM_BINS; v++) {
+                counts[v] += spread + (static_cast<uint64_t>(v) < residual ? 1 : 0);
+            }
+        }
+
+        uint64_t cdf = 0;
+        const double scale = 255.0 / static_cast<double>(area);
+        for (int v = 0; v < HISTOGRAM_BINS; v++) {
+            cdf += counts[v];
+            luts[tile][v] = static_cast<uchar>(min<long>(255, lround(cdf * scale)));
+        }
+    });
+
+    // Position de chaque colonne entre les centres de deux tuiles voisines
+    const double tileWidth = static_cast<double>(gray.cols) / tilesX;
+    const double tileHeight = static_cast<double>(gray.rows) / tilesY;
+    vector<int> left(gray.cols), right(gray.cols);
+    vector<float> weightX(gray.cols);
+    for (int x = 0; x < gray.cols; x++) {
+        double fx = (x + 0.5) / tileWidth - 0.5;
+        int t = static_cast<int>(floor(fx));
+        weightX[x] = static_cast<float>(fx - t);
+        left[x] = max(t, 0);
+        right[x] = min(t + 1, tilesX - 1);
+    }
+
+    Mat output = pooledMat(gray.rows, gray.cols, CV_8UC1);
+    parallelForRows(gray.rows, 0, [&](int rowStart, int rowEnd) {
+        for (int y = rowStart; y < rowEnd; y++) {
+            double fy = (y + 0.5) / tileHeight - 0.5;
+            int t = static_cast<int>(floor(fy));
+            const float weightY = static_cast<float>(fy - t);
+            const int top = max(t, 0) * tilesX;
+            const int bottom = min(t + 1, tilesY - 1) * tilesX;
+
+            const uchar* in = gray.ptr<uchar>(y);
+            uchar* out = output.ptr<uchar>(y);
+            for (int x = 0; x < gray.cols; x++) {
+                const uchar v = in[x];
+                const float ax = weightX[x];
+                float upper = (1 - ax) * luts[top + left[x]][v] + ax * luts[top + right[x]][v];
+                float lower = (1 - ax) * luts[bottom + left[x]][v] + ax * luts[bottom + right[x]][v];
+                out[x] = static_cast<uchar>((1 - weightY) * upper + weightY * lower + 0.5f);
+            }
+        }
+    });
+    dst = output;
+}
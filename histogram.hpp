@@ -0,0 +1,35 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "pointoperation.hpp"
+
+using namespace cv;
+using namespace std;
+
+const int HISTOGRAM_BINS = 256;
+
+using ChannelHistogram = array<uint64_t, HISTOGRAM_BINS>;
+
+// Comptes par canal d'une image 8 bits : counts[c][v] = nombre d'échantillons du canal c valant v.
+struct Histogram {
+    vector<ChannelHistogram> counts;
+    uint64_t pixels = 0;   // nombre de pixels (identique pour chaque canal)
+
+    int channels() const { return static_cast<int>(counts.size()); }
+};
+
+Histogram computeHistogram(const Mat& src);
+void accumulateHistogram(const Mat& src, int rowStart, int rowEnd, Histogram& histogram);
+Mat renderHistogram(const Histogram& histogram);
+
+PointOperation equalizationOperation(const ChannelHistogram& counts, uint64_t pixels);
+int otsuThreshold(const ChannelHistogram& counts, uint64_t pixels);
+void equalizeHistogram(const Mat& gray, Mat& dst);
+void otsuThresholdImage(const Mat& gray, Mat& dst, int* thresholdValue = nullptr);
+void claheFilter(const Mat& gray, Mat& dst, double clipLimit, int tileGridSize);
+
+#endif // HISTOGRAM_HPP
@@ -5,11 +5,51 @@
 #include <fstream>
 #include <QDebug>
 #include <QCoreApplication>
+#include "imagecache.hpp"
+#include "imageprobe.hpp"
+#include "siftcache.hpp"
+#include "tiledraster.hpp"
 
 using namespace std; 
 using namespace cv; 
 
-// Constructeur de la classe Image : initialise une image à partir d'un chemin donné.
+// Ramène un aperçu lu par GDAL au format d'imread(IMREAD_COLOR) : 8 bits, BGR.
+
+static Mat toDisplayable(const Mat& raster) {
+    Mat eightBits;
+    if (raster.depth() == CV_8U) {
+        eightBits = raster;
+    } else if (raster.depth() == CV_16U) {
+        raster.convertTo(eightBits, CV_8U, 1.0 / 256);
+    } else {
+        normalize(raster, eightBits, 0, 255, NORM_MINMAX, CV_8U);
+    }
+
+    Mat color;
+    if (eightBits.channels() == 1) {
+        cvtColor(eightBits, color, COLOR_GRAY2BGR);
+    } else if (eightBits.channels() == 4) {
+        cvtColor(eightBits, color, COLOR_BGRA2BGR);
+    } else {
+        color = eightBits;
+    }
+    return color;
+}
+
+// Décode une image au format d'imread(IMREAD_COLOR) ; les très grands rasters sont lus en aperçu réduit par GDAL.
+
+static Mat decodeImage(const string& imgPath, bool overview) {
+    if (overview) {
+        try {
+            return toDisplayable(TiledRaster(imgPath).readOverview(IMAGE_OVERVIEW_SIDE));
+        } catch (const exception& e) {
+            cerr << "Error while reading the overview of " << imgPath << ": " << e.what() << endl;
+        }
+    }
+    return imread(imgPath, IMREAD_COLOR);
+}
+
+// Constructeur de la classe Image : initialise une image à partir d'un chemin donné, sans décoder ses pixels.
 
 Image::Image(const QString& imgPath) {
     if (imgPath.isEmpty()) {
@@ -19,48 +59,131 @@ Image::Image(const QString& imgPath) {
     QString appPath = QCoreApplication::applicationDirPath();
 
     this->path = imgPath;
-    qDebug() << "Loading image:" << imgPath;
-    loadImage(appPath+imgPath);
+    loadMetadata(appPath+imgPath);
 }
 
-// Charge une image depuis un chemin donné et initialise ses propriétés.
-
-void Image::loadImage(const QString& imgPath) {
-    Mat image = imread(imgPath.toStdString(), IMREAD_COLOR);
-    this->content = image;
+// Constructeur à partir des métadonnées enregistrées dans la bibliothèque : le fichier n'est relu que s'il a changé.
 
-    if (image.empty()) {
-        cerr << "Error while loading the image: " << imgPath.toStdString() << endl;
-        exit(1);
+Image::Image(const QString& imgPath, const QJsonObject& metadata) {
+    if (imgPath.isEmpty()) {
+        qDebug() << "Error: Image path is empty.";
+        return;
     }
+    QString appPath = QCoreApplication::applicationDirPath();
 
-    int dot = imgPath.lastIndexOf('.');
-    if (dot != -1) {
-        this->format = imgPath.mid(dot + 1);
+    this->path = imgPath;
+    if (!restoreMetadata(appPath+imgPath, metadata)) {
+        loadMetadata(appPath+imgPath);
     }
-        // Calcule le ratio de compression de l'image.
+}
 
+// Lit les caractéristiques de l'image dans l'en-tête du fichier et en déduit le mode de lecture, le format et le ratio de compression.
+
+void Image::loadMetadata(const QString& imgPath) {
+    fileStamp(imgPath.toStdString(), this->fileSize, this->modified);
+    ImageInfo info;
+    if (probeImage(imgPath.toStdString(), info)) {
+        this->width = info.width;
+        this->height = info.height;
+        this->channels = info.channels;
+        this->bitDepth = info.bitDepth;
+        this->format = QString::fromStdString(info.format);
+    } else {
+        // Format sans sonde : dimensions lues par GDAL, ou à défaut par le décodage (gardé dans le cache pour la suite).
+        if (!rasterDimensions(imgPath.toStdString(), this->width, this->height, this->channels)) {
+            Mat content = getContent();
+            this->width = content.cols;
+            this->height = content.rows;
+            this->channels = content.channels();
+        }
+        this->bitDepth = 8;
+        int dot = imgPath.lastIndexOf('.');
+        if (dot != -1) {
+            this->format = imgPath.mid(dot + 1);
+        }
+    }
+    this->reduced = static_cast<long long>(this->width) * this->height > IMAGE_FULL_DECODE_PIXELS;
     this->compressionRatio = calculateCompressionRatio(imgPath);
 }
 
-// Retourne le contenu de l'image sous forme d'un objet OpenCV Mat.
+// Reprend les métadonnées enregistrées si la taille et la date du fichier n'ont pas changé depuis ; seul un stat est fait.
+
+bool Image::restoreMetadata(const QString& imgPath, const QJsonObject& metadata) {
+    uint64_t size = 0;
+    int64_t time = 0;
+    if (metadata.isEmpty() || !fileStamp(imgPath.toStdString(), size, time)) {
+        return false;
+    }
+    // La date (en ticks de l'horloge des fichiers) dépasse la précision d'un nombre JSON : elle est gardée en texte.
+    if (static_cast<uint64_t>(metadata["fileSize"].toDouble()) != size
+        || metadata["modified"].toString().toLongLong() != time) {
+        return false;
+    }
+    const int storedWidth = metadata["width"].toInt();
+    const int storedHeight = metadata["height"].toInt();
+    if (storedWidth <= 0 || storedHeight <= 0) {
+        return false;
+    }
+
+    this->format = metadata["format"].toString();
+    this->width = storedWidth;
+    this->height = storedHeight;
+    this->channels = metadata["channels"].toInt();
+    this->bitDepth = metadata["bitDepth"].toInt();
+    this->compressionRatio = metadata["compressionRatio"].toDouble();
+    this->fileSize = size;
+    this->modified = time;
+    this->reduced = static_cast<long long>(this->width) * this->height > IMAGE_FULL_DECODE_PIXELS;
+    return true;
+}
+
+// Métadonnées à enregistrer dans la bibliothèque avec le chemin de l'image.
+
+QJsonObject Image::metadataToJson() const {
+    QJsonObject metadata;
+    metadata["format"] = this->format;
+    metadata["width"] = this->width;
+    metadata["height"] = this->height;
+    metadata["channels"] = this->channels;
+    metadata["bitDepth"] = this->bitDepth;
+    metadata["compressionRatio"] = this->compressionRatio;
+    metadata["fileSize"] = static_cast<double>(this->fileSize);
+    metadata["modified"] = QString::number(this->modified);
+    return metadata;
+}
+
+// Retourne le contenu de l'image sous forme d'un objet OpenCV Mat, décodé à la première demande.
 
 Mat Image::getContent() const {
-    return this->content;
+    if (this->path.isEmpty()) {
+        return Mat();
+    }
+    const string imgPath = (QCoreApplication::applicationDirPath() + this->path).toStdString();
+
+    // La clé inclut la taille et la date du fichier : une image remplacée sur le disque est décodée à nouveau.
+    uint64_t size = 0;
+    int64_t time = 0;
+    fileStamp(imgPath, size, time);
+    const string key = imgPath + '|' + to_string(size) + '|' + to_string(time);
+
+    const bool overview = this->reduced;
+    Mat content = ImageCache::instance().get(key, [&]() { return decodeImage(imgPath, overview); });
+    if (content.empty()) {
+        cerr << "Error while loading the image: " << imgPath << endl;
+    }
+    return content;
 }
 
 // Calcule le ratio de compression de l'image (taille compressée / taille non compressée).
 
 double Image::calculateCompressionRatio(const QString& imgPath) const {
-    Mat image = cv::imread(imgPath.toStdString(), IMREAD_COLOR);
-
-    if (image.empty()) {
+    if (this->width <= 0 || this->height <= 0 || this->channels <= 0 || this->bitDepth <= 0) {
         cerr << "Error reading the image!" << endl;
         return 0.0;
     }
-    // Taille non compressée basée sur les dimensions et les canaux.
+    // Taille non compressée d'après l'en-tête : dimensions, canaux et bits par canal.
 
-    size_t uncompressedSize = image.rows * image.cols * image.channels();
+    size_t uncompressedSize = (static_cast<size_t>(this->width) * this->height * this->channels * this->bitDepth + 7) / 8;
     // Taille compressée basée sur la taille réelle du fichier.
 
     ifstream file(imgPath.toStdString(), ios::binary | ios::ate);
@@ -100,11 +223,36 @@ QString Image::getPath() const {
 double Image::getCompressionRatio() const {
     return this->compressionRatio;
 }
+// Vrai si getContent() renvoie un aperçu réduit d'un raster trop grand pour être chargé entièrement.
+
+bool Image::isReduced() const {
+    return this->reduced;
+}
 // Retourne l'identifiant de l'image.
 
 int Image::getId() const {
     return this->idImage;
 }
+// Retourne la largeur de l'image entière, lue dans l'en-tête.
+
+int Image::getWidth() const {
+    return this->width;
+}
+// Retourne la hauteur de l'image entière, lue dans l'en-tête.
+
+int Image::getHeight() const {
+    return this->height;
+}
+// Retourne le nombre de canaux stockés dans le fichier.
+
+int Image::getChannels() const {
+    return this->channels;
+}
+// Retourne le nombre de bits par canal stockés dans le fichier.
+
+int Image::getBitDepth() const {
+    return this->bitDepth;
+}
 // Met à jour le chemin de l'image.
 
 void Image::setPath(const QString& newPath) {
@@ -119,6 +267,7 @@ void Image::setId(const int newID) {
 // Retourne l'image sous forme de QPixmap (pour l'intégration avec Qt).
 
 QPixmap Image::getPixmap() const {
+    Mat content = getContent();
     if (content.empty()) {
         return QPixmap();
     }
@@ -4,11 +4,22 @@
 #include <opencv2/opencv.hpp>
 #include <QString>
 #include <QPixmap>
+#include <QJsonObject>
+#include <cstdint>
+
+// Au-delà de 64 Mpixels, l'image n'est pas décodée entièrement : on charge un aperçu de 4096 pixels de côté au plus.
+const long long IMAGE_FULL_DECODE_PIXELS = 64LL * 1024 * 1024;
+const int IMAGE_OVERVIEW_SIDE = 4096;
+
+// Une Image ne garde que ses métadonnées ; ses pixels sont décodés à la demande et partagés via ImageCache.
 class Image {
 public:
     Image(const QString& imgPath);
+    Image(const QString& imgPath, const QJsonObject& metadata);
 
-    void loadImage(const QString& imgPath);
+    void loadMetadata(const QString& imgPath);
+    bool restoreMetadata(const QString& imgPath, const QJsonObject& metadata);
+    QJsonObject metadataToJson() const;
     double calculateCompressionRatio(const QString& imgPath) const;
     void showImage(const QString& imgPath) const;
 
@@ -16,20 +27,31 @@ public:
     QString getPath() const;
     double getCompressionRatio() const;
     int getId() const;
+    int getWidth() const;
+    int getHeight() const;
+    int getChannels() const;
+    int getBitDepth() const;
 
     void setPath(const QString& newPath);
     void setId(const int newID);
     cv::Mat getContent() const;
     QPixmap getPixmap() const;
+    bool isReduced() const;
 
 
 
 private:
     QString path;
     QString format;
-    double compressionRatio;
+    double compressionRatio = 0.0;
     int idImage;
-    cv::Mat content;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    int bitDepth = 0;
+    uint64_t fileSize = 0;
+    int64_t modified = 0;
+    bool reduced = false;
 };
 
 #endif // IMAGE_HPP
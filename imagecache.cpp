@@ -0,0 +1,128 @@
+#include "imagecache.hpp"
+#include <cstdlib>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+size_t defaultBudget() {
+    if (const char* value = getenv("LIBRARY_IMAGE_CACHE_MB")) {
+        long long megabytes = atoll(value);
+        if (megabytes > 0) {
+            return static_cast<size_t>(megabytes) * 1024 * 1024;
+        }
+    }
+    return IMAGE_CACHE_DEFAULT_BYTES;
+}
+
+size_t pixelBytes(const Mat& pixels) {
+    return pixels.total() * pixels.elemSize();
+}
+
+} // namespace
+
+ImageCache& ImageCache::instance() {
+    static ImageCache cache;
+    return cache;
+}
+
+ImageCache::ImageCache() : budget(defaultBudget()), totalBytes(0) {}
+
+/**
+ * @brief Change la mémoire maximale occupée par les pixels gardés ; les images en trop sont libérées aussitôt.
+ * @param maxBytes Budget en octets.
+ */
+void ImageCache::setMaxBytes(size_t maxBytes) {
+    lock_guard<mutex> guard(lock);
+    budget = maxBytes;
+    evict();
+}
+
+size_t ImageCache::maxBytes() const {
+    lock_guard<mutex> guard(lock);
+    return budget;
+}
+
+size_t ImageCache::usedBytes() const {
+    lock_guard<mutex> guard(lock);
+    return totalBytes;
+}
+
+/**
+ * @brief Retourne les pixels associés à une clé, en les décodant s'ils ne sont pas en mémoire.
+ *
+ * Le décodage a lieu hors du verrou : des clés différentes sont décodées en parallèle. Une image vide
+ * (échec du décodage) n'est pas gardée, et une image plus grande que le budget est renvoyée sans être gardée.
+ *
+ * @param key Identifiant des pixels (chemin et état du fichier).
+ * @param decode Fonction appelée pour décoder l'image en cas d'absence.
+ * @return Les pixels, ou une Mat vide si le décodage a échoué.
+ */
+Mat ImageCache::get(const string& key, const function<Mat()>& decode) {
+    {
+        unique_lock<mutex> guard(lock);
+        decoded.wait(guard, [&]() { return decoding.count(key) == 0; });
+        auto found = entries.find(key);
+        if (found != entries.end()) {
+            recent.splice(recent.begin(), recent, found->second.position);
+            return found->second.pixels;
+        }
+        decoding.insert(key);
+    }
+
+    Mat pixels;
+    try {
+        pixels = decode();
+    } catch (...) {
+        lock_guard<mutex> guard(lock);
+        decoding.erase(key);
+        decoded.notify_all();
+        throw;
+    }
+
+    lock_guard<mutex> guard(lock);
+    decoding.erase(key);
+    decoded.notify_all();
+    const size_t bytes = pixelBytes(pixels);
+    if (pixels.empty() || bytes > budget) {
+        return pixels;
+    }
+    recent.push_front(key);
+    entries[key] = {pixels, bytes, recent.begin()};
+    totalBytes += bytes;
+    evict();
+    return pixels;
+}
+
+/**
+ * @brief Oublie les pixels d'une clé (par exemple après la modification du fichier).
+ * @param key Identifiant des pixels.
+ */
+void ImageCache::remove(const string& key) {
+    lock_guard<mutex> guard(lock);
+    auto found = entries.find(key);
+    if (found == entries.end()) {
+        return;
+    }
+    totalBytes -= found->second.bytes;
+    recent.erase(found->second.position);
+    entries.erase(found);
+}
+
+void ImageCache::clear() {
+    lock_guard<mutex> guard(lock);
+    entries.clear();
+    recent.clear();
+    totalBytes = 0;
+}
+
+// Libère les images les moins récemment demandées jusqu'à revenir dans le budget (verrou déjà pris).
+void ImageCache::evict() {
+    while (totalBytes > budget && !recent.empty()) {
+        auto found = entries.find(recent.back());
+        totalBytes -= found->second.bytes;
+        entries.erase(found);
+        recent.pop_back();
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef IMAGECACHE_HPP
+#define IMAGECACHE_HPP
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace cv;
+using namespace std;
+
+// Mémoire allouée par défaut aux pixels décodés (variable d'environnement LIBRARY_IMAGE_CACHE_MB pour la changer).
+const size_t IMAGE_CACHE_DEFAULT_BYTES = 512 * 1024 * 1024;
+
+/**
+ * @brief Cache en mémoire des images décodées, partagé par toutes les instances d'Image.
+ *
+ * Une Image ne garde que ses métadonnées ; ses pixels sont décodés à la première demande puis gardés ici
+ * tant que le budget mémoire le permet. Les images les moins récemment demandées sont libérées en premier.
+ * Une Mat déjà renvoyée reste valide après son éviction (ses données sont comptées par référence).
+ *
+ * Les méthodes peuvent être appelées depuis plusieurs threads ; une même clé n'est décodée qu'une fois,
+ * les autres demandeurs attendent le résultat.
+ */
+class ImageCache {
+public:
+    static ImageCache& instance();
+
+    void setMaxBytes(size_t maxBytes);
+    size_t maxBytes() const;
+    size_t usedBytes() const;
+
+    Mat get(const string& key, const function<Mat()>& decode);
+    void remove(const string& key);
+    void clear();
+
+private:
+    ImageCache();
+    ImageCache(const ImageCache&) = delete;
+    ImageCache& operator=(const ImageCache&) = delete;
+
+    struct Entry {
+        Mat pixels;
+        size_t bytes;
+        list<string>::iterator position;
+    };
+
+    void evict();
+
+    mutable mutex lock;
+    condition_variable decoded;
+    size_t budget;
+    size_t totalBytes;
+    list<string> recent;    // de la plus récemment demandée à la plus ancienne
+    unordered_map<string, Entry> entries;
+    unordered_set<string> decoding;
+};
+
+#endif // IMAGECACHE_HPP
@@ -0,0 +1,198 @@
+#include "imagehash.hpp"
+#include "threadpool.hpp"
+#include "preview.hpp"
+#include <algorithm>
+#include <bitset>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace cv;
+using namespace std;
+
+/**
+ * @brief Empreinte perceptuelle dHash (64 bits) d'une image.
+ *
+ * L'image est convertie en gris et réduite à 9x8 pixels ; chaque bit indique si un pixel est plus clair que
+ * son voisin de droite. L'empreinte résiste au changement de taille, à la recompression et aux faibles
+ * retouches de luminosité : des images presque identiques ont des empreintes proches au sens de Hamming.
+ *
+ * @param image Image 8 bits en niveaux de gris, BGR ou BGRA.
+ * @return Les 64 bits, ligne par ligne, le premier pixel dans le bit de poids fort.
+ * @throws std::invalid_argument Si l'image est vide ou n'est pas en 8 bits.
+ */
+uint64_t differenceHash(const Mat& image) {
+    if (image.empty()) {
+        throw invalid_argument("L'image d'entrée est vide.");
+    }
+    if (image.depth() != CV_8U) {
+        throw invalid_argument("Le dHash n'est défini que pour les images 8 bits.");
+    }
+    Mat gray;
+    if (image.channels() == 3) {
+        cvtColor(image, gray, COLOR_BGR2GRAY);
+    } else if (image.channels() == 4) {
+        cvtColor(image, gray, COLOR_BGRA2GRAY);
+    } else {
+        gray = image;
+    }
+
+    Mat small;
+    resize(gray, small, Size(9, 8), 0, 0, INTER_AREA);
+    uint64_t hash = 0;
+    for (int y = 0; y < 8; y++) {
+        const uchar* row = small.ptr<uchar>(y);
+        for (int x = 0; x < 8; x++) {
+            hash = (hash << 1) | (row[x] > row[x + 1] ? 1u : 0u);
+        }
+    }
+    return hash;
+}
+
+/**
+ * @brief dHash d'un fichier image, décodé à résolution réduite (`loadPreview`) : un JPEG n'est décodé
+ *        qu'au 1/8, un JPEG 2000 qu'au niveau de résolution suffisant.
+ *
+ * @throws std::invalid_argument Si le fichier ne peut pas être décodé.
+ */
+uint64_t differenceHashOfFile(const string& path) {
+    return differenceHash(loadPreview(path, Size(HASH_DECODE_SIDE, HASH_DECODE_SIDE)));
+}
+
+int hammingDistance(uint64_t a, uint64_t b) {
+    return static_cast<int>(bitset<64>(a ^ b).count());
+}
+
+// 16 chiffres hexadécimaux : un nombre JSON (double) ne garde pas les 64 bits.
+string hashToHex(uint64_t hash) {
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
+bool hashFromHex(const string& text, uint64_t& hash) {
+    if (text.size() != 16) {
+        return false;
+    }
+    uint64_t value = 0;
+    for (char c : text) {
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint64_t>(digit);
+    }
+    hash = value;
+    return true;
+}
+
+void HashTree::insert(uint64_t hash, unsigned int id) {
+    const int index = static_cast<int>(nodes.size());
+    nodes.push_back({hash, id, {}, false});
+    if (index == 0) {
+        return;
+    }
+    int node = 0;
+    while (true) {
+        const int distance = hammingDistance(hash, nodes[node].hash);
+        int next = -1;
+        for (const pair<int, int>& child : nodes[node].children) {
+            if (child.first == distance) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next < 0) {
+            nodes[node].children.emplace_back(distance, index);
+            return;
+        }
+        node = next;
+    }
+}
+
+/**
+ * @brief Toutes les empreintes de l'arbre à distance au plus `radius` de `hash`.
+ *
+ * @return Paires (id, distance), dans l'ordre du parcours.
+ */
+vector<pair<unsigned int, int>> HashTree::search(uint64_t hash, int radius) const {
+    vector<pair<unsigned int, int>> found;
+    if (nodes.empty()) {
+        return found;
+    }
+    vector<int> pending(1, 0);
+    while (!pending.empty()) {
+        const Node& node = nodes[pending.back()];
+        pending.pop_back();
+        const int distance = hammingDistance(hash, node.hash);
+        if (distance <= radius && !node.removed) {
+            found.emplace_back(node.id, distance);
+        }
+        for (const pair<int, int>& child : node.children) {
+            if (child.first >= distance - radius && child.first <= distance + radius) {
+                pending.push_back(child.second);
+            }
+        }
+    }
+    return found;
+}
+
+// Retire les empreintes de l'image `id` des résultats (les nœuds restent pour le parcours de leurs enfants).
+void HashTree::remove(unsigned int id) {
+    for (Node& node : nodes) {
+        if (node.id == id && !node.removed) {
+            node.removed = true;
+            removedCount++;
+        }
+    }
+}
+
+// Nombre d'empreintes que search() peut encore renvoyer.
+size_t HashTree::size() const {
+    return nodes.size() - removedCount;
+}
+
+void HashTree::clear() {
+    nodes.clear();
+    removedCount = 0;
+}
+
+/**
+ * @brief Toutes les paires d'images dont les empreintes sont à distance au plus `radius`.
+ *
+ * L'arbre est construit une fois, puis chaque empreinte y est cherchée en parallèle. Le résultat est trié
+ * (par premier puis second id) et ne dépend donc pas du nombre de threads.
+ *
+ * @param hashes Paires (id, empreinte) ; les ids doivent être distincts.
+ */
+vector<DuplicatePair> findDuplicates(const vector<pair<unsigned int, uint64_t>>& hashes, int radius) {
+    HashTree tree;
+    for (const pair<unsigned int, uint64_t>& entry : hashes) {
+        tree.insert(entry.second, entry.first);
+    }
+
+    const int count = static_cast<int>(hashes.size());
+    vector<vector<DuplicatePair>> found(count);
+    ThreadPool::instance().parallelFor(count, [&](int i) {
+        for (const pair<unsigned int, int>& match : tree.search(hashes[i].second, radius)) {
+            // Chaque paire est trouvée depuis ses deux images : seule celle du plus petit id la garde
+            if (match.first > hashes[i].first) {
+                found[i].push_back({hashes[i].first, match.first, match.second});
+            }
+        }
+    });
+
+    vector<DuplicatePair> pairs;
+    for (const vector<DuplicatePair>& matches : found) {
+        pairs.insert(pairs.end(), matches.begin(), matches.end());
+    }
+    sort(pairs.begin(), pairs.end(), [](const DuplicatePair& a, const DuplicatePair& b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+    return pairs;
+}
@@ -0,0 +1,60 @@
+#ifndef IMAGEHASH_HPP
+#define IMAGEHASH_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// Deux images dont les dHash diffèrent d'au plus 10 bits sur 64 sont considérées comme des quasi-doublons.
+const int DUPLICATE_HAMMING_RADIUS = 10;
+// Côté de la zone dans laquelle une image est décodée pour son dHash (il n'en garde que 9x8 pixels).
+const int HASH_DECODE_SIDE = 64;
+
+struct DuplicatePair {
+    unsigned int first;     // Toujours le plus petit des deux ids
+    unsigned int second;
+    int distance;
+};
+
+uint64_t differenceHash(const Mat& image);
+uint64_t differenceHashOfFile(const string& path);
+int hammingDistance(uint64_t a, uint64_t b);
+string hashToHex(uint64_t hash);
+bool hashFromHex(const string& text, uint64_t& hash);
+
+/**
+ * @brief Arbre BK sur des empreintes de 64 bits : trouve toutes les empreintes à distance de Hamming
+ *        au plus `radius` d'une empreinte donnée sans les comparer toutes.
+ *
+ * Chaque nœud range ses enfants selon leur distance à lui ; l'inégalité triangulaire permet d'ignorer
+ * les sous-arbres dont la distance est hors de [d - radius, d + radius]. Une empreinte retirée reste un
+ * nœud de l'arbre (il sert encore au parcours) mais n'est plus jamais renvoyée.
+ */
+class HashTree {
+public:
+    void insert(uint64_t hash, unsigned int id);
+    void remove(unsigned int id);
+    vector<pair<unsigned int, int>> search(uint64_t hash, int radius) const;
+    size_t size() const;
+    void clear();
+
+private:
+    struct Node {
+        uint64_t hash;
+        unsigned int id;
+        vector<pair<int, int>> children;    // (distance au nœud, indice de l'enfant)
+        bool removed;
+    };
+    vector<Node> nodes;
+    size_t removedCount = 0;
+};
+
+vector<DuplicatePair> findDuplicates(const vector<pair<unsigned int, uint64_t>>& hashes,
+                                     int radius = DUPLICATE_HAMMING_RADIUS);
+
+#endif // IMAGEHASH_HPP
@@ -0,0 +1,247 @@
+#include "imageprobe.hpp"
+#include "jpeg2000.hpp"
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+
+using namespace std;
+
+namespace {
+
+const unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+const unsigned char JP2_BOX[12] = {0x00, 0x00, 0x00, 0x0C, 'j', 'P', ' ', ' ', 0x0D, 0x0A, 0x87, 0x0A};
+const unsigned char J2K_MARKERS[4] = {0xFF, 0x4F, 0xFF, 0x51};
+const uint64_t MAX_TIFF_TAGS = 4096;    // garde-fou contre un IFD corrompu
+
+// Entier non signé de `bytes` octets, dans l'ordre indiqué.
+uint64_t readUnsigned(istream& in, int bytes, bool littleEndian) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        const uint64_t byte = static_cast<uint64_t>(in.get()) & 0xFF;
+        value |= littleEndian ? byte << (8 * i) : byte << (8 * (bytes - 1 - i));
+    }
+    return value;
+}
+
+// En-tête IHDR, toujours le premier segment après la signature.
+bool probePng(istream& in, ImageInfo& info) {
+    in.seekg(12);
+    char type[4];
+    in.read(type, 4);
+    if (!in || memcmp(type, "IHDR", 4) != 0) {
+        return false;
+    }
+    info.width = static_cast<int>(readUnsigned(in, 4, false));
+    info.height = static_cast<int>(readUnsigned(in, 4, false));
+    info.bitDepth = in.get();
+    switch (in.get()) {
+    case 0: info.channels = 1; break;                       // Niveaux de gris
+    case 2: info.channels = 3; break;                       // RGB
+    case 3: info.channels = 3; info.bitDepth = 8; break;    // Palette (entrées RGB 8 bits)
+    case 4: info.channels = 2; break;                       // Niveaux de gris + alpha
+    case 6: info.channels = 4; break;                       // RGBA
+    default: return false;
+    }
+    return static_cast<bool>(in);
+}
+
+// Marqueur SOF : précision, dimensions et nombre de composantes, sans décoder l'image.
+bool probeJpeg(istream& in, ImageInfo& info) {
+    in.seekg(2);
+    while (in) {
+        if (in.get() != 0xFF) {
+            return false;
+        }
+        int marker = in.get();
+        while (marker == 0xFF) {    // Octets de remplissage
+            marker = in.get();
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            continue;               // Marqueurs sans segment
+        }
+        if (marker < 0 || marker == 0xD9 || marker == 0xDA) {
+            return false;           // Fin d'image ou début des données sans SOF
+        }
+        const int length = static_cast<int>(readUnsigned(in, 2, false));
+        if (length < 2) {
+            return false;
+        }
+        // SOF0 à SOF15, sauf DHT (C4), JPG (C8) et DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            info.bitDepth = in.get();
+            info.height = static_cast<int>(readUnsigned(in, 2, false));
+            info.width = static_cast<int>(readUnsigned(in, 2, false));
+            info.channels = in.get();
+            return static_cast<bool>(in);
+        }
+        in.seekg(length - 2, ios::cur);
+    }
+    return false;
+}
+
+// BITMAPCOREHEADER (OS/2, 12 octets) ou BITMAPINFOHEADER et ses extensions.
+bool probeBmp(istream& in, ImageInfo& info) {
+    in.seekg(14);
+    const uint64_t headerSize = readUnsigned(in, 4, true);
+    int bitCount;
+    if (headerSize == 12) {
+        info.width = static_cast<int>(readUnsigned(in, 2, true));
+        info.height = static_cast<int>(readUnsigned(in, 2, true));
+        readUnsigned(in, 2, true);      // Plans
+        bitCount = static_cast<int>(readUnsigned(in, 2, true));
+    } else if (headerSize >= 40) {
+        info.width = static_cast<int32_t>(readUnsigned(in, 4, true));
+        info.height = abs(static_cast<int32_t>(readUnsigned(in, 4, true)));    // Négative si stockée de haut en bas
+        readUnsigned(in, 2, true);
+        bitCount = static_cast<int>(readUnsigned(in, 2, true));
+    } else {
+        return false;
+    }
+    // Les images à palette (1 à 8 bits) et 16 bits sont décodées en BGR 8 bits
+    info.channels = bitCount == 32 ? 4 : 3;
+    info.bitDepth = 8;
+    return in && bitCount > 0;
+}
+
+// Premier IFD d'un TIFF classique ou BigTIFF : ImageWidth, ImageLength, BitsPerSample et SamplesPerPixel.
+bool probeTiff(istream& in, ImageInfo& info) {
+    in.seekg(0);
+    const bool little = in.get() == 'I';
+    in.get();
+    const uint64_t version = readUnsigned(in, 2, little);
+    const bool big = version == 43;
+    if (version != 42 && !big) {
+        return false;
+    }
+    if (big) {
+        readUnsigned(in, 4, little);    // Taille des offsets (8) et réservé
+    }
+    const int offsetBytes = big ? 8 : 4;
+    in.seekg(static_cast<streamoff>(readUnsigned(in, offsetBytes, little)));
+    const uint64_t count = readUnsigned(in, big ? 8 : 2, little);
+    if (!in || count > MAX_TIFF_TAGS) {
+        return false;
+    }
+
+    int bitsPerSample = 1, samplesPerPixel = 1;    // Valeurs par défaut de la norme
+    const streamoff firstEntry = in.tellg();
+    const streamoff entryBytes = 4 + 2 * offsetBytes;
+    for (uint64_t i = 0; i < count && in; i++) {
+        in.seekg(firstEntry + static_cast<streamoff>(i) * entryBytes);
+        const uint64_t tag = readUnsigned(in, 2, little);
+        const uint64_t type = readUnsigned(in, 2, little);
+        const uint64_t valueCount = readUnsigned(in, offsetBytes, little);
+        const int typeBytes = type == 3 ? 2 : type == 4 ? 4 : type == 16 ? 8 : 0;    // SHORT, LONG, LONG8
+        if (typeBytes == 0 || valueCount == 0) {
+            continue;
+        }
+        // Au-delà de la taille du champ, les valeurs sont rangées ailleurs : seule la première est lue
+        if (valueCount * typeBytes > static_cast<uint64_t>(offsetBytes)) {
+            in.seekg(static_cast<streamoff>(readUnsigned(in, offsetBytes, little)));
+        }
+        const int value = static_cast<int>(readUnsigned(in, typeBytes, little));
+        switch (tag) {
+        case 256: info.width = value; break;
+        case 257: info.height = value; break;
+        case 258: bitsPerSample = value; break;
+        case 277: samplesPerPixel = value; break;
+        default: break;
+        }
+    }
+    info.channels = samplesPerPixel;
+    info.bitDepth = bitsPerSample;
+    return static_cast<bool>(in);
+}
+
+// Premier segment du conteneur RIFF : VP8 (avec perte), VP8L (sans perte) ou VP8X (étendu).
+bool probeWebp(istream& in, ImageInfo& info) {
+    in.seekg(12);
+    char chunk[4];
+    in.read(chunk, 4);
+    readUnsigned(in, 4, true);    // Taille du segment
+    info.bitDepth = 8;
+    if (memcmp(chunk, "VP8 ", 4) == 0) {
+        in.seekg(3, ios::cur);    // Étiquette de trame
+        if (in.get() != 0x9D || in.get() != 0x01 || in.get() != 0x2A) {
+            return false;
+        }
+        info.width = static_cast<int>(readUnsigned(in, 2, true) & 0x3FFF);
+        info.height = static_cast<int>(readUnsigned(in, 2, true) & 0x3FFF);
+        info.channels = 3;
+    } else if (memcmp(chunk, "VP8L", 4) == 0) {
+        if (in.get() != 0x2F) {
+            return false;
+        }
+        const uint64_t bits = readUnsigned(in, 4, true);
+        info.width = static_cast<int>(bits & 0x3FFF) + 1;
+        info.height = static_cast<int>((bits >> 14) & 0x3FFF) + 1;
+        info.channels = (bits >> 28) & 1 ? 4 : 3;
+    } else if (memcmp(chunk, "VP8X", 4) == 0) {
+        const int flags = in.get();
+        in.seekg(3, ios::cur);
+        info.width = static_cast<int>(readUnsigned(in, 3, true)) + 1;
+        info.height = static_cast<int>(readUnsigned(in, 3, true)) + 1;
+        info.channels = flags & 0x10 ? 4 : 3;
+    } else {
+        return false;
+    }
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+/**
+ * @brief Lit les dimensions, le nombre de canaux et la profondeur d'une image dans l'en-tête de son fichier,
+ *        sans décoder les pixels.
+ *
+ * Le format est reconnu à sa signature, pas à l'extension du fichier. Formats reconnus : PNG, JPEG, BMP,
+ * TIFF (classique et BigTIFF), WebP et JPEG 2000 (JP2 et flux J2K brut). Seuls quelques octets sont lus,
+ * quelle que soit la taille de l'image (pour JPEG, les segments qui précèdent le SOF sont sautés).
+ *
+ * @param info Rempli si l'en-tête a pu être lu.
+ * @return false si le format n'est pas reconnu ou si l'en-tête est illisible.
+ */
+bool probeImage(const string& path, ImageInfo& info) {
+    ifstream file(path, ios::binary);
+    unsigned char signature[12] = {};
+    file.read(reinterpret_cast<char*>(signature), sizeof(signature));
+    if (file.gcount() < 4) {
+        return false;
+    }
+    file.clear();
+
+    ImageInfo probed;
+    bool ok = false;
+    if (memcmp(signature, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0) {
+        probed.format = "png";
+        ok = probePng(file, probed);
+    } else if (signature[0] == 0xFF && signature[1] == 0xD8) {
+        probed.format = "jpeg";
+        ok = probeJpeg(file, probed);
+    } else if (signature[0] == 'B' && signature[1] == 'M') {
+        probed.format = "bmp";
+        ok = probeBmp(file, probed);
+    } else if ((memcmp(signature, "II", 2) == 0 && signature[3] == 0)
+               || (memcmp(signature, "MM", 2) == 0 && signature[2] == 0)) {
+        probed.format = "tiff";
+        ok = probeTiff(file, probed);
+    } else if (memcmp(signature, "RIFF", 4) == 0 && memcmp(signature + 8, "WEBP", 4) == 0) {
+        probed.format = "webp";
+        ok = probeWebp(file, probed);
+    } else if (memcmp(signature, JP2_BOX, sizeof(JP2_BOX)) == 0 || memcmp(signature, J2K_MARKERS, 4) == 0) {
+        probed.format = signature[0] == 0xFF ? "j2k" : "jp2";
+        Jpeg2000Info header;
+        ok = readJpeg2000Info(path, header);
+        probed.width = header.width;
+        probed.height = header.height;
+        probed.channels = header.components;
+        probed.bitDepth = header.precision;
+    }
+
+    if (!ok || probed.width <= 0 || probed.height <= 0 || probed.channels <= 0 || probed.bitDepth <= 0) {
+        return false;
+    }
+    info = probed;
+    return true;
+}
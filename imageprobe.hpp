@@ -0,0 +1,19 @@
+#ifndef IMAGEPROBE_HPP
+#define IMAGEPROBE_HPP
+
+#include <string>
+
+using namespace std;
+
+// Caractéristiques d'une image lues dans l'en-tête de son fichier.
+struct ImageInfo {
+    string format;          // "png", "jpeg", "bmp", "tiff", "webp", "jp2" ou "j2k", d'après la signature
+    int width = 0;
+    int height = 0;
+    int channels = 0;       // Canaux après décodage de la palette éventuelle
+    int bitDepth = 0;       // Bits par canal
+};
+
+bool probeImage(const string& path, ImageInfo& info);
+
+#endif // IMAGEPROBE_HPP
@@ -1,6 +1,13 @@
 #ifndef IMAGEPROCCESSING_HPP
 #define IMAGEPROCCESSING_HPP
 #include <opencv2/opencv.hpp>
+#include "pointoperation.hpp"
+#include "histogram.hpp"
+#include "pipeline.hpp"
+#include "bufferpool.hpp"
+#include "rotation.hpp"
+#include "siftcache.hpp"
+#include "tiledraster.hpp"
 
 using namespace cv;
 using namespace std; 
@@ -11,14 +18,43 @@ public:
     ImageProccessing();
 
     Mat calculateHistogram(const Mat& inputImage);
-    Mat applyGaussianFilter(const Mat& inputImage);
+    Histogram computeHistogram(const Mat& inputImage);
+    Mat applyHistogramEqualization(const Mat& inputImage);
+    Mat applyOtsuThreshold(const Mat& inputImage, int* thresholdValue = nullptr);
+    Mat applyCLAHE(const Mat& inputImage, double clipLimit = 2.0, int tileGridSize = 8);
+    Mat applyGaussianFilter(const Mat& inputImage, int kernelSize = 3, double sigma = 1.0);
     Mat toGrayScale(const cv::Mat& inputImage) ;
     Mat applyCustomMedianFilter(const cv::Mat& inputImage, int kernelSize);
-    Mat applyEdgeDetection(const Mat& inputImage);
+    Mat applyEdgeDetection(const Mat& inputImage, Mat* direction = nullptr);
     Mat applyThreshold(const Mat& inputImage, int thresholdValue);
-    Mat rotateImage(const Mat& inputImage, int angle);
+    Mat rotateImage(const Mat& inputImage, double angle, RotationInterpolation interpolation = RotationInterpolation::Bilinear);
     Mat applySIFT(const Mat& inputImage);
+    Mat applySIFT(const Mat& inputImage, const string& imagePath);
+    SiftFeatures getSiftFeatures(const string& imagePath);
     Mat applyErosion(const Mat& inputImage, int kernelSize) ;
+    Mat applyDilation(const Mat& inputImage, int kernelSize);
+    Mat applyOpening(const Mat& inputImage, int kernelSize);
+    Mat applyClosing(const Mat& inputImage, int kernelSize);
+    Mat applyMorphologicalGradient(const Mat& inputImage, int kernelSize);
+    Mat applyPointOperation(const Mat& inputImage, const PointOperation& operation);
+    Mat applyInvert(const Mat& inputImage);
+    Mat applyGammaCorrection(const Mat& inputImage, double gamma);
+    Mat applyBrightnessContrast(const Mat& inputImage, double contrast, int brightness);
+    Mat applyLevels(const Mat& inputImage, int inputBlack, int inputWhite, double gamma = 1.0);
+    Mat applyPipeline(const Mat& inputImage, const FilterPipeline& pipeline, vector<StageTiming>* timings = nullptr);
+    void applyPipelineTiled(const string& inputPath, const string& outputPath, const FilterPipeline& pipeline,
+                            int tileSize = RASTER_TILE_SIZE, const function<void(int, int)>& progress = nullptr);
+
+    BufferPoolStats memoryStats() const;
+    void resetPeakMemory();
+    void releaseCachedBuffers();
+
+private:
+    // Les tampons des filtres viennent de ce pool partagé et y retournent à leur libération.
+    BufferPool& pool;
 };
 
+// Ancienne implémentation du flou gaussien 3x3, conservée comme référence pour les benchmarks.
+void GaussianBlurMultiChannel(const cv::Mat& src, cv::Mat& dst);
+
 #endif // IMAGEPROCCESSING_HPP
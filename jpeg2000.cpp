@@ -0,0 +1,239 @@
+#include "jpeg2000.hpp"
+#include "threadpool.hpp"
+#include <openjpeg.h>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+const unsigned char JP2_SIGNATURE[12] = {0x00, 0x00, 0x00, 0x0C, 'j', 'P', ' ', ' ', 0x0D, 0x0A, 0x87, 0x0A};
+const unsigned char J2K_SIGNATURE[4] = {0xFF, 0x4F, 0xFF, 0x51};
+
+struct CodecDeleter {
+    void operator()(opj_codec_t* codec) const { opj_destroy_codec(codec); }
+};
+struct StreamDeleter {
+    void operator()(opj_stream_t* stream) const { opj_stream_destroy(stream); }
+};
+struct ImageDeleter {
+    void operator()(opj_image_t* image) const { opj_image_destroy(image); }
+};
+using CodecPtr = unique_ptr<opj_codec_t, CodecDeleter>;
+using StreamPtr = unique_ptr<opj_stream_t, StreamDeleter>;
+using ImagePtr = unique_ptr<opj_image_t, ImageDeleter>;
+
+// Les messages d'openjp2 sont gardés pour l'exception plutôt qu'écrits sur la sortie d'erreur.
+void keepMessage(const char* message, void* target) {
+    if (target && message) {
+        *static_cast<string*>(target) = message;
+    }
+}
+
+void ignoreMessage(const char*, void*) {}
+
+// Format du flux d'après sa signature : boîte JP2 ou marqueurs SOC + SIZ d'un flux J2K brut.
+bool codecFormat(const string& path, OPJ_CODEC_FORMAT& format) {
+    ifstream file(path, ios::binary);
+    unsigned char signature[12] = {};
+    file.read(reinterpret_cast<char*>(signature), sizeof(signature));
+    if (file.gcount() == 12 && memcmp(signature, JP2_SIGNATURE, sizeof(JP2_SIGNATURE)) == 0) {
+        format = OPJ_CODEC_JP2;
+        return true;
+    }
+    if (file.gcount() >= 4 && memcmp(signature, J2K_SIGNATURE, sizeof(J2K_SIGNATURE)) == 0) {
+        format = OPJ_CODEC_J2K;
+        return true;
+    }
+    return false;
+}
+
+// Ouvre le flux et le décodeur ; les messages d'erreur d'openjp2 sont recueillis dans `error`.
+bool openCodestream(const string& path, CodecPtr& codec, StreamPtr& stream, string& error) {
+    OPJ_CODEC_FORMAT format;
+    if (!codecFormat(path, format)) {
+        error = "Le fichier n'est pas une image JPEG 2000 : " + path;
+        return false;
+    }
+    stream.reset(opj_stream_create_default_file_stream(path.c_str(), OPJ_TRUE));
+    codec.reset(opj_create_decompress(format));
+    if (!stream || !codec) {
+        error = "Impossible d'ouvrir l'image JPEG 2000 : " + path;
+        return false;
+    }
+    opj_set_error_handler(codec.get(), keepMessage, &error);
+    opj_set_warning_handler(codec.get(), ignoreMessage, nullptr);
+    opj_set_info_handler(codec.get(), ignoreMessage, nullptr);
+    return true;
+}
+
+// Valeur d'une composante ramenée sur 8 bits (précision et signe quelconques).
+Mat componentTo8Bits(const opj_image_comp_t& component) {
+    Mat values(static_cast<int>(component.h), static_cast<int>(component.w), CV_32S, component.data);
+    const int precision = static_cast<int>(component.prec);
+    const double offset = component.sgnd ? ldexp(1.0, precision - 1) : 0.0;
+    Mat bytes;
+    values.convertTo(bytes, CV_8U, 255.0 / (ldexp(1.0, precision) - 1), offset * 255.0 / (ldexp(1.0, precision) - 1));
+    return bytes;
+}
+
+} // namespace
+
+/**
+ * @brief Vrai si le fichier commence par la signature d'un JP2 ou d'un flux J2K brut.
+ */
+bool isJpeg2000File(const string& path) {
+    OPJ_CODEC_FORMAT format;
+    return codecFormat(path, format);
+}
+
+/**
+ * @brief Lit l'en-tête principal du flux : quelques centaines d'octets, quelle que soit la taille de l'image.
+ *
+ * @return false si le fichier n'est pas un JPEG 2000 lisible.
+ */
+bool readJpeg2000Info(const string& path, Jpeg2000Info& info) {
+    CodecPtr codec;
+    StreamPtr stream;
+    string error;
+    opj_dparameters_t parameters;
+    opj_set_default_decoder_parameters(&parameters);
+    if (!openCodestream(path, codec, stream, error) || !opj_setup_decoder(codec.get(), &parameters)) {
+        return false;
+    }
+    opj_image_t* header = nullptr;
+    if (!opj_read_header(stream.get(), codec.get(), &header)) {
+        return false;
+    }
+    ImagePtr image(header);
+
+    opj_codestream_info_v2_t* codestream = opj_get_cstr_info(codec.get());
+    if (!codestream) {
+        return false;
+    }
+    info.width = static_cast<int>(header->x1 - header->x0);
+    info.height = static_cast<int>(header->y1 - header->y0);
+    info.components = static_cast<int>(header->numcomps);
+    info.precision = static_cast<int>(header->comps[0].prec);
+    info.resolutions = static_cast<int>(codestream->m_default_tile_info.tccp_info[0].numresolutions);
+    opj_destroy_cstr_info(&codestream);
+    return info.width > 0 && info.height > 0;
+}
+
+/**
+ * @brief Nombre de niveaux de résolution à ignorer pour que `region` décodée reste au moins aussi grande que
+ *        `targetSize` une fois ajustée dedans (même règle que Qt::KeepAspectRatio).
+ *
+ * @return 0 (pleine résolution) si `targetSize` est vide.
+ */
+int jpeg2000ReductionFor(const Jpeg2000Info& info, const Rect& region, Size targetSize) {
+    if (targetSize.width <= 0 || targetSize.height <= 0 || region.width <= 0 || region.height <= 0) {
+        return 0;
+    }
+    const double scale = min(static_cast<double>(targetSize.width) / region.width,
+                             static_cast<double>(targetSize.height) / region.height);
+    if (scale >= 1.0) {
+        return 0;
+    }
+    const int reduction = static_cast<int>(floor(log2(1.0 / scale)));
+    return max(0, min(reduction, info.resolutions - 1));
+}
+
+/**
+ * @brief Décode une image JPEG 2000 au plus petit niveau de résolution suffisant pour `targetSize`, et
+ *        seulement sur `region`.
+ *
+ * Le flux JPEG 2000 est organisé par niveaux de résolution et par blocs de code : openjp2 ne lit et ne
+ * décode que les paquets des niveaux demandés qui recouvrent la région. Un aperçu de 210 pixels d'une
+ * image de 10 000 pixels de côté ne décode ainsi qu'une petite partie du flux. Le décodage des tuiles et
+ * des blocs de code est réparti sur `threads` threads.
+ *
+ * L'image rendue n'est pas redimensionnée à `targetSize` : elle est au moins aussi grande (à moins que
+ * l'image elle-même soit plus petite), au plus deux fois plus grande.
+ *
+ * @param targetSize Taille d'affichage visée ; vide pour la pleine résolution.
+ * @param region Région en pixels de l'image à pleine résolution ; vide pour l'image entière.
+ * @param threads Nombre de threads du décodeur ; 0 pour celui du pool (`parallelThreadCount`).
+ * @return Mat Image 8 bits BGR (les images à 1 ou 2 composantes sont rendues en gris sur 3 canaux).
+ *
+ * @throws std::runtime_error Si le fichier n'est pas un JPEG 2000 valide ou si le décodage échoue.
+ * @throws std::invalid_argument Si la région sort de l'image.
+ */
+Mat decodeJpeg2000(const string& path, Size targetSize, const Rect& region, int threads) {
+    // Le facteur de réduction doit être fixé avant la lecture de l'en-tête : celui-ci est donc lu deux
+    // fois, ce qui ne coûte que quelques centaines d'octets.
+    Jpeg2000Info info;
+    if (!readJpeg2000Info(path, info)) {
+        throw runtime_error("En-tête JPEG 2000 illisible : " + path);
+    }
+    const Rect bounds(0, 0, info.width, info.height);
+    const Rect area = region.area() > 0 ? region : bounds;
+    if ((area & bounds) != area) {
+        throw invalid_argument("La région demandée sort de l'image.");
+    }
+
+    CodecPtr codec;
+    StreamPtr stream;
+    string error;
+    if (!openCodestream(path, codec, stream, error)) {
+        throw runtime_error(error);
+    }
+    opj_dparameters_t parameters;
+    opj_set_default_decoder_parameters(&parameters);
+    parameters.cp_reduce = static_cast<OPJ_UINT32>(jpeg2000ReductionFor(info, area, targetSize));
+    if (!opj_setup_decoder(codec.get(), &parameters)) {
+        throw runtime_error(error.empty() ? "Impossible de configurer le décodeur JPEG 2000." : error);
+    }
+    // Sans effet (et refusé) si openjp2 a été compilé sans threads : le décodage reste alors séquentiel
+    opj_codec_set_threads(codec.get(), threads > 0 ? threads : parallelThreadCount());
+    opj_image_t* header = nullptr;
+    if (!opj_read_header(stream.get(), codec.get(), &header)) {
+        throw runtime_error(error.empty() ? "En-tête JPEG 2000 illisible : " + path : error);
+    }
+    ImagePtr image(header);
+
+    // Coordonnées de la grille de référence (à pleine résolution, décalées par l'origine de l'image)
+    if (area != bounds
+        && !opj_set_decode_area(codec.get(), header, static_cast<OPJ_INT32>(header->x0 + area.x),
+                                static_cast<OPJ_INT32>(header->y0 + area.y),
+                                static_cast<OPJ_INT32>(header->x0 + area.x + area.width),
+                                static_cast<OPJ_INT32>(header->y0 + area.y + area.height))) {
+        throw runtime_error(error.empty() ? "Région JPEG 2000 invalide." : error);
+    }
+    if (!opj_decode(codec.get(), stream.get(), header) || !opj_end_decompress(codec.get(), stream.get())) {
+        throw runtime_error(error.empty() ? "Erreur de décodage JPEG 2000 : " + path : error);
+    }
+
+    const int components = static_cast<int>(header->numcomps);
+    if (components == 0 || !header->comps[0].data) {
+        throw runtime_error("Image JPEG 2000 vide : " + path);
+    }
+    const Size decodedSize(static_cast<int>(header->comps[0].w), static_cast<int>(header->comps[0].h));
+
+    // Composantes sous-échantillonnées (4:2:0...) remises à la taille de la première
+    const int used = components >= 3 ? 3 : 1;
+    vector<Mat> channels(used);
+    for (int c = 0; c < used; c++) {
+        channels[c] = componentTo8Bits(header->comps[c]);
+        if (channels[c].size() != decodedSize) {
+            resize(channels[c], channels[c], decodedSize, 0, 0, INTER_LINEAR);
+        }
+    }
+
+    Mat result;
+    if (used == 1) {
+        cvtColor(channels[0], result, COLOR_GRAY2BGR);
+    } else if (header->color_space == OPJ_CLRSPC_SYCC) {
+        Mat ycrcb;
+        merge(vector<Mat>{channels[0], channels[2], channels[1]}, ycrcb);
+        cvtColor(ycrcb, result, COLOR_YCrCb2BGR);
+    } else {
+        merge(vector<Mat>{channels[2], channels[1], channels[0]}, result);
+    }
+    return result;
+}
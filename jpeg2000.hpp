@@ -0,0 +1,24 @@
+#ifndef JPEG2000_HPP
+#define JPEG2000_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// En-tête d'un fichier JPEG 2000 : taille à pleine résolution et nombre de niveaux de résolution disponibles.
+struct Jpeg2000Info {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    int precision = 0;      // Bits par échantillon de la première composante
+    int resolutions = 0;    // Le niveau r donne une image 2^r fois plus petite (r < resolutions)
+};
+
+bool isJpeg2000File(const string& path);
+bool readJpeg2000Info(const string& path, Jpeg2000Info& info);
+int jpeg2000ReductionFor(const Jpeg2000Info& info, const Rect& region, Size targetSize);
+Mat decodeJpeg2000(const string& path, Size targetSize = Size(), const Rect& region = Rect(), int threads = 0);
+
+#endif // JPEG2000_HPP
@@ -1,21 +1,39 @@
 #ifndef KERNELS_HPP
 #define KERNELS_HPP
 
-#include <vector>
-using namespace std;
+// Noyau de convolution de taille et de coefficients fixés à la compilation.
+// Utilisé comme paramètre de template (`template <const auto& K>`) par le moteur de convolution,
+// qui déroule entièrement les noyaux et élimine les coefficients nuls.
+template <int Rows, int Cols>
+struct FixedKernel {
+    static constexpr int rows = Rows;
+    static constexpr int cols = Cols;
+    int coeffs[Rows][Cols];
+
+    // Somme des |coefficients| : borne la valeur absolue de la réponse (divisée par 255)
+    constexpr int absSum() const {
+        int sum = 0;
+        for (int y = 0; y < Rows; y++) {
+            for (int x = 0; x < Cols; x++) {
+                sum += coeffs[y][x] < 0 ? -coeffs[y][x] : coeffs[y][x];
+            }
+        }
+        return sum;
+    }
+};
 
 // Noyau Sobel pour le gradient X
-const vector<vector<float>> SOBEL_X = {
+constexpr FixedKernel<3, 3> SOBEL_X = {{
     {-1, 0, 1},
     {-2, 0, 2},
     {-1, 0, 1}
-};
+}};
 
 // Noyau Sobel pour le gradient Y
-const vector<vector<float>> SOBEL_Y = {
+constexpr FixedKernel<3, 3> SOBEL_Y = {{
     {-1, -2, -1},
     { 0,  0,  0},
     { 1,  2,  1}
-};
+}};
 
 #endif // KERNELS_HPP
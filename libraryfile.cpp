@@ -0,0 +1,568 @@
+#include "libraryfile.hpp"
+#include <QDebug>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonParseError>
+#include <QSaveFile>
+#include <QVector>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const char MAGIC[8] = {'L', 'I', 'B', 'C', 'O', 'L', 'S', '\0'};
+const quint32 BYTE_ORDER_MARK = 0x01020304;    // Files are written in native order; another order is refused
+
+enum Column {
+    IdColumn,
+    CostColumn,
+    AccessColumn,
+    PresentColumn,
+    TitleColumn,
+    SourceColumn,
+    PathColumn,
+    HashColumn,
+    FormatColumn,
+    WidthColumn,
+    HeightColumn,
+    ChannelsColumn,
+    BitDepthColumn,
+    RatioColumn,
+    FileSizeColumn,
+    ModifiedColumn,
+    ExtraColumn,
+    ColumnCount
+};
+
+// Size of one cell of each column, in bytes
+const quint64 CELL_BYTES[ColumnCount] = {4, 8, 1, 4, 8, 8, 8, 8, 8, 4, 4, 4, 4, 8, 8, 8, 8};
+
+// Bits of the presence column: which keys of the JSON entry are held by the columns
+enum Field : quint32 {
+    HasId = 1u << 0,
+    HasCost = 1u << 1,
+    HasAccess = 1u << 2,
+    HasTitle = 1u << 3,
+    HasSource = 1u << 4,
+    HasPath = 1u << 5,
+    HasHash = 1u << 6,
+    HasMetadata = 1u << 7,
+    HasFormat = 1u << 8,
+    HasWidth = 1u << 9,
+    HasHeight = 1u << 10,
+    HasChannels = 1u << 11,
+    HasBitDepth = 1u << 12,
+    HasRatio = 1u << 13,
+    HasFileSize = 1u << 14,
+    HasModified = 1u << 15
+};
+
+struct ColumnField {
+    Column column;
+    Field field;
+    const char *key;
+};
+
+const ColumnField STRING_FIELDS[] = {
+    {TitleColumn, HasTitle, "title"},
+    {SourceColumn, HasSource, "source"},
+    {PathColumn, HasPath, "Imagepath"},
+    {HashColumn, HasHash, "dhash"}
+};
+
+const ColumnField METADATA_INT_FIELDS[] = {
+    {WidthColumn, HasWidth, "width"},
+    {HeightColumn, HasHeight, "height"},
+    {ChannelsColumn, HasChannels, "channels"},
+    {BitDepthColumn, HasBitDepth, "bitDepth"}
+};
+
+// Location of a UTF-8 string in the heap
+struct StringRef {
+    quint32 offset;
+    quint32 length;
+};
+static_assert(sizeof(StringRef) == 8, "StringRef must stay packed");
+
+quint64 alignTo8(quint64 offset) {
+    return (offset + 7) & ~quint64(7);
+}
+
+bool isInteger(const QJsonValue &value, double minimum, double maximum) {
+    if (!value.isDouble()) {
+        return false;
+    }
+    const double number = value.toDouble();
+    return number >= minimum && number <= maximum && number == std::floor(number);
+}
+
+// The mtime is stored as text in JSON (see Image::metadataToJson); it only goes to a column if it reads back identical.
+bool isInt64Text(const QJsonValue &value, qint64 &number) {
+    if (!value.isString()) {
+        return false;
+    }
+    bool ok = false;
+    number = value.toString().toLongLong(&ok);
+    return ok && QString::number(number) == value.toString();
+}
+
+// True if every key of the image metadata fits a column; otherwise the whole object is kept as JSON.
+bool metadataFitsColumns(const QJsonObject &metadata) {
+    for (auto it = metadata.begin(); it != metadata.end(); ++it) {
+        const QString key = it.key();
+        const QJsonValue value = it.value();
+        qint64 modified;
+        bool fits = false;
+        if (key == "format") {
+            fits = value.isString();
+        } else if (key == "compressionRatio") {
+            fits = value.isDouble();
+        } else if (key == "fileSize") {
+            fits = isInteger(value, 0, 9007199254740992.0);    // Exact in a double
+        } else if (key == "modified") {
+            fits = isInt64Text(value, modified);
+        } else {
+            for (const ColumnField &field : METADATA_INT_FIELDS) {
+                if (key == field.key) {
+                    fits = isInteger(value, std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::max());
+                }
+            }
+        }
+        if (!fits) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Columns being filled by LibraryFile::write, plus a heap where identical strings are stored once.
+class ColumnBuilder {
+public:
+    explicit ColumnBuilder(int rows) : overflow(false) {
+        for (int column = 0; column < ColumnCount; column++) {
+            columns[column] = QByteArray(static_cast<int>(rows * CELL_BYTES[column]), '\0');
+        }
+    }
+
+    template <typename T>
+    void put(int column, int row, const T &value) {
+        memcpy(columns[column].data() + row * sizeof(T), &value, sizeof(T));
+    }
+
+    StringRef intern(const QByteArray &bytes) {
+        if (bytes.isEmpty()) {
+            return StringRef{0, 0};
+        }
+        auto found = interned.constFind(bytes);
+        if (found != interned.constEnd()) {
+            return found.value();
+        }
+        if (static_cast<quint64>(heap.size()) + bytes.size() > std::numeric_limits<quint32>::max()) {
+            overflow = true;
+            return StringRef{0, 0};
+        }
+        const StringRef ref{static_cast<quint32>(heap.size()), static_cast<quint32>(bytes.size())};
+        heap.append(bytes);
+        interned.insert(bytes, ref);
+        return ref;
+    }
+
+    QByteArray columns[ColumnCount];
+    QByteArray heap;
+    QHash<QByteArray, StringRef> interned;
+    bool overflow;
+};
+
+} // namespace
+
+struct LibraryFile::Header {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint64 count;
+    quint64 columns[ColumnCount];    // Offset of each column from the start of the file
+    quint64 heapOffset;
+    quint64 heapSize;
+    StringRef rootExtra;             // Keys of the document other than "library", as compact JSON
+};
+
+LibraryFile::LibraryFile() : data(nullptr), header(nullptr) {}
+
+LibraryFile::~LibraryFile()
+{
+    close();
+}
+
+// Map the file and check its header; nothing else is read until a field is accessed.
+bool LibraryFile::open(const QString &path)
+{
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(Header))) {
+        close();
+        return false;
+    }
+    const quint64 size = static_cast<quint64>(file.size());
+    data = file.map(0, file.size());
+    if (data == nullptr) {
+        qWarning() << "Failed to map the library:" << path << file.errorString();
+        close();
+        return false;
+    }
+
+    const Header *candidate = reinterpret_cast<const Header *>(data);
+    if (memcmp(candidate->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        close();
+        return false; // Not a binary library
+    }
+    bool valid = candidate->version == LIBRARY_FILE_VERSION && candidate->byteOrder == BYTE_ORDER_MARK
+                 && candidate->count <= static_cast<quint64>(std::numeric_limits<int>::max())
+                 && candidate->count <= size
+                 && candidate->heapOffset <= size && candidate->heapSize <= size - candidate->heapOffset
+                 && static_cast<quint64>(candidate->rootExtra.offset) + candidate->rootExtra.length <= candidate->heapSize;
+    for (int column = 0; valid && column < ColumnCount; column++) {
+        const quint64 offset = candidate->columns[column];
+        valid = offset % 8 == 0 && offset <= size && candidate->count * CELL_BYTES[column] <= size - offset;
+    }
+    if (!valid) {
+        qWarning() << "Invalid or unsupported binary library:" << path;
+        close();
+        return false;
+    }
+    header = candidate;
+    return true;
+}
+
+void LibraryFile::close()
+{
+    if (data != nullptr) {
+        file.unmap(const_cast<uchar *>(data));
+    }
+    data = nullptr;
+    header = nullptr;
+    file.close();
+}
+
+bool LibraryFile::isOpen() const
+{
+    return header != nullptr;
+}
+
+int LibraryFile::count() const
+{
+    return header ? static_cast<int>(header->count) : 0;
+}
+
+unsigned int LibraryFile::id(int index) const
+{
+    return has(index, HasId) ? cell<quint32>(IdColumn, index) : extra(index).value("id").toInt();
+}
+
+double LibraryFile::cost(int index) const
+{
+    return has(index, HasCost) ? cell<double>(CostColumn, index) : extra(index).value("cost").toDouble();
+}
+
+char LibraryFile::access(int index) const
+{
+    return has(index, HasAccess) ? cell<char>(AccessColumn, index)
+                                 : extra(index).value("access").toString().toStdString().c_str()[0];
+}
+
+QString LibraryFile::title(int index) const
+{
+    return has(index, HasTitle) ? string(TitleColumn, index) : extra(index).value("title").toString();
+}
+
+QString LibraryFile::source(int index) const
+{
+    return has(index, HasSource) ? string(SourceColumn, index) : extra(index).value("source").toString();
+}
+
+QString LibraryFile::imagePath(int index) const
+{
+    return has(index, HasPath) ? string(PathColumn, index) : extra(index).value("Imagepath").toString();
+}
+
+QString LibraryFile::perceptualHash(int index) const
+{
+    return has(index, HasHash) ? string(HashColumn, index) : extra(index).value("dhash").toString();
+}
+
+// Same object as the "imageMetadata" value of the JSON entry.
+QJsonObject LibraryFile::imageMetadata(int index) const
+{
+    if (!has(index, HasMetadata)) {
+        return extra(index).value("imageMetadata").toObject();
+    }
+    QJsonObject metadata;
+    if (has(index, HasFormat)) {
+        metadata["format"] = string(FormatColumn, index);
+    }
+    for (const ColumnField &field : METADATA_INT_FIELDS) {
+        if (has(index, field.field)) {
+            metadata[field.key] = cell<qint32>(field.column, index);
+        }
+    }
+    if (has(index, HasRatio)) {
+        metadata["compressionRatio"] = cell<double>(RatioColumn, index);
+    }
+    if (has(index, HasFileSize)) {
+        metadata["fileSize"] = static_cast<double>(cell<quint64>(FileSizeColumn, index));
+    }
+    if (has(index, HasModified)) {
+        metadata["modified"] = QString::number(cell<qint64>(ModifiedColumn, index));
+    }
+    return metadata;
+}
+
+// The descriptor as it appears in the JSON layout.
+QJsonObject LibraryFile::entry(int index) const
+{
+    QJsonObject object = extra(index);
+    if (has(index, HasId)) {
+        object["id"] = static_cast<qint64>(cell<quint32>(IdColumn, index));
+    }
+    if (has(index, HasCost)) {
+        object["cost"] = cell<double>(CostColumn, index);
+    }
+    if (has(index, HasAccess)) {
+        object["access"] = QString(QLatin1Char(cell<char>(AccessColumn, index)));
+    }
+    for (const ColumnField &field : STRING_FIELDS) {
+        if (has(index, field.field)) {
+            object[field.key] = string(field.column, index);
+        }
+    }
+    if (has(index, HasMetadata)) {
+        object["imageMetadata"] = imageMetadata(index);
+    }
+    return object;
+}
+
+// The whole library in the JSON layout ({"library": [...]}).
+QJsonObject LibraryFile::toJson() const
+{
+    if (!header) {
+        return QJsonObject();
+    }
+    QJsonObject document;
+    if (header->rootExtra.length > 0) {
+        const char *bytes = reinterpret_cast<const char *>(data + header->heapOffset + header->rootExtra.offset);
+        document = QJsonDocument::fromJson(QByteArray::fromRawData(bytes, header->rootExtra.length)).object();
+    }
+    QJsonArray entries;
+    for (int index = 0; index < count(); index++) {
+        entries.append(entry(index));
+    }
+    if (!document.contains("library")) {
+        document["library"] = entries;
+    }
+    return document;
+}
+
+// True for an existing file starting with the binary signature, or a file yet to be created with the binary suffix.
+bool LibraryFile::isBinary(const QString &path)
+{
+    QFile candidate(path);
+    if (!candidate.exists()) {
+        return QFileInfo(path).suffix().compare(LIBRARY_BINARY_SUFFIX, Qt::CaseInsensitive) == 0;
+    }
+    char magic[sizeof(MAGIC)] = {};
+    return candidate.open(QIODevice::ReadOnly) && candidate.read(magic, sizeof(magic)) == sizeof(magic)
+           && memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+// Convert a library in the JSON layout to a binary file; the previous file is only replaced once the new one is complete.
+bool LibraryFile::write(const QString &path, const QJsonObject &document)
+{
+    static_assert(sizeof(Header) == 184, "The header layout is part of the file format");
+
+    QJsonObject rootExtra = document;
+    QJsonArray entries;
+    if (document.value("library").isArray()) {
+        entries = document.value("library").toArray();
+        rootExtra.remove("library");
+    }
+    const int rows = entries.size();
+    ColumnBuilder builder(rows);
+
+    for (int row = 0; row < rows; row++) {
+        if (!entries[row].isObject()) {
+            qWarning() << "Failed to save the library: entry" << row << "is not an object.";
+            return false;
+        }
+        QJsonObject remaining = entries[row].toObject();
+        quint32 present = 0;
+
+        if (isInteger(remaining.value("id"), 0, std::numeric_limits<quint32>::max())) {
+            builder.put(IdColumn, row, static_cast<quint32>(remaining.take("id").toDouble()));
+            present |= HasId;
+        }
+        if (remaining.value("cost").isDouble()) {
+            builder.put(CostColumn, row, remaining.take("cost").toDouble());
+            present |= HasCost;
+        }
+        const QString access = remaining.value("access").toString();
+        if (remaining.value("access").isString() && access.size() == 1 && access[0].unicode() < 128) {
+            builder.put(AccessColumn, row, static_cast<char>(access[0].unicode()));
+            remaining.remove("access");
+            present |= HasAccess;
+        }
+        for (const ColumnField &field : STRING_FIELDS) {
+            if (remaining.value(field.key).isString()) {
+                builder.put(field.column, row, builder.intern(remaining.take(field.key).toString().toUtf8()));
+                present |= field.field;
+            }
+        }
+
+        const QJsonObject metadata = remaining.value("imageMetadata").toObject();
+        if (remaining.value("imageMetadata").isObject() && metadataFitsColumns(metadata)) {
+            present |= HasMetadata;
+            if (metadata.contains("format")) {
+                builder.put(FormatColumn, row, builder.intern(metadata["format"].toString().toUtf8()));
+                present |= HasFormat;
+            }
+            for (const ColumnField &field : METADATA_INT_FIELDS) {
+                if (metadata.contains(field.key)) {
+                    builder.put(field.column, row, static_cast<qint32>(metadata[field.key].toDouble()));
+                    present |= field.field;
+                }
+            }
+            if (metadata.contains("compressionRatio")) {
+                builder.put(RatioColumn, row, metadata["compressionRatio"].toDouble());
+                present |= HasRatio;
+            }
+            if (metadata.contains("fileSize")) {
+                builder.put(FileSizeColumn, row, static_cast<quint64>(metadata["fileSize"].toDouble()));
+                present |= HasFileSize;
+            }
+            qint64 modified;
+            if (isInt64Text(metadata["modified"], modified)) {
+                builder.put(ModifiedColumn, row, modified);
+                present |= HasModified;
+            }
+            remaining.remove("imageMetadata");
+        }
+
+        builder.put(PresentColumn, row, present);
+        if (!remaining.isEmpty()) {
+            builder.put(ExtraColumn, row, builder.intern(QJsonDocument(remaining).toJson(QJsonDocument::Compact)));
+        }
+    }
+
+    Header layout;
+    memset(&layout, 0, sizeof(layout));
+    memcpy(layout.magic, MAGIC, sizeof(MAGIC));
+    layout.version = LIBRARY_FILE_VERSION;
+    layout.byteOrder = BYTE_ORDER_MARK;
+    layout.count = static_cast<quint64>(rows);
+    if (!rootExtra.isEmpty()) {
+        layout.rootExtra = builder.intern(QJsonDocument(rootExtra).toJson(QJsonDocument::Compact));
+    }
+    if (builder.overflow) {
+        qWarning() << "Failed to save the library: the strings exceed 4 GB.";
+        return false;
+    }
+    quint64 offset = alignTo8(sizeof(Header));
+    for (int column = 0; column < ColumnCount; column++) {
+        layout.columns[column] = offset;
+        offset = alignTo8(offset + builder.columns[column].size());
+    }
+    layout.heapOffset = offset;
+    layout.heapSize = static_cast<quint64>(builder.heap.size());
+
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save the library:" << path << out.errorString();
+        return false;
+    }
+    quint64 written = sizeof(Header);
+    out.write(reinterpret_cast<const char *>(&layout), sizeof(layout));
+    for (int column = 0; column < ColumnCount; column++) {
+        out.write(QByteArray(static_cast<int>(layout.columns[column] - written), '\0'));
+        out.write(builder.columns[column]);
+        written = layout.columns[column] + builder.columns[column].size();
+    }
+    out.write(QByteArray(static_cast<int>(layout.heapOffset - written), '\0'));
+    out.write(builder.heap);
+    return out.commit();
+}
+
+template <typename T>
+const T &LibraryFile::cell(int column, int index) const
+{
+    return reinterpret_cast<const T *>(data + header->columns[column])[index];
+}
+
+bool LibraryFile::has(int index, quint32 field) const
+{
+    return (cell<quint32>(PresentColumn, index) & field) != 0;
+}
+
+QString LibraryFile::string(int column, int index) const
+{
+    const StringRef &ref = cell<StringRef>(column, index);
+    if (static_cast<quint64>(ref.offset) + ref.length > header->heapSize) {
+        return QString();
+    }
+    return QString::fromUtf8(reinterpret_cast<const char *>(data + header->heapOffset + ref.offset), ref.length);
+}
+
+// Keys of the entry that are not held by the columns (usually none).
+QJsonObject LibraryFile::extra(int index) const
+{
+    const StringRef &ref = cell<StringRef>(ExtraColumn, index);
+    if (ref.length == 0 || static_cast<quint64>(ref.offset) + ref.length > header->heapSize) {
+        return QJsonObject();
+    }
+    const char *bytes = reinterpret_cast<const char *>(data + header->heapOffset + ref.offset);
+    return QJsonDocument::fromJson(QByteArray::fromRawData(bytes, ref.length)).object();
+}
+
+// Read a library in either layout, as a JSON document ({"library": [...]}).
+QJsonObject readLibraryDocument(const QString &path, bool *ok)
+{
+    if (ok) {
+        *ok = false;
+    }
+    if (LibraryFile::isBinary(path)) {
+        LibraryFile library;
+        if (!library.open(path)) {
+            return QJsonObject();
+        }
+        if (ok) {
+            *ok = true;
+        }
+        return library.toJson();
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (ok) {
+        *ok = error.error == QJsonParseError::NoError && document.isObject();
+    }
+    return document.object();
+}
+
+// Write a library in the layout of the existing file (for a new file, binary if it has the binary suffix).
+bool writeLibraryDocument(const QString &path, const QJsonObject &document)
+{
+    if (LibraryFile::isBinary(path)) {
+        return LibraryFile::write(path, document);
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(document).toJson());
+    file.close();
+    return true;
+}
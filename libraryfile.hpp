@@ -0,0 +1,65 @@
+#ifndef LIBRARYFILE_HPP
+#define LIBRARYFILE_HPP
+
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <QtGlobal>
+
+// Version of the binary library layout, checked when a file is opened.
+const quint32 LIBRARY_FILE_VERSION = 1;
+// Suffix of binary library files; any other suffix is written as JSON.
+const QString LIBRARY_BINARY_SUFFIX = "lib";
+
+// Binary library file, memory-mapped and read in place: opening it only validates the header, whatever the
+// number of descriptors. Each field is a column (one array per field) and strings live in a shared heap, so
+// reading a descriptor touches a few cache lines and nothing is parsed.
+//
+// Conversion from and to the JSON layout ({"library": [...]}) is lossless: values the columns cannot hold
+// exactly (unknown keys, unexpected types) are kept as compact JSON in a per-descriptor extra column.
+class LibraryFile {
+public:
+    LibraryFile();
+    ~LibraryFile();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    int count() const;
+
+    unsigned int id(int index) const;
+    double cost(int index) const;
+    char access(int index) const;
+    QString title(int index) const;
+    QString source(int index) const;
+    QString imagePath(int index) const;
+    QString perceptualHash(int index) const;
+    QJsonObject imageMetadata(int index) const;
+
+    QJsonObject entry(int index) const;
+    QJsonObject toJson() const;
+
+    static bool isBinary(const QString &path);
+    static bool write(const QString &path, const QJsonObject &document);
+
+private:
+    struct Header;
+
+    LibraryFile(const LibraryFile &) = delete;
+    LibraryFile &operator=(const LibraryFile &) = delete;
+
+    template <typename T>
+    const T &cell(int column, int index) const;
+    bool has(int index, quint32 field) const;
+    QString string(int column, int index) const;
+    QJsonObject extra(int index) const;
+
+    QFile file;
+    const uchar *data;
+    const Header *header;
+};
+
+QJsonObject readLibraryDocument(const QString &path, bool *ok = nullptr);
+bool writeLibraryDocument(const QString &path, const QJsonObject &document);
+
+#endif // LIBRARYFILE_HPP
@@ -0,0 +1,99 @@
+#include "libraryloader.hpp"
+#include <QMutexLocker>
+#include <QRunnable>
+#include <functional>
+
+namespace {
+
+// QRunnable::create is only available from Qt 5.15
+class Task : public QRunnable {
+public:
+    explicit Task(std::function<void()> body) : body(std::move(body)) {}
+    void run() override { body(); }
+
+private:
+    std::function<void()> body;
+};
+
+void deleteDescriptors(Descriptor *head) {
+    while (head != nullptr) {
+        Descriptor *next = head->getNextDescriptor();
+        delete head;
+        head = next;
+    }
+}
+
+} // namespace
+
+LibraryLoader::LibraryLoader(QObject *parent)
+    : QObject(parent), resultTicket(-1), currentTicket(0)
+{
+    // Loads are served one at a time; each one is spread over the shared ThreadPool
+    pool.setMaxThreadCount(1);
+}
+
+LibraryLoader::~LibraryLoader()
+{
+    currentTicket++;
+    pool.waitForDone();
+    QMutexLocker locker(&mutex);
+    if (result) {
+        deleteDescriptors(result->getHead());
+    }
+}
+
+// Start loading the library at path; the returned ticket identifies it in progress() and loaded().
+int LibraryLoader::load(const User &user, const QString &path)
+{
+    const int ticket = ++currentTicket;
+    pool.start(new Task([this, ticket, user, path]() { run(ticket, user, path); }));
+    return ticket;
+}
+
+// The library loaded for ticket, or null if it was superseded or already taken. refreshedMetadata receives the
+// image metadata (by descriptor id) that should be written back to the library file.
+std::unique_ptr<ManageLibrary> LibraryLoader::takeLibrary(int ticket, QHash<int, QJsonObject> *refreshedMetadata)
+{
+    QMutexLocker locker(&mutex);
+    if (ticket != resultTicket) {
+        return nullptr;
+    }
+    resultTicket = -1;
+    if (refreshedMetadata) {
+        *refreshedMetadata = resultMetadata;
+    }
+    resultMetadata.clear();
+    return std::move(result);
+}
+
+void LibraryLoader::run(int ticket, const User &user, const QString &path)
+{
+    if (ticket != currentTicket.load()) {
+        return; // A newer library was requested before this one started
+    }
+    bool ok;
+    QHash<int, QJsonObject> refreshedMetadata;
+    ManageLibrary library = user.loadLibrary(path, [this, ticket](int done, int total) {
+        emit progress(ticket, done, total);
+    }, &ok, &refreshedMetadata);
+
+    {
+        QMutexLocker locker(&mutex);
+        if (result) {
+            deleteDescriptors(result->getHead()); // Never taken
+        }
+        result.reset();
+        resultMetadata.clear();
+        resultTicket = -1;
+        if (ticket != currentTicket.load()) {
+            deleteDescriptors(library.getHead());
+            return;
+        }
+        if (ok) {
+            result.reset(new ManageLibrary(library));
+            resultMetadata = refreshedMetadata;
+            resultTicket = ticket;
+        }
+    }
+    emit loaded(ticket, ok);
+}
@@ -0,0 +1,42 @@
+#ifndef LIBRARYLOADER_HPP
+#define LIBRARYLOADER_HPP
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include "user.hpp"
+
+// Loads a library file on a background thread so the window stays responsive, reporting progress as it goes.
+// Only the latest request is delivered: a library whose load was superseded is freed when it finishes.
+// Nothing is written from the worker: metadata refreshed during the load comes back with the library.
+class LibraryLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit LibraryLoader(QObject *parent = nullptr);
+    ~LibraryLoader();
+
+    int load(const User &user, const QString &path);
+    std::unique_ptr<ManageLibrary> takeLibrary(int ticket, QHash<int, QJsonObject> *refreshedMetadata = nullptr);
+
+signals:
+    // Both are emitted from a worker thread, so connections to widgets are queued.
+    void progress(int ticket, int done, int total);
+    // ok is false when the library file could not be read; there is then no library to take.
+    void loaded(int ticket, bool ok);
+
+private:
+    void run(int ticket, const User &user, const QString &path);
+
+    QThreadPool pool;
+    QMutex mutex;
+    std::unique_ptr<ManageLibrary> result;
+    QHash<int, QJsonObject> resultMetadata;
+    int resultTicket;
+    std::atomic<int> currentTicket;
+};
+
+#endif // LIBRARYLOADER_HPP
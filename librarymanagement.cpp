@@ -15,8 +15,12 @@
 #include <QLabel>
 #include <QCoreApplication>
 #include <QDir>
+#include <QMap>
+#include <set>
+#include "libraryfile.hpp"
+#include "threadpool.hpp"
 
-ManageLibrary::ManageLibrary(int acces, Descriptor* head,QString libraryPath): acces(acces), head(head) , libraryPath(libraryPath) {};
+ManageLibrary::ManageLibrary(int acces, Descriptor* head,QString libraryPath): acces(acces), head(head) , libraryPath(libraryPath), visualIndex(make_shared<VisualIndex>()), duplicateIndex(make_shared<DuplicateIndex>()) {};
 
 Descriptor* ManageLibrary::getDescriptor(unsigned int idDesc) const {
     Descriptor* current = head;
@@ -135,18 +139,15 @@ void ManageLibrary::deleteDescriptor(Descriptor* descriptorToDelete) {
 
     qDebug() << "Deleting descriptor: " << descriptorToDelete->getIdDescriptor();
 
-    QFile file(libraryPath);
-    if (!file.open(QIODevice::ReadOnly)) {
+    // Read the existing library (JSON or binary)
+    bool readOk = false;
+    QJsonObject obj = readLibraryDocument(libraryPath, &readOk);
+    if (!readOk) {
         qDebug() << "Error: Could not open file";
         return;
     }
     QString appPath = QCoreApplication::applicationDirPath();
 
-    // Read the existing JSON file
-    QByteArray data = file.readAll();
-    file.close();
-    QJsonDocument doc(QJsonDocument::fromJson(data));
-    QJsonObject obj = doc.object();
     QJsonArray array = obj["library"].toArray();
     QJsonArray newArray;
 
@@ -161,12 +162,10 @@ void ManageLibrary::deleteDescriptor(Descriptor* descriptorToDelete) {
     }
     obj["library"] = newArray;
 
-    if (!file.open(QIODevice::WriteOnly)) {
+    if (!writeLibraryDocument(libraryPath, obj)) {
         qDebug() << "Error: Could not open file";
         return;
     }
-    file.write(QJsonDocument(obj).toJson());
-    file.close();
 
     // Delete the image file associated with the descriptor
     if (!imagePathToDelete.isEmpty()) {
@@ -194,6 +193,9 @@ void ManageLibrary::deleteDescriptor(Descriptor* descriptorToDelete) {
             } else {
                 previous->setNextDescriptor(current->getNextDescriptor());
             }
+            if (duplicateIndex->built) {
+                duplicateIndex->tree.remove(current->getIdDescriptor());
+            }
             delete current;
             qDebug() << "Descriptor removed from in-memory library";
             return;
@@ -206,8 +208,9 @@ void ManageLibrary::deleteDescriptor(Descriptor* descriptorToDelete) {
 }
 
 ManageLibrary ManageLibrary::orderDescriptorsByCostDescending() {
-    // Create a new library to hold the ordered descriptors
-    ManageLibrary orderedLibrary = ManageLibrary(0, nullptr,"");
+    // Create a new library to hold the ordered descriptors (same file, access and visual index)
+    ManageLibrary orderedLibrary = *this;
+    orderedLibrary.head = nullptr;
 
     // Traverse the current library and insert each descriptor into the new library in sorted order
     Descriptor* current = head;
@@ -239,8 +242,9 @@ void ManageLibrary::insertDescriptorInOrder(ManageLibrary& library, Descriptor*
     }
 }
 ManageLibrary ManageLibrary::orderDescriptorsByCostAscending() {
-    // Create a new library to hold the ordered descriptors
-    ManageLibrary orderedLibrary = ManageLibrary(0, nullptr,"");
+    // Create a new library to hold the ordered descriptors (same file, access and visual index)
+    ManageLibrary orderedLibrary = *this;
+    orderedLibrary.head = nullptr;
 
     // Traverse the current library and insert each descriptor into the new library in sorted order
     Descriptor* current = head;
@@ -323,11 +327,15 @@ void ManageLibrary::saveLibraryToJson(QString libraryName) {
 
         // Add each property to the JSON object
         descriptorObject["Imagepath"] = current->getImage().getPath(); // Assuming Image class has getImagePath()
+        descriptorObject["imageMetadata"] = current->getImage().metadataToJson();
         descriptorObject["access"] = QString(current->getAccess());         // Convert char to QString
         descriptorObject["cost"] = current->getCost();
         descriptorObject["id"] = static_cast<int>(current->getIdDescriptor());
         descriptorObject["source"] = current->getSource();
         descriptorObject["title"] = current->getTitle();
+        if (!current->getPerceptualHash().isEmpty()) {
+            descriptorObject["dhash"] = current->getPerceptualHash();
+        }
         
 
         // Append the object to the array
@@ -381,3 +389,214 @@ Descriptor* ManageLibrary::getDescriptorsBetweenMaxMinCost(double maxCost, doubl
 
     return newHead;
 }
+
+// Brings the visual index in line with the descriptors of the library: the saved index is loaded once,
+// then only descriptors that are not indexed yet are processed (in parallel), and deleted ones are dropped.
+// May run on any thread, as long as nothing else uses the index meanwhile; progress is that of addImages.
+void updateVisualIndex(const VisualIndexUpdate& update, const function<void(int, int)>& progress) {
+    VisualIndex& visualIndex = *update.index;
+    if (!visualIndex.hasVocabulary() && !update.indexPath.empty()) {
+        visualIndex.load(update.indexPath);
+    }
+
+    set<unsigned int> present;
+    vector<pair<unsigned int, string>> missing;
+    for (const pair<unsigned int, string>& image : update.images) {
+        present.insert(image.first);
+        if (!visualIndex.contains(image.first)) {
+            missing.push_back(image);
+        }
+    }
+
+    bool changed = !missing.empty();
+    for (unsigned int id : visualIndex.imageIds()) {
+        if (present.count(id) == 0) {
+            visualIndex.removeImage(id);
+            changed = true;
+        }
+    }
+    if (!missing.empty()) {
+        visualIndex.addImages(missing, progress);
+    }
+    if (changed && !update.indexPath.empty() && !visualIndex.save(update.indexPath)) {
+        qWarning() << "Failed to save the visual index.";
+    }
+}
+
+// The descriptors of the library and its shared index, for updateVisualIndex.
+VisualIndexUpdate ManageLibrary::prepareVisualIndexUpdate() const {
+    QString appPath = QCoreApplication::applicationDirPath();
+    VisualIndexUpdate update;
+    update.index = visualIndex;
+    if (!libraryPath.isEmpty()) {
+        update.indexPath = (libraryPath + QString::fromStdString(VISUAL_INDEX_EXTENSION)).toStdString();
+    }
+    for (Descriptor* current = head; current != nullptr; current = current->getNextDescriptor()) {
+        update.images.emplace_back(current->getIdDescriptor(), (appPath + current->getImage().getPath()).toStdString());
+    }
+    return update;
+}
+
+// True when the visual index holds exactly the descriptors of the library, so a search needs no update.
+bool ManageLibrary::isVisualIndexReady() const {
+    if (!visualIndex->hasVocabulary()) {
+        return false;
+    }
+    size_t count = 0;
+    for (Descriptor* current = head; current != nullptr; current = current->getNextDescriptor()) {
+        if (!visualIndex->contains(current->getIdDescriptor())) {
+            return false;
+        }
+        count++;
+    }
+    return count == visualIndex->size();
+}
+
+// Adds the perceptual hash of a descriptor that was just saved to the duplicate index, if it is built yet.
+void ManageLibrary::addPerceptualHash(unsigned int id, const QString& perceptualHash) {
+    uint64_t hash;
+    if (duplicateIndex->built && hashFromHex(perceptualHash.toStdString(), hash)) {
+        duplicateIndex->tree.insert(hash, id);
+    }
+}
+
+// Adds a descriptor that was just saved to the library file to the saved visual index, so that searches do
+// not have to index it later. Before the first search there is no vocabulary yet: that search indexes
+// the whole library, including this descriptor.
+void ManageLibrary::indexDescriptor(unsigned int id, const QString& imagePath) {
+    if (libraryPath.isEmpty()) {
+        return;
+    }
+    string indexPath = (libraryPath + QString::fromStdString(VISUAL_INDEX_EXTENSION)).toStdString();
+    if (!visualIndex->hasVocabulary() && !visualIndex->load(indexPath)) {
+        return;
+    }
+
+    QString appPath = QCoreApplication::applicationDirPath();
+    try {
+        visualIndex->addImage(id, siftFeaturesFor((appPath + imagePath).toStdString()));
+    } catch (const exception& e) {
+        qWarning() << "Could not index" << imagePath << ":" << e.what();
+        return;
+    }
+    if (!visualIndex->save(indexPath)) {
+        qWarning() << "Failed to save the visual index.";
+    }
+}
+
+// Returns copies of the descriptors whose images look the most like the image of descriptor `id`,
+// most similar first (the descriptor itself is not included). The index is queried as it is: bring it up to
+// date first (see isVisualIndexReady).
+Descriptor* ManageLibrary::getSimilarDescriptors(unsigned int id, int maxResults) {
+    Descriptor* newHead = nullptr;
+    Descriptor* newTail = nullptr;
+    for (const SimilarImage& match : visualIndex->querySimilar(id, static_cast<size_t>(maxResults))) {
+        Descriptor* found = searchDescriptor(match.id);
+        if (found == nullptr) {
+            continue;
+        }
+        Descriptor* newDescriptor = new Descriptor(*found);
+        newDescriptor->setNextDescriptor(nullptr);
+
+        if (newHead == nullptr) {
+            newHead = newDescriptor;
+            newTail = newDescriptor;
+        } else {
+            newTail->setNextDescriptor(newDescriptor);
+            newTail = newDescriptor;
+        }
+    }
+    return newHead;
+}
+
+// Keeps the indexes of another copy of the same library (typically the one shown before it was reloaded), so
+// that they are not rebuilt. Both must describe the same file.
+void ManageLibrary::shareIndexes(const ManageLibrary& library) {
+    visualIndex = library.visualIndex;
+    duplicateIndex = library.duplicateIndex;
+}
+
+// Descriptors whose image is within `radius` bits of `hash`, as (id, distance). The tree is built from the
+// descriptors in memory on the first call; later calls only walk it.
+vector<pair<unsigned int, int>> ManageLibrary::findNearDuplicates(uint64_t hash, int radius) {
+    // A library that is still loading has no descriptors yet: nothing is marked as built until it has some
+    if (!duplicateIndex->built && head != nullptr) {
+        vector<Descriptor*> descriptors;
+        for (Descriptor* current = head; current != nullptr; current = current->getNextDescriptor()) {
+            descriptors.push_back(current);
+        }
+        hashUnhashedDescriptors(descriptors);
+        for (Descriptor* descriptor : descriptors) {
+            uint64_t existing;
+            if (hashFromHex(descriptor->getPerceptualHash().toStdString(), existing)) {
+                duplicateIndex->tree.insert(existing, descriptor->getIdDescriptor());
+            }
+        }
+        duplicateIndex->built = true;
+    }
+    return duplicateIndex->tree.search(hash, radius);
+}
+
+// Scans the whole library for near-duplicate images.
+vector<DuplicatePair> ManageLibrary::findDuplicateDescriptors(int radius) {
+    vector<Descriptor*> descriptors;
+    for (Descriptor* current = head; current != nullptr; current = current->getNextDescriptor()) {
+        descriptors.push_back(current);
+    }
+    hashUnhashedDescriptors(descriptors);
+
+    vector<pair<unsigned int, uint64_t>> hashes;
+    for (Descriptor* descriptor : descriptors) {
+        uint64_t hash;
+        if (hashFromHex(descriptor->getPerceptualHash().toStdString(), hash)) {
+            hashes.emplace_back(descriptor->getIdDescriptor(), hash);
+        }
+    }
+    return findDuplicates(hashes, radius);
+}
+
+// Descriptors saved before perceptual hashes existed get theirs computed here (in parallel, from a reduced
+// decode of their file) and written back to the library, so this happens once per library.
+void ManageLibrary::hashUnhashedDescriptors(const vector<Descriptor*>& descriptors) {
+    QString appPath = QCoreApplication::applicationDirPath();
+    vector<char> computed(descriptors.size(), 0);
+    ThreadPool::instance().parallelFor(static_cast<int>(descriptors.size()), [&](int i) {
+        uint64_t hash;
+        if (hashFromHex(descriptors[i]->getPerceptualHash().toStdString(), hash)) {
+            return;
+        }
+        try {
+            hash = differenceHashOfFile((appPath + descriptors[i]->getImage().getPath()).toStdString());
+        } catch (const exception&) {
+            return; // Unreadable image: it cannot be compared
+        }
+        descriptors[i]->setPerceptualHash(QString::fromStdString(hashToHex(hash)));
+        computed[i] = 1;
+    });
+
+    QMap<int, QString> newHashes;
+    for (size_t i = 0; i < descriptors.size(); i++) {
+        if (computed[i]) {
+            newHashes[static_cast<int>(descriptors[i]->getIdDescriptor())] = descriptors[i]->getPerceptualHash();
+        }
+    }
+
+    if (!newHashes.isEmpty() && !libraryPath.isEmpty()) {
+        bool readOk = false;
+        QJsonObject obj = readLibraryDocument(libraryPath, &readOk);
+        if (readOk) {
+            QJsonArray array = obj["library"].toArray();
+            for (int i = 0; i < array.size(); i++) {
+                QJsonObject entry = array[i].toObject();
+                if (newHashes.contains(entry["id"].toInt())) {
+                    entry["dhash"] = newHashes[entry["id"].toInt()];
+                    array[i] = entry;
+                }
+            }
+            obj["library"] = array;
+            if (!writeLibraryDocument(libraryPath, obj)) {
+                qWarning() << "Failed to save the perceptual hashes: Unable to open file.";
+            }
+        }
+    }
+}
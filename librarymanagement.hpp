@@ -3,10 +3,27 @@
 
 #include <QString>
 #include <math.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include "descriptor.hpp"
+#include "visualindex.hpp"
+#include "imagehash.hpp"
 
 using namespace std;
 
+// What a visual index update needs, taken from the library on the GUI thread so that the update itself can
+// run on a worker thread (see VisualIndexBuilder).
+struct VisualIndexUpdate {
+    shared_ptr<VisualIndex> index;
+    string indexPath;                               // empty for a library that is not saved yet
+    vector<pair<unsigned int, string>> images;      // (id, full image path) of every descriptor
+};
+
+void updateVisualIndex(const VisualIndexUpdate& update, const function<void(int, int)>& progress = nullptr);
+
 
 class ManageLibrary {
 
@@ -14,6 +31,17 @@ private:
     int acces;
     Descriptor* head ;
     QString libraryPath;
+    // Shared with the sorted copies of the library; loaded from disk (or built) on the first similarity search.
+    shared_ptr<VisualIndex> visualIndex;
+    // Perceptual hashes of the descriptors, shared the same way; built on the first duplicate check, then kept
+    // up to date as descriptors are added and deleted.
+    struct DuplicateIndex {
+        HashTree tree;
+        bool built = false;
+    };
+    shared_ptr<DuplicateIndex> duplicateIndex;
+
+    void hashUnhashedDescriptors(const vector<Descriptor*>& descriptors);
 
 
 public:
@@ -50,6 +78,15 @@ public:
 
     Descriptor* getDescriptorsBetweenMaxMinCost(double maxCost, double minCost);
 
+    VisualIndexUpdate prepareVisualIndexUpdate() const;
+    bool isVisualIndexReady() const;
+    void indexDescriptor(unsigned int id, const QString& imagePath);
+    void addPerceptualHash(unsigned int id, const QString& perceptualHash);
+    void shareIndexes(const ManageLibrary& library);
+    Descriptor* getSimilarDescriptors(unsigned int id, int maxResults = 12);
+    vector<pair<unsigned int, int>> findNearDuplicates(uint64_t hash, int radius = DUPLICATE_HAMMING_RADIUS);
+    vector<DuplicatePair> findDuplicateDescriptors(int radius = DUPLICATE_HAMMING_RADIUS);
+
 
 
 };
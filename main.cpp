@@ -1,11 +1,17 @@
 #include "mainwindow.h"
 #include "loginwindow.hpp"
 #include "user.hpp"
+#include "benchmark.hpp"
 #include <QApplication>
 #include <QLoggingCategory>
 
 int main(int argc, char *argv[])
 {
+    // Run the image processing benchmarks without starting the GUI
+    if (argc == 3 && std::string(argv[1]) == "--benchmark") {
+        return runBenchmarks(argv[2]);
+    }
+
     QApplication a(argc, argv);
     QLoggingCategory::setFilterRules("*.debug=false");
 
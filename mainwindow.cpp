@@ -2,6 +2,7 @@
 #include "loginwindow.hpp"
 #include "./ui_mainwindow.h"
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QDebug>
 #include <QLabel>
 #include <QPixmap>
@@ -11,12 +12,19 @@
 #include "librarymanagement.hpp"
 #include "descriptor.hpp"
 #include "add_new_descriptor.hpp"
+#include "thumbnailcache.hpp"
+#include "libraryfile.hpp"
+#include <QListView>
+#include <QCursor>
 #include <QJsonObject>
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QCoreApplication>
+#include <QApplication>
+#include <QSet>
 #include <QJsonDocument>
+#include <algorithm>
 
 
 
@@ -38,9 +46,36 @@ MainWindow::MainWindow(User user, QWidget *parent, ManageLibrary mainlibrary, Ma
         ui->menubar->setVisible(false);
     }
 
-    // Initialize the grid layout
-    gridLayout = new QGridLayout();
-    ui->librariesLayout->setLayout(gridLayout); 
+    // Thumbnails are kept on disk across sessions, so reopening a library decodes nothing
+    ThumbnailCache::instance().open((QCoreApplication::applicationDirPath() + "/Cache/Thumbnails").toStdString());
+
+    // The grid is a list view: only the cells in view are painted, thumbnails are decoded in the background
+    descriptorModel = new DescriptorListModel(this);
+    descriptorDelegate = new DescriptorDelegate(currentUser.access, this);
+    ui->descriptorView->setModel(descriptorModel);
+    ui->descriptorView->setItemDelegate(descriptorDelegate);
+    connect(ui->descriptorView, &QListView::clicked, this, &MainWindow::onDescriptorClicked);
+
+    // Libraries are loaded in the background; progress is shown in the status bar
+    libraryLoader = new LibraryLoader(this);
+    libraryLoadTicket = -1;
+    libraryLoadProgress = new QProgressBar(this);
+    libraryLoadProgress->setMaximumWidth(200);
+    libraryLoadProgress->setVisible(false);
+    ui->statusbar->addPermanentWidget(libraryLoadProgress);
+    connect(libraryLoader, &LibraryLoader::progress, this, &MainWindow::onLibraryLoadProgress, Qt::QueuedConnection);
+    connect(libraryLoader, &LibraryLoader::loaded, this, &MainWindow::onLibraryLoaded, Qt::QueuedConnection);
+
+    // The visual index is built in the background too; the similarity search waits for it
+    visualIndexBuilder = new VisualIndexBuilder(this);
+    visualIndexTicket = -1;
+    pendingSimilarId = 0;
+    visualIndexProgress = new QProgressBar(this);
+    visualIndexProgress->setMaximumWidth(200);
+    visualIndexProgress->setVisible(false);
+    ui->statusbar->addPermanentWidget(visualIndexProgress);
+    connect(visualIndexBuilder, &VisualIndexBuilder::progress, this, &MainWindow::onVisualIndexProgress, Qt::QueuedConnection);
+    connect(visualIndexBuilder, &VisualIndexBuilder::built, this, &MainWindow::onVisualIndexBuilt, Qt::QueuedConnection);
     loadLibrariesButtons();
     ui->LogoutButton->setVisible(true);
 
@@ -157,13 +192,51 @@ void MainWindow::loadLibrariesButtons()
 void MainWindow::on_actionLoad_a_Library_triggered()
 {
     // Enter the library to import
-    QString path = QFileDialog::getOpenFileName(this, "Open Library", "", "JSON files (*.json)");
+    QString path = QFileDialog::getOpenFileName(this, "Open Library", "", "Libraries (*.json *.lib);;JSON files (*.json);;Binary libraries (*.lib)");
     // print the path in the terminal
     // qDebug() << path;
     // show the library
     LoadTheLibrary(path);
 }
 
+void MainWindow::on_actionSave_Library_As_triggered()
+{
+    // Convert the current library between JSON and the memory-mapped binary layout (chosen by the suffix)
+    if (currentLibraryPath.isEmpty())
+    {
+        QMessageBox::warning(this, "Save Library", "No library is open.");
+        return;
+    }
+    QString savePath = QFileDialog::getSaveFileName(this, "Save Library As", "",
+                                                    "Binary libraries (*.lib);;JSON files (*.json)");
+    if (savePath.isEmpty())
+    {
+        return;
+    }
+    if (QFileInfo(savePath).suffix().isEmpty())
+    {
+        savePath.append("." + LIBRARY_BINARY_SUFFIX);
+    }
+
+    bool readOk = false;
+    const QJsonObject document = readLibraryDocument(currentLibraryPath, &readOk);
+    if (!readOk)
+    {
+        QMessageBox::warning(this, "Save Library", "Could not read the current library.");
+        return;
+    }
+    // An existing file is replaced in the layout chosen by the suffix, not the one it had
+    if (QFile::exists(savePath) && !QFile::remove(savePath))
+    {
+        QMessageBox::warning(this, "Save Library", "Could not replace " + savePath + ".");
+        return;
+    }
+    if (!writeLibraryDocument(savePath, document))
+    {
+        QMessageBox::warning(this, "Save Library", "Could not write " + savePath + ".");
+    }
+}
+
 void MainWindow::setCurrentLibraryPath(QString path){
     this->currentLibraryPath = path;
 }
@@ -172,8 +245,64 @@ void MainWindow::LoadTheLibrary(QString path)
 {
     this->setCurrentLibraryPath(path);
 
-    // Reload the library from the file system
-    ManageLibrary library = currentUser.loadLibrary(path);
+    // Images may have changed on disk since the library was last shown (the disk cache checks them again)
+    descriptorModel->clearThumbnails();
+
+    // Reload the library from the file system without blocking the window; the grid is filled in onLibraryLoaded
+    clearGridLayout();
+    ManageLibrary loading(1, nullptr, path);
+    if (path == mainlibrary.getLibraryPath())
+    {
+        loading.shareIndexes(mainlibrary); // Same file reloaded: its duplicate and visual indexes are still valid
+    }
+    mainlibrary = loading;
+    libraryLoadTicket = libraryLoader->load(currentUser, path);
+    libraryLoadProgress->setRange(0, 0);
+    libraryLoadProgress->setVisible(true);
+    ui->statusbar->showMessage("Loading library...");
+}
+
+void MainWindow::onLibraryLoadProgress(int ticket, int done, int total)
+{
+    if (ticket != libraryLoadTicket)
+    {
+        return; // Progress of a library that was replaced in the meantime
+    }
+    libraryLoadProgress->setRange(0, total);
+    libraryLoadProgress->setValue(done);
+}
+
+void MainWindow::onLibraryLoaded(int ticket, bool ok)
+{
+    if (ticket != libraryLoadTicket)
+    {
+        return; // The loader frees libraries nobody takes
+    }
+    libraryLoadProgress->setVisible(false);
+    if (!ok)
+    {
+        ui->statusbar->showMessage("Could not open the library " + currentLibraryPath);
+        return;
+    }
+    QHash<int, QJsonObject> refreshedMetadata;
+    std::unique_ptr<ManageLibrary> loaded = libraryLoader->takeLibrary(ticket, &refreshedMetadata);
+    if (!loaded)
+    {
+        return;
+    }
+    ui->statusbar->clearMessage();
+
+    // Written here rather than by the loader so it never races a save of the same file
+    if (!refreshedMetadata.isEmpty() && !currentUser.saveImageMetadata(loaded->getLibraryPath(), refreshedMetadata))
+    {
+        qWarning() << "Failed to save the image metadata of" << loaded->getLibraryPath();
+    }
+
+    ManageLibrary library = *loaded;
+    if (library.getLibraryPath() == mainlibrary.getLibraryPath())
+    {
+        library.shareIndexes(mainlibrary);
+    }
     mainlibrary = library;
 
     // qDebug() << "Library Created";
@@ -212,231 +341,104 @@ void MainWindow::LoadTheLibrary(QString path)
 
 void MainWindow::clearGridLayout()
 {
-    while (QLayoutItem *item = gridLayout->takeAt(0))
-    {
-        if (QWidget *widget = item->widget())
-        {
-            widget->deleteLater(); // Ensure proper deletion of the widget
-        }
-        delete item; // Delete the layout item
-    }
+    descriptorModel->setDescriptors(QVector<Descriptor*>());
 }
 
 void MainWindow::populateGridLayout(Descriptor *head)
 {
-    int row = 0;
-    int col = 0;
-    Descriptor *current = head;
-    QString appPath = QCoreApplication::applicationDirPath();
-
-    while (current != nullptr)
+    QVector<Descriptor*> descriptors;
+    for (Descriptor *current = head; current != nullptr; current = current->getNextDescriptor())
     {
-        if(current->getAccess() == 'L' && !currentUser.access){
-            current = current->getNextDescriptor();
-            continue;
-        }
-        // Create a vertical layout for each cell
-        QVBoxLayout *cellLayout = new QVBoxLayout();
-        cellLayout->setContentsMargins(10, 10, 10, 10);
-        cellLayout->setSpacing(10);
-
-        // Create and add the image label
-        QLabel *imageLabel = new QLabel();
-        // qDebug() << "Loading Image : " << appPath + current->getImage().getPath();
-        QPixmap pixmap(appPath + current->getImage().getPath());
-        if (pixmap.isNull())
+        if (current->getAccess() == 'L' && !currentUser.access)
         {
-            qWarning() << "Failed to load image: " << current->getImage().getPath();
+            continue;
         }
-        imageLabel->setPixmap(pixmap.scaled(210, 210, Qt::KeepAspectRatio));
-        imageLabel->setStyleSheet("border: 1px solid #ccc; padding: 5px;");
-        cellLayout->addWidget(imageLabel);
-
-        // // Create and add the information label
-        QLabel *infoLabel = new QLabel();
-        QString infoText = QString("ID: %1").arg(current->getIdDescriptor());
-        infoLabel->setText(infoText);
-        infoLabel->setStyleSheet("background-color: #f9f9f9; padding: 10px; border-radius: 5px;");
-        infoLabel->setFixedSize(240, 33);
-
-        cellLayout->addWidget(infoLabel);
-
-        // Create an info button
-            QPushButton *infoButton = new QPushButton("Show/Hide Info", this);
-            infoButton->setStyleSheet(  "QPushButton {"
-                                            "background-color: rgb(153, 193, 241);"
-                                            "color: white;"
-                                            "border: none;"
-                                            "border-radius: 5px;"
-                                            "padding: 8px 12px;"
-                                            "font-size: 14px;"
-                                            "font-weight: bold;"
-                                            "}"
-                                            "QPushButton:hover {"
-                                            "background-color: rgb(123, 163, 211);"
-                                            "}"
-                                            "QPushButton:pressed {"
-                                            "background-color: #003f7f;"
-                                            "padding-left: 12px;"
-                                            "padding-top: 12px;"
-                                            "}");
-            cellLayout->addWidget(infoButton);
-
-        // If the user has access, create a delete button
-        if (getCurrentUser().access)
-        {
-            QPushButton *deleteButton = new QPushButton("Delete", this);
-            deleteButton->setStyleSheet(  "QPushButton {"
-                                            "background-color: rgb(153, 193, 241);"
-                                            "color: white;"
-                                            "border: none;"
-                                            "border-radius: 5px;"
-                                            "padding: 8px 12px;"
-                                            "font-size: 14px;"
-                                            "font-weight: bold;"
-                                            "}"
-                                            "QPushButton:hover {"
-                                            "background-color: rgb(123, 163, 211);"
-                                            "}"
-                                            "QPushButton:pressed {"
-                                            "background-color: #003f7f;"
-                                            "padding-left: 12px;"
-                                            "padding-top: 12px;"
-                                            "}");
-            cellLayout->addWidget(deleteButton);
-
-            // Use a lambda to delete the descriptor
-            connect(deleteButton, &QPushButton::clicked, this, [this, descriptor = current]()
-                    {
-                        mainlibrary.deleteDescriptor(descriptor);
-                        ShowTheLibrary(mainlibrary); // Reload the library after deletion
-                    });
-
-            QPushButton *editButton = new QPushButton("Edit", this);
-            editButton->setStyleSheet(  "QPushButton {"
-                                            "background-color: rgb(153, 193, 241);"
-                                            "color: white;"
-                                            "border: none;"
-                                            "border-radius: 5px;"
-                                            "padding: 8px 12px;"
-                                            "font-size: 14px;"
-                                            "font-weight: bold;"
-                                            "}"
-                                            "QPushButton:hover {"
-                                            "background-color: rgb(123, 163, 211);"
-                                            "}"
-                                            "QPushButton:pressed {"
-                                            "background-color: #003f7f;"
-                                            "padding-left: 12px;"
-                                            "padding-top: 12px;"
-                                            "}");
-            cellLayout->addWidget(editButton);
-
-            // Connect the Edit button to display a QMessageBox
-            connect(editButton, &QPushButton::clicked, this, [this, current]()
-                {
-
-                    unsigned int originalId = current->getIdDescriptor();
-
-                    QDialog dialog(this);
-                    dialog.setWindowTitle("Edit Image Info");
-                    dialog.setModal(true);
-
-                    QLineEdit *idEdit = new QLineEdit(QString::number(current->getIdDescriptor()), &dialog);
-                    QLineEdit *titleEdit = new QLineEdit(current->getTitle(), &dialog);
-                    QLineEdit *sourceEdit = new QLineEdit(current->getSource(), &dialog);
-                    QLineEdit *costEdit = new QLineEdit(QString::number(current->getCost()), &dialog);
-
-                    QComboBox *accessCombo = new QComboBox(&dialog);
-                    accessCombo->addItem("L");
-                    accessCombo->addItem("O");
-                    accessCombo->setCurrentText(QString(current->getAccess()));
-                    // Créer un layout pour organiser les champs
-                    QFormLayout *formLayout = new QFormLayout();
-                    formLayout->addRow("ID:", idEdit);
-                    formLayout->addRow("Title:", titleEdit);
-                    formLayout->addRow("Source:", sourceEdit);
-                    formLayout->addRow("Cost:", costEdit);
-                    formLayout->addRow("Access:", accessCombo);
-
-
-                    // Ajouter les boutons
-                    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, &dialog);
-
-                    // Connecter les boutons
-                    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
-                    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
-
-                    // Organiser le tout dans un layout principal
-                    QVBoxLayout *mainLayout = new QVBoxLayout(&dialog);
-                    mainLayout->addLayout(formLayout);
-                    mainLayout->addWidget(buttonBox);
-
-                    // Afficher la boîte de dialogue
-                    if (dialog.exec() == QDialog::Accepted) {
-                        // Mettre à jour les informations
-                        current->setIdDescriptor(idEdit->text().toInt());                        
-                        current->setTitle(titleEdit->text());
-                        current->setSource(sourceEdit->text());
-                        current->setCost(costEdit->text().toDouble());
-                        current->setAccess(accessCombo->currentText().toStdString()[0]); // Récupérer la valeur sélectionnée
-
-                        SaveChanges_clicked(current, originalId);
-
-                        ShowTheLibrary(mainlibrary); // Rafraîchir l'affichage 
-                    }
-                });
-            } 
-
-
-                bool *isInfoVisible = new bool(false); // Initial state: info hidden
-
-                // Connect the info button
-                connect(infoButton, &QPushButton::clicked, this, [infoLabel, current, isInfoVisible]()
-                    {
-                        if (*isInfoVisible) {
-                        // Hide additional information
-                        infoLabel->setText(QString("ID: %1").arg(current->getIdDescriptor()));
-                        infoLabel->setFixedSize(240, 33); // Revenir à la taille initiale
-                        *isInfoVisible = false;
-
-                        } else {
-                            // Show additional information
-                            QString additionalInfo = QString("\nCost: %1\nTitle: %2\nSource: %3\nAccess: %4")
-                                             .arg(current->getCost())         // Cost
-                                             .arg(current->getTitle())        // Titre
-                                             .arg(current->getSource())       // Source
-                                             .arg(current->getAccess());        // Access
-                            infoLabel->setText(infoLabel->text() + additionalInfo);
-
-                            infoLabel->setFixedSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX);
-                            infoLabel->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred); // Autoriser l'expansion
-                            *isInfoVisible = true;
-            }
-        });
-
-        // Create a widget to hold the cell layout and add it to the grid layout
-        QWidget *cellWidget = new QWidget();
-        cellWidget->setLayout(cellLayout);
-        cellWidget->setFixedSize(250, 350);
-        cellWidget->setStyleSheet("background-color: #ffffff; border: 1px solid #ddd; border-radius: 10px; padding: 10px;");
-        gridLayout->addWidget(cellWidget, row, col);
-
-        // Store the connection between the widget and the descriptor
-        widgetDescriptorMap[cellWidget] = current;
+        descriptors.append(current);
+    }
+    descriptorModel->setDescriptors(descriptors);
+    ui->descriptorView->scrollToTop();
+}
 
-        // Install an event filter for the widget
-        cellWidget->installEventFilter(this);
+void MainWindow::onDescriptorClicked(const QModelIndex &index)
+{
+    Descriptor *descriptor = descriptorModel->descriptorAt(index);
+    if (descriptor == nullptr)
+    {
+        return;
+    }
 
-        // Update row and column for grid layout
-        col++;
-        if (col >= 3)
-        {
-            col = 0;
-            row++;
-        }
+    // The buttons are painted by the delegate: find out which one (if any) was clicked
+    QPoint position = ui->descriptorView->viewport()->mapFromGlobal(QCursor::pos());
+    switch (descriptorDelegate->buttonAt(ui->descriptorView->visualRect(index), position))
+    {
+    case DescriptorDelegate::InfoButton:
+        descriptorModel->toggleInfo(index);
+        break;
+    case DescriptorDelegate::DeleteButton:
+        mainlibrary.deleteDescriptor(descriptor);
+        ShowTheLibrary(mainlibrary); // Reload the library after deletion
+        break;
+    case DescriptorDelegate::EditButton:
+        editDescriptor(descriptor);
+        break;
+    default:
+        descriptorDetails->setLibraryPath(this->currentLibraryPath);
+        descriptorDetails->setDescriptor(descriptor);
+        descriptorDetails->show();
+        break;
+    }
+}
 
-        current = current->getNextDescriptor();
+void MainWindow::editDescriptor(Descriptor *current)
+{
+    unsigned int originalId = current->getIdDescriptor();
+
+    QDialog dialog(this);
+    dialog.setWindowTitle("Edit Image Info");
+    dialog.setModal(true);
+
+    QLineEdit *idEdit = new QLineEdit(QString::number(current->getIdDescriptor()), &dialog);
+    QLineEdit *titleEdit = new QLineEdit(current->getTitle(), &dialog);
+    QLineEdit *sourceEdit = new QLineEdit(current->getSource(), &dialog);
+    QLineEdit *costEdit = new QLineEdit(QString::number(current->getCost()), &dialog);
+
+    QComboBox *accessCombo = new QComboBox(&dialog);
+    accessCombo->addItem("L");
+    accessCombo->addItem("O");
+    accessCombo->setCurrentText(QString(current->getAccess()));
+    // Créer un layout pour organiser les champs
+    QFormLayout *formLayout = new QFormLayout();
+    formLayout->addRow("ID:", idEdit);
+    formLayout->addRow("Title:", titleEdit);
+    formLayout->addRow("Source:", sourceEdit);
+    formLayout->addRow("Cost:", costEdit);
+    formLayout->addRow("Access:", accessCombo);
+
+
+    // Ajouter les boutons
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, &dialog);
+
+    // Connecter les boutons
+    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
+
+    // Organiser le tout dans un layout principal
+    QVBoxLayout *mainLayout = new QVBoxLayout(&dialog);
+    mainLayout->addLayout(formLayout);
+    mainLayout->addWidget(buttonBox);
+
+    // Afficher la boîte de dialogue
+    if (dialog.exec() == QDialog::Accepted) {
+        // Mettre à jour les informations
+        current->setIdDescriptor(idEdit->text().toInt());                        
+        current->setTitle(titleEdit->text());
+        current->setSource(sourceEdit->text());
+        current->setCost(costEdit->text().toDouble());
+        current->setAccess(accessCombo->currentText().toStdString()[0]); // Récupérer la valeur sélectionnée
+
+        SaveChanges_clicked(current, originalId);
+
+        ShowTheLibrary(mainlibrary); // Rafraîchir l'affichage 
     }
 }
 
@@ -475,24 +477,6 @@ User MainWindow::getCurrentUser()
 {
     return this->currentUser;
 };
-bool MainWindow::eventFilter(QObject *obj, QEvent *event)
-{
-    if (event->type() == QEvent::MouseButtonPress)
-    {
-        QWidget *widget = qobject_cast<QWidget *>(obj);
-        if (widget && widgetDescriptorMap.contains(widget))
-        {
-            Descriptor *descriptor = widgetDescriptorMap[widget];
-            // qDebug() << "library Path in details" << this->currentLibraryPath;
-            descriptorDetails->setLibraryPath(this->currentLibraryPath);
-            descriptorDetails->setDescriptor(descriptor);
-            descriptorDetails->show();
-            return true;
-        }
-    }
-    return QMainWindow::eventFilter(obj, event);
-}
-
 void MainWindow::refreshLibrary()
 {
 }
@@ -542,12 +526,91 @@ void MainWindow::on_actionAdd_New_Descriptor_triggered()
     // qDebug() << "In MainWindow::on_add_new_description_clicked():";
     // qDebug() << "---------------------------------------";
     // qDebug() << MainWindow::getCurrentLibraryId();
-    Add_New_Descriptor addDescriptorDialog(mainlibrary.getLibraryPath(), this);
-    addDescriptorDialog.exec();
+    Add_New_Descriptor addDescriptorDialog(mainlibrary.getLibraryPath(), &mainlibrary, this);
+    if (addDescriptorDialog.exec() == QDialog::Accepted)
+    {
+        mainlibrary.addPerceptualHash(addDescriptorDialog.getAddedId(), addDescriptorDialog.getAddedPerceptualHash());
+
+        // Index the new image now rather than on the next similarity search. While the index is being built in
+        // the background it must not be touched: the next search then adds the image with the others.
+        if (!visualIndexBuilder->isBuilding())
+        {
+            QApplication::setOverrideCursor(Qt::WaitCursor);
+            mainlibrary.indexDescriptor(addDescriptorDialog.getAddedId(), addDescriptorDialog.getAddedImagePath());
+            QApplication::restoreOverrideCursor();
+        }
+    }
     // refresh the ui to show the new descriptor
     LoadTheLibrary(mainlibrary.getLibraryPath());
 }
 
+void MainWindow::on_actionFind_Duplicates_triggered()
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    vector<DuplicatePair> duplicates = mainlibrary.findDuplicateDescriptors();
+    QApplication::restoreOverrideCursor();
+
+    // Locked descriptors are hidden from users without access, here as in the grid
+    if (!currentUser.access)
+    {
+        duplicates.erase(std::remove_if(duplicates.begin(), duplicates.end(), [this](const DuplicatePair &duplicate) {
+            for (unsigned int id : {duplicate.first, duplicate.second})
+            {
+                Descriptor *found = mainlibrary.searchDescriptor(id);
+                if (found != nullptr && found->getAccess() == 'L')
+                {
+                    return true;
+                }
+            }
+            return false;
+        }), duplicates.end());
+    }
+
+    if (duplicates.empty())
+    {
+        QMessageBox::information(this, "Duplicates", "No near-duplicate images were found.");
+        return;
+    }
+
+    // Show every image involved, each one next to the first image it duplicates
+    QSet<unsigned int> shown;
+    Descriptor *newHead = nullptr;
+    Descriptor *newTail = nullptr;
+    QString message;
+    for (const DuplicatePair &duplicate : duplicates)
+    {
+        if (message.count('\n') < 20)
+        {
+            message += QString("#%1 and #%2 (%3 bits differ)\n").arg(duplicate.first).arg(duplicate.second).arg(duplicate.distance);
+        }
+        for (unsigned int id : {duplicate.first, duplicate.second})
+        {
+            Descriptor *found = mainlibrary.searchDescriptor(id);
+            if (found == nullptr || shown.contains(id))
+            {
+                continue;
+            }
+            shown.insert(id);
+            Descriptor *newDescriptor = new Descriptor(*found);
+            newDescriptor->setNextDescriptor(nullptr);
+            if (newHead == nullptr)
+            {
+                newHead = newDescriptor;
+            }
+            else
+            {
+                newTail->setNextDescriptor(newDescriptor);
+            }
+            newTail = newDescriptor;
+        }
+    }
+
+    sublibrary.setHead(newHead);
+    ShowTheLibrary(sublibrary);
+    ui->returnButton->setVisible(true);
+    QMessageBox::information(this, "Duplicates", QString("%1 pairs of near-duplicate images:\n\n").arg(duplicates.size()) + message);
+}
+
 void MainWindow::on_actionDelete_a_library_triggered()
 {
     // Load the libraries from the JSON file
@@ -600,9 +663,8 @@ void MainWindow::on_actionDelete_a_library_triggered()
 void MainWindow::on_SearchButton_clicked()
 {
     QString ImageId = ui->ImageIdSearchInput->text();
-    bool imageFound = false;
+    QVector<Descriptor*> found;
     Descriptor *current = mainlibrary.getHead();
-    QString appPath = QCoreApplication::applicationDirPath();
 
     while (current != nullptr)
     {
@@ -614,209 +676,91 @@ void MainWindow::on_SearchButton_clicked()
         // check if the current descriptor id is equal to the id entered by the user
         if (current->getIdDescriptor() == ImageId.toInt())
         {
-            imageFound = true;
+            found.append(current);
+        }
+        current = current->getNextDescriptor();
+    }
 
-            // Show the return button
-            ui->returnButton->setVisible(true);
-            // clear the grid layout
-            QLayoutItem *item;
-            while ((item = gridLayout->takeAt(0)) != nullptr)
-            {
-                delete item->widget();
-                delete item;
-            }
+    if (found.isEmpty())
+    {
+        QMessageBox::warning(this, "Error", "No image found with this ID.");
+        return;
+    }
 
-            // Create a vertical layout for each cell
-            QVBoxLayout *cellLayout = new QVBoxLayout();
-            cellLayout->setContentsMargins(10, 10, 10, 10);
-            cellLayout->setSpacing(10);
-
-            // Create and add the image label
-            QLabel *imageLabel = new QLabel();
-            QPixmap pixmap(appPath + current->getImage().getPath());
-            imageLabel->setPixmap(pixmap.scaled(210, 210, Qt::KeepAspectRatio)); // Adjust the size as needed
-            imageLabel->setStyleSheet("border: 1px solid #ccc; padding: 5px;");
-            cellLayout->addWidget(imageLabel);
-
-            // // Create and add the information label
-            QLabel *infoLabel = new QLabel();
-            QString infoText = QString("ID: %1").arg(current->getIdDescriptor());
-            infoLabel->setText(infoText);
-            infoLabel->setStyleSheet("background-color: #f9f9f9; padding: 10px; border-radius: 5px;");
-            infoLabel->setFixedSize(240, 33);
-            cellLayout->addWidget(infoLabel);
-
-            // Create an info button
-            QPushButton *infoButton = new QPushButton("Show/Hide Info", this);
-            infoButton->setStyleSheet(  "QPushButton {"
-                                            "background-color: rgb(153, 193, 241);"
-                                            "color: white;"
-                                            "border: none;"
-                                            "border-radius: 5px;"
-                                            "padding: 8px 12px;"
-                                            "font-size: 14px;"
-                                            "font-weight: bold;"
-                                            "}"
-                                            "QPushButton:hover {"
-                                            "background-color: rgb(123, 163, 211);"
-                                            "}"
-                                            "QPushButton:pressed {"
-                                            "background-color: #003f7f;"
-                                            "padding-left: 12px;"
-                                            "padding-top: 12px;"
-                                            "}");
-            cellLayout->addWidget(infoButton);
+    // Show the return button and only the matching image in the grid
+    ui->returnButton->setVisible(true);
+    descriptorModel->setDescriptors(found);
+}
+void MainWindow::on_SimilarButton_clicked()
+{
+    bool ok;
+    unsigned int id = ui->ImageIdSearchInput->text().toUInt(&ok);
+    if (!ok || mainlibrary.searchDescriptor(id) == nullptr)
+    {
+        QMessageBox::warning(this, "Error", "Please enter the ID of an image of the library.");
+        return;
+    }
+    if (visualIndexBuilder->isBuilding())
+    {
+        return; // The button is disabled until the index is ready
+    }
+    if (mainlibrary.isVisualIndexReady())
+    {
+        showSimilarDescriptors(id);
+        return;
+    }
 
-            if (getCurrentUser().access)
-            {
-                QPushButton *deleteButton = new QPushButton("Delete", this);
-                deleteButton->setStyleSheet(  "QPushButton {"
-                                            "background-color: rgb(153, 193, 241);"
-                                            "color: white;"
-                                            "border: none;"
-                                            "border-radius: 5px;"
-                                            "padding: 8px 12px;"
-                                            "font-size: 14px;"
-                                            "font-weight: bold;"
-                                            "}"
-                                            "QPushButton:hover {"
-                                            "background-color: rgb(123, 163, 211);"
-                                            "}"
-                                            "QPushButton:pressed {"
-                                            "background-color: #003f7f;"
-                                            "padding-left: 12px;"
-                                            "padding-top: 12px;"
-                                            "}");
-                cellLayout->addWidget(deleteButton);
-
-                // Use a lambda to delete the descriptor
-                connect(deleteButton, &QPushButton::clicked, this, [this, descriptor = current]()
-                    {
-                        mainlibrary.deleteDescriptor(descriptor);
-                        ShowTheLibrary(mainlibrary); // Reload the library after deletion
-                    });
-                QPushButton *editButton = new QPushButton("Edit", this);
-                editButton->setStyleSheet(  "QPushButton {"
-                                            "background-color: rgb(153, 193, 241);"
-                                            "color: white;"
-                                            "border: none;"
-                                            "border-radius: 5px;"
-                                            "padding: 8px 12px;"
-                                            "font-size: 14px;"
-                                            "font-weight: bold;"
-                                            "}"
-                                            "QPushButton:hover {"
-                                            "background-color: rgb(123, 163, 211);"
-                                            "}"
-                                            "QPushButton:pressed {"
-                                            "background-color: #003f7f;"
-                                            "padding-left: 12px;"
-                                            "padding-top: 12px;"
-                                            "}");
-            cellLayout->addWidget(editButton);
+    // The first search indexes the whole library, later ones only the new images: both in the background
+    pendingSimilarId = id;
+    pendingSimilarLibrary = mainlibrary.getLibraryPath();
+    ui->SimilarButton->setEnabled(false);
+    visualIndexTicket = visualIndexBuilder->build(mainlibrary.prepareVisualIndexUpdate());
+    visualIndexProgress->setRange(0, 0);
+    visualIndexProgress->setVisible(true);
+    ui->statusbar->showMessage("Indexing the images for the similarity search...");
+}
 
-            connect(editButton, &QPushButton::clicked, this, [this, current]()
-                {
+void MainWindow::onVisualIndexProgress(int ticket, int done, int total)
+{
+    if (ticket != visualIndexTicket)
+    {
+        return;
+    }
+    visualIndexProgress->setRange(0, total);
+    visualIndexProgress->setValue(done);
+}
 
-                    unsigned int originalId = current->getIdDescriptor();
-
-                    QDialog dialog(this);
-                    dialog.setWindowTitle("Edit Image Info");
-                    dialog.setModal(true);
-
-                    QLineEdit *idEdit = new QLineEdit(QString::number(current->getIdDescriptor()), &dialog);
-                    QLineEdit *titleEdit = new QLineEdit(current->getTitle(), &dialog);
-                    QLineEdit *sourceEdit = new QLineEdit(current->getSource(), &dialog);
-                    QLineEdit *costEdit = new QLineEdit(QString::number(current->getCost()), &dialog);
-
-                    QComboBox *accessCombo = new QComboBox(&dialog);
-                    accessCombo->addItem("L");
-                    accessCombo->addItem("O");
-                    accessCombo->setCurrentText(QString(current->getAccess()));
-                    // Créer un layout pour organiser les champs
-                    QFormLayout *formLayout = new QFormLayout();
-                    formLayout->addRow("ID:", idEdit);
-                    formLayout->addRow("Title:", titleEdit);
-                    formLayout->addRow("Source:", sourceEdit);
-                    formLayout->addRow("Cost:", costEdit);
-                    formLayout->addRow("Access:", accessCombo);
-
-
-                    // Ajouter les boutons
-                    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, &dialog);
-
-                    // Connecter les boutons
-                    connect(buttonBox, &QDialogButtonBox::accepted, &dialog, &QDialog::accept);
-                    connect(buttonBox, &QDialogButtonBox::rejected, &dialog, &QDialog::reject);
-
-                    // Organiser le tout dans un layout principal
-                    QVBoxLayout *mainLayout = new QVBoxLayout(&dialog);
-                    mainLayout->addLayout(formLayout);
-                    mainLayout->addWidget(buttonBox);
-
-                    // Afficher la boîte de dialogue
-                    if (dialog.exec() == QDialog::Accepted) {
-                        // Mettre à jour les informations
-                        current->setIdDescriptor(idEdit->text().toInt());                        
-                        current->setTitle(titleEdit->text());
-                        current->setSource(sourceEdit->text());
-                        current->setCost(costEdit->text().toDouble());
-                        current->setAccess(accessCombo->currentText().toStdString()[0]); // Récupérer la valeur sélectionnée
-
-                        SaveChanges_clicked(current, originalId);
-
-                        ShowTheLibrary(mainlibrary); // Rafraîchir l'affichage 
-                    }
-                });
-            } 
-
-            bool *isInfoVisible = new bool(false); 
-
-                // Connect the info button
-                connect(infoButton, &QPushButton::clicked, this, [infoLabel, current, isInfoVisible]()
-                    {
-                        if (*isInfoVisible) {
-                        // Hide additional information
-                        infoLabel->setText(QString("ID: %1").arg(current->getIdDescriptor()));
-                        infoLabel->setFixedSize(240, 33); // Revenir à la taille initiale
-                        *isInfoVisible = false;
-
-                        } else {
-                            // Show additional information
-                            QString additionalInfo = QString("\nCost: %1\nTitle: %2\nSource: %3\nAccess: %4")
-                                             .arg(current->getCost())         // Cost
-                                             .arg(current->getTitle())        // Titre
-                                             .arg(current->getSource())       // Source
-                                             .arg(current->getAccess());        // Access
-                            infoLabel->setText(infoLabel->text() + additionalInfo);
-
-                            infoLabel->setFixedSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX);
-                            infoLabel->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred); // Autoriser l'expansion
-                            *isInfoVisible = true;
-                    }
-        });
-
-            // Create a widget to hold the cell layout and add it to the grid layout
-            QWidget *cellWidget = new QWidget();
-            cellWidget->setLayout(cellLayout);
-            cellWidget->setFixedSize(250, 350); // Set fixed size for each descriptor
-            cellWidget->setStyleSheet("background-color: #ffffff; border: 1px solid #ddd; border-radius: 10px; padding: 10px;");
-            gridLayout->addWidget(cellWidget, 0, 0);
-
-            // Store the connection between the widget and the descriptor
-            widgetDescriptorMap[cellWidget] = current;
-
-            // Connect the click event to the slot
-            cellWidget->installEventFilter(this);
-        }
-        current = current->getNextDescriptor();
+void MainWindow::onVisualIndexBuilt(int ticket)
+{
+    if (ticket != visualIndexTicket || visualIndexBuilder->isBuilding())
+    {
+        return;
     }
+    visualIndexProgress->setVisible(false);
+    ui->statusbar->clearMessage();
+    ui->SimilarButton->setEnabled(true);
 
-    if (!imageFound)
+    // Another library may have been opened meanwhile. Images that could not be read are left out of the index,
+    // so it is searched as it is rather than checked with isVisualIndexReady again.
+    if (mainlibrary.getLibraryPath() == pendingSimilarLibrary && mainlibrary.searchDescriptor(pendingSimilarId) != nullptr)
     {
-        QMessageBox::warning(this, "Error", "No image found with this ID.");
+        showSimilarDescriptors(pendingSimilarId);
+    }
+}
+
+void MainWindow::showSimilarDescriptors(unsigned int id)
+{
+    Descriptor *similar = mainlibrary.getSimilarDescriptors(id);
+    if (similar == nullptr)
+    {
+        QMessageBox::information(this, "Search", "No similar image was found.");
+        return;
     }
+    sublibrary.setHead(similar);
+    ShowTheLibrary(sublibrary);
+    ui->returnButton->setVisible(true);
 }
+
 void MainWindow::on_returnButton_clicked()
 {
     ShowTheLibrary(mainlibrary);
@@ -1013,18 +957,14 @@ void MainWindow::SaveChanges_clicked(Descriptor *currentDescriptor, unsigned int
     // Récupérer les nouvelles informations
     QJsonObject curObj = currentDescriptor->toJson();
 
-    // Charger la bibliothèque
-    QFile file(libraryPath);
-    if (!file.open(QIODevice::ReadOnly)) {
-        // qDebug() << "Error: Could not open file";
+    // Charger la bibliothèque (JSON ou binaire) ; rien n'est écrit si elle n'a pas pu être lue
+    bool readOk = false;
+    QJsonObject obj = readLibraryDocument(libraryPath, &readOk);
+    if (!readOk)
+    {
+        QMessageBox::warning(this, "Save Changes", "Could not read the current library.");
         return;
     }
-
-    // Lire le fichier JSON existant
-    QByteArray data = file.readAll();
-    file.close();
-    QJsonDocument doc(QJsonDocument::fromJson(data));
-    QJsonObject obj = doc.object();
     QJsonArray array = obj["library"].toArray();
     QJsonArray newArray;
 
@@ -1041,13 +981,12 @@ void MainWindow::SaveChanges_clicked(Descriptor *currentDescriptor, unsigned int
 
     obj["library"] = newArray;
 
-    // Sauvegarder les modifications
-    if (!file.open(QIODevice::WriteOnly)) {
-        // qDebug() << "Error: Could not open file";
+    // Sauvegarder les modifications dans le format du fichier existant
+    if (!writeLibraryDocument(libraryPath, obj))
+    {
+        QMessageBox::warning(this, "Save Changes", "Could not write " + libraryPath + ".");
         return;
     }
-    file.write(QJsonDocument(obj).toJson());
-    file.close();
 
     // qDebug() << "Changes saved to the library file for ID:" << originalId;
 }
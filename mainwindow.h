@@ -9,6 +9,12 @@
 #include "librarymanagement.hpp"
 #include <QVBoxLayout>
 #include <QMap>
+#include <QModelIndex>
+#include "descriptorlistmodel.hpp"
+#include "descriptordelegate.hpp"
+#include "libraryloader.hpp"
+#include "visualindexbuilder.hpp"
+#include <QProgressBar>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class Home; }
@@ -25,9 +31,6 @@ public:
     QString currentLibraryPath;
     ManageLibrary mainlibrary;
     ManageLibrary sublibrary;
-protected:
-    bool eventFilter(QObject *obj, QEvent *event) override; // Add this method
-
 private slots:
 
 
@@ -39,9 +42,14 @@ private slots:
 
     void on_actionAdd_New_Descriptor_triggered();
 
+    void on_actionFind_Duplicates_triggered();
+
     void on_actionDelete_a_library_triggered();
 
+    void on_actionSave_Library_As_triggered();
+
     void on_SearchButton_clicked();
+    void on_SimilarButton_clicked();
     void on_returnButton_clicked();
 
     void on_SubListButton_MaxMin_clicked();
@@ -63,16 +71,30 @@ private slots:
     void on_SubListButton_Gratuit_clicked();
 
     void on_LogoutButton_clicked();
+
+    void onDescriptorClicked(const QModelIndex &index);
+    void onLibraryLoadProgress(int ticket, int done, int total);
+    void onLibraryLoaded(int ticket, bool ok);
+    void onVisualIndexProgress(int ticket, int done, int total);
+    void onVisualIndexBuilt(int ticket);
 signals:
     void logoutRequested();  // Signal to request logout
 
 private:
     Ui::Home *ui;
     User currentUser;
-    QGridLayout *gridLayout;
     QVBoxLayout *gridLayout_Buttons;
     DescriptorDetails *descriptorDetails;
-    QMap<QWidget*, Descriptor*> widgetDescriptorMap;
+    DescriptorListModel *descriptorModel;
+    DescriptorDelegate *descriptorDelegate;
+    LibraryLoader *libraryLoader;
+    QProgressBar *libraryLoadProgress;
+    int libraryLoadTicket;
+    VisualIndexBuilder *visualIndexBuilder;
+    QProgressBar *visualIndexProgress;
+    int visualIndexTicket;
+    unsigned int pendingSimilarId; // Searched for once the visual index of pendingSimilarLibrary is ready
+    QString pendingSimilarLibrary;
 
 
     // int getCurrentLibraryId();
@@ -85,6 +107,8 @@ private:
     void ShowTheLibrary(ManageLibrary library);
     void clearGridLayout();
     void populateGridLayout(Descriptor* head);
+    void editDescriptor(Descriptor* descriptor);
+    void showSimilarDescriptors(unsigned int id);
     void cleanUpDescriptors(Descriptor* head);
     User getCurrentUser();
 
@@ -0,0 +1,179 @@
+#include "medianfilter.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+const int FINE_BINS = 256;
+const int COARSE_BINS = 16;
+
+/**
+ * @brief Histogramme du noyau courant pour un canal (Perreault & Hébert, 2007).
+ *
+ * Le niveau grossier (16 cases) est mis à jour à chaque pixel. Le niveau fin (16 segments de 16 cases)
+ * n'est resynchronisé que pour le segment où tombe la médiane : `lastUpdate[b]` mémorise la position
+ * de la fenêtre à laquelle correspond le segment b (-1 = jamais initialisé sur cette ligne).
+ */
+struct KernelHistogram {
+    uint16_t coarse[COARSE_BINS];
+    uint16_t fine[FINE_BINS];
+    int lastUpdate[COARSE_BINS];
+};
+
+inline void addSegment(uint16_t* dst, const uint16_t* src) {
+    for (int i = 0; i < COARSE_BINS; i++) {
+        dst[i] += src[i];
+    }
+}
+
+inline void subSegment(uint16_t* dst, const uint16_t* src) {
+    for (int i = 0; i < COARSE_BINS; i++) {
+        dst[i] -= src[i];
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Filtre médian à coût constant par pixel sur les lignes [rowStart, rowEnd) de la sortie.
+ *
+ * Chaque colonne (élargie de `radius` de chaque côté, bords répliqués) garde un histogramme de ses
+ * `kernelSize` pixels verticaux. Passer d'une ligne à la suivante retire un pixel et en ajoute un par
+ * colonne ; passer d'un pixel au suivant ajoute une colonne et en retire une au noyau. Le coût ne
+ * dépend donc pas de la taille du noyau. Tous les canaux entrelacés sont traités dans la même passe.
+ *
+ * La sortie `dst` doit déjà être allouée (même taille et même type que `src`).
+ */
+void constantTimeMedianFilterRows(const Mat& src, Mat& dst, int kernelSize, int rowStart, int rowEnd) {
+    const int width = src.cols;
+    const int height = src.rows;
+    const int cn = src.channels();
+    const int radius = kernelSize / 2;
+    const int paddedWidth = width + 2 * radius;
+    const int rank = (kernelSize * kernelSize) / 2;
+
+    // Histogrammes de colonnes : une ligne par (colonne élargie * cn + canal). Ils sont pris dans le BufferPool
+    // le temps de l'appel : une chaîne découpée en petites bandes reprend les mêmes tampons sans réallouer
+    // plusieurs mégaoctets, et ils restent comptés (et libérables) avec les autres tampons des filtres.
+    Mat columnFine = pooledMat(paddedWidth * cn, FINE_BINS, CV_16U);
+    Mat columnCoarse = pooledMat(paddedWidth * cn, COARSE_BINS, CV_16U);
+    columnFine.setTo(Scalar(0));
+    columnCoarse.setTo(Scalar(0));
+    vector<KernelHistogram> kernels(cn);
+
+    auto sourceColumn = [&](int px) { return clamp(px - radius, 0, width - 1); };
+    auto fineOf = [&](int px, int c) { return columnFine.ptr<uint16_t>(px * cn + c); };
+    auto coarseOf = [&](int px, int c) { return columnCoarse.ptr<uint16_t>(px * cn + c); };
+
+    auto updateColumns = [&](int y, int delta) {
+        const uchar* row = src.ptr<uchar>(clamp(y, 0, height - 1));
+        for (int px = 0; px < paddedWidth; px++) {
+            const uchar* pixel = row + sourceColumn(px) * cn;
+            for (int c = 0; c < cn; c++) {
+                fineOf(px, c)[pixel[c]] += delta;
+                coarseOf(px, c)[pixel[c] >> 4] += delta;
+            }
+        }
+    };
+
+    // Met le segment b du noyau en accord avec la fenêtre qui commence à la colonne élargie x.
+    auto syncSegment = [&](KernelHistogram& kernel, int c, int b, int x) {
+        uint16_t* segment = kernel.fine + b * COARSE_BINS;
+        int last = kernel.lastUpdate[b];
+        if (last < 0 || 2 * (x - last) > kernelSize) {
+            fill(segment, segment + COARSE_BINS, 0);
+            for (int px = x; px < x + kernelSize; px++) {
+                addSegment(segment, fineOf(px, c) + b * COARSE_BINS);
+            }
+        } else {
+            for (int p = last + 1; p <= x; p++) {
+                addSegment(segment, fineOf(p + kernelSize - 1, c) + b * COARSE_BINS);
+                subSegment(segment, fineOf(p - 1, c) + b * COARSE_BINS);
+            }
+        }
+        kernel.lastUpdate[b] = x;
+    };
+
+    for (int y = rowStart - radius; y <= rowStart + radius; y++) {
+        updateColumns(y, 1);
+    }
+
+    for (int y = rowStart; y < rowEnd; y++) {
+        if (y > rowStart) {
+            updateColumns(y - radius - 1, -1);
+            updateColumns(y + radius, 1);
+        }
+
+        for (int c = 0; c < cn; c++) {
+            KernelHistogram& kernel = kernels[c];
+            fill(kernel.coarse, kernel.coarse + COARSE_BINS, 0);
+            fill(kernel.lastUpdate, kernel.lastUpdate + COARSE_BINS, -1);
+            for (int px = 0; px < kernelSize; px++) {
+                addSegment(kernel.coarse, coarseOf(px, c));
+            }
+        }
+
+        uchar* out = dst.ptr<uchar>(y);
+        for (int x = 0; x < width; x++) {
+            for (int c = 0; c < cn; c++) {
+                KernelHistogram& kernel = kernels[c];
+                if (x > 0) {
+                    addSegment(kernel.coarse, coarseOf(x + kernelSize - 1, c));
+                    subSegment(kernel.coarse, coarseOf(x - 1, c));
+                }
+
+                // Recherche de la médiane : d'abord la case grossière, puis la case fine
+                int count = 0;
+                int b = 0;
+                while (count + kernel.coarse[b] <= rank) {
+                    count += kernel.coarse[b];
+                    b++;
+                }
+                syncSegment(kernel, c, b, x);
+
+                const uint16_t* segment = kernel.fine + b * COARSE_BINS;
+                int v = 0;
+                while (count + segment[v] <= rank) {
+                    count += segment[v];
+                    v++;
+                }
+                out[x * cn + c] = static_cast<uchar>(b * COARSE_BINS + v);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Filtre médian à coût constant par pixel (histogrammes glissants, Perreault & Hébert).
+ *
+ * @param src L'image d'entrée 8 bits (1 à 4 canaux entrelacés).
+ * @param dst L'image de sortie, de même taille et de même type.
+ * @param kernelSize La taille du noyau (impaire, entre 3 et MEDIAN_MAX_KERNEL_SIZE).
+ *
+ * @throws std::invalid_argument Si `kernelSize` est invalide.
+ * @throws std::runtime_error Si l'image d'entrée est vide ou n'est pas en 8 bits.
+ */
+void constantTimeMedianFilter(const Mat& src, Mat& dst, int kernelSize) {
+    if (kernelSize % 2 == 0 || kernelSize < 3 || kernelSize > MEDIAN_MAX_KERNEL_SIZE) {
+        throw invalid_argument("La taille du noyau doit être un nombre impair entre 3 et 255.");
+    }
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.depth() != CV_8U) {
+        throw runtime_error("Le filtre médian n'accepte que des images 8 bits.");
+    }
+
+    Mat output = pooledMat(src.rows, src.cols, src.type());
+    parallelForRows(src.rows, kernelSize / 2, [&](int rowStart, int rowEnd) {
+        constantTimeMedianFilterRows(src, output, kernelSize, rowStart, rowEnd);
+    });
+    dst = output;
+}
@@ -0,0 +1,15 @@
+#ifndef MEDIANFILTER_HPP
+#define MEDIANFILTER_HPP
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+// Les compteurs des histogrammes sont sur 16 bits : kernelSize * kernelSize doit tenir dans un uint16_t.
+const int MEDIAN_MAX_KERNEL_SIZE = 255;
+
+void constantTimeMedianFilter(const Mat& src, Mat& dst, int kernelSize);
+void constantTimeMedianFilterRows(const Mat& src, Mat& dst, int kernelSize, int rowStart, int rowEnd);
+
+#endif // MEDIANFILTER_HPP
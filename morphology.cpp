@@ -0,0 +1,233 @@
+#include "morphology.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include "simd.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+// Largeur (en éléments) des bandes de colonnes de la passe verticale : les tampons restent dans le cache.
+const int COLUMN_STRIP = 256;
+
+struct MinOp {
+    static constexpr uchar neutral = 255;
+    static uchar apply(uchar a, uchar b) { return a < b ? a : b; }
+#if defined(LIBRARY_HAVE_SSE2)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_min_epu8(a, b); }
+#endif
+};
+
+struct MaxOp {
+    static constexpr uchar neutral = 0;
+    static uchar apply(uchar a, uchar b) { return a > b ? a : b; }
+#if defined(LIBRARY_HAVE_SSE2)
+    static __m128i apply(__m128i a, __m128i b) { return _mm_max_epu8(a, b); }
+#endif
+};
+
+/**
+ * @brief out[i] = Op(a[i], b[i]) sur `length` octets.
+ */
+template <typename Op>
+void combine(const uchar* a, const uchar* b, uchar* out, int length) {
+    int i = 0;
+#if defined(LIBRARY_HAVE_SSE2)
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), Op::apply(va, vb));
+    }
+#endif
+    for (; i < length; i++) {
+        out[i] = Op::apply(a[i], b[i]);
+    }
+}
+
+/**
+ * @brief Passe horizontale de van Herk/Gil-Werman sur une ligne à canaux entrelacés.
+ *
+ * La ligne élargie de `kernelSize - 1` pixels (valeur neutre) est découpée en blocs de `kernelSize` pixels.
+ * g contient le min/max cumulé depuis le début du bloc, h depuis la fin du bloc ; la fenêtre qui commence
+ * au pixel x vaut Op(h[x], g[x + kernelSize - 1]). Trois comparaisons par pixel, quelle que soit la taille.
+ */
+template <typename Op>
+void horizontalPass(const uchar* row, uchar* out, int width, int cn, int kernelSize,
+                    vector<uchar>& padded, vector<uchar>& g, vector<uchar>& h) {
+    const int radius = kernelSize / 2;
+    const int paddedWidth = width + kernelSize - 1;
+    const int length = paddedWidth * cn;
+
+    fill(padded.begin(), padded.begin() + length, Op::neutral);
+    copy(row, row + width * cn, padded.begin() + radius * cn);
+
+    for (int p = 0; p < paddedWidth; p++) {
+        for (int c = 0; c < cn; c++) {
+            int e = p * cn + c;
+            g[e] = (p % kernelSize == 0) ? padded[e] : Op::apply(g[e - cn], padded[e]);
+        }
+    }
+    for (int p = paddedWidth - 1; p >= 0; p--) {
+        for (int c = 0; c < cn; c++) {
+            int e = p * cn + c;
+            bool blockEnd = (p % kernelSize == kernelSize - 1) || p == paddedWidth - 1;
+            h[e] = blockEnd ? padded[e] : Op::apply(h[e + cn], padded[e]);
+        }
+    }
+    combine<Op>(h.data(), g.data() + (kernelSize - 1) * cn, out, width * cn);
+}
+
+/**
+ * @brief Érosion (MinOp) ou dilatation (MaxOp) carrée sur les lignes [rowStart, rowEnd).
+ *
+ * La passe verticale applique le même algorithme sur des lignes entières (comparaisons vectorisées),
+ * par bandes de COLUMN_STRIP éléments pour rester dans le cache.
+ */
+template <typename Op>
+void morphologyRowsImpl(const Mat& src, Mat& dst, int kernelSize, int rowStart, int rowEnd) {
+    const int width = src.cols;
+    const int cn = src.channels();
+    const int length = width * cn;
+    const int radius = kernelSize / 2;
+
+    // Lignes source utiles (les lignes hors de l'image valent l'élément neutre)
+    const int first = rowStart - radius;
+    const int count = (rowEnd - rowStart) + kernelSize - 1;
+
+    vector<uchar> padded((width + kernelSize - 1) * cn);
+    vector<uchar> gRow(padded.size());
+    vector<uchar> hRow(padded.size());
+    vector<uchar> horizontal(static_cast<size_t>(count) * length, Op::neutral);
+    for (int i = 0; i < count; i++) {
+        int y = first + i;
+        if (y >= 0 && y < src.rows) {
+            horizontalPass<Op>(src.ptr<uchar>(y), horizontal.data() + static_cast<size_t>(i) * length,
+                               width, cn, kernelSize, padded, gRow, hRow);
+        }
+    }
+
+    vector<uchar> g(static_cast<size_t>(count) * COLUMN_STRIP);
+    vector<uchar> h(static_cast<size_t>(count) * COLUMN_STRIP);
+    for (int x0 = 0; x0 < length; x0 += COLUMN_STRIP) {
+        const int strip = min(COLUMN_STRIP, length - x0);
+        auto rowOf = [&](int i) { return horizontal.data() + static_cast<size_t>(i) * length + x0; };
+
+        for (int i = 0; i < count; i++) {
+            uchar* gi = g.data() + static_cast<size_t>(i) * COLUMN_STRIP;
+            if (i % kernelSize == 0) {
+                copy(rowOf(i), rowOf(i) + strip, gi);
+            } else {
+                combine<Op>(gi - COLUMN_STRIP, rowOf(i), gi, strip);
+            }
+        }
+        for (int i = count - 1; i >= 0; i--) {
+            uchar* hi = h.data() + static_cast<size_t>(i) * COLUMN_STRIP;
+            if (i % kernelSize == kernelSize - 1 || i == count - 1) {
+                copy(rowOf(i), rowOf(i) + strip, hi);
+            } else {
+                combine<Op>(hi + COLUMN_STRIP, rowOf(i), hi, strip);
+            }
+        }
+        for (int y = rowStart; y < rowEnd; y++) {
+            int i = y - rowStart;
+            combine<Op>(h.data() + static_cast<size_t>(i) * COLUMN_STRIP,
+                        g.data() + static_cast<size_t>(i + kernelSize - 1) * COLUMN_STRIP,
+                        dst.ptr<uchar>(y) + x0, strip);
+        }
+    }
+}
+
+Mat runSingle(const Mat& src, MorphologyOperation operation, int kernelSize) {
+    Mat output = pooledMat(src.rows, src.cols, src.type());
+    // Chaque bande relit kernelSize / 2 lignes de part et d'autre (passe horizontale recalculée).
+    parallelForRows(src.rows, kernelSize / 2, [&](int rowStart, int rowEnd) {
+        morphologyFilterRows(src, output, operation, kernelSize, rowStart, rowEnd);
+    });
+    return output;
+}
+
+} // namespace
+
+/**
+ * @brief Érosion ou dilatation sur les lignes [rowStart, rowEnd) de la sortie (déjà allouée).
+ *
+ * @throws std::invalid_argument Si l'opération n'est pas Erode ou Dilate (les opérations composées
+ *         doivent passer par `morphologyFilter`).
+ */
+void morphologyFilterRows(const Mat& src, Mat& dst, MorphologyOperation operation, int kernelSize, int rowStart, int rowEnd) {
+    switch (operation) {
+        case MorphologyOperation::Erode:
+            morphologyRowsImpl<MinOp>(src, dst, kernelSize, rowStart, rowEnd);
+            break;
+        case MorphologyOperation::Dilate:
+            morphologyRowsImpl<MaxOp>(src, dst, kernelSize, rowStart, rowEnd);
+            break;
+        default:
+            throw invalid_argument("Seules l'érosion et la dilatation peuvent être appliquées par bandes de lignes.");
+    }
+}
+
+/**
+ * @brief Opérations morphologiques avec un élément structurant carré (algorithme de van Herk/Gil-Werman).
+ *
+ * L'élément carré est séparable : une passe horizontale puis une passe verticale de min (érosion) ou de
+ * max (dilatation). Chaque passe coûte trois comparaisons par échantillon, quelle que soit la taille du noyau.
+ * Les canaux sont traités séparément (aucune conversion en niveaux de gris). Les pixels hors de l'image
+ * sont ignorés, ce qui donne le même résultat qu'une bordure réfléchie.
+ *
+ * - Ouverture : érosion puis dilatation.
+ * - Fermeture : dilatation puis érosion.
+ * - Gradient morphologique : dilatation - érosion.
+ *
+ * @param src L'image d'entrée 8 bits (1 à 4 canaux).
+ * @param dst L'image de sortie, de même taille et de même type.
+ * @param operation L'opération à appliquer.
+ * @param kernelSize La taille de l'élément structurant (entier positif impair).
+ *
+ * @throws std::invalid_argument Si `kernelSize` n'est pas un entier positif impair.
+ * @throws std::runtime_error Si l'image d'entrée est vide ou n'est pas en 8 bits.
+ */
+void morphologyFilter(const Mat& src, Mat& dst, MorphologyOperation operation, int kernelSize) {
+    if (kernelSize <= 0 || kernelSize % 2 == 0) {
+        throw invalid_argument("La taille du noyau doit être un entier positif impair.");
+    }
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.depth() != CV_8U) {
+        throw runtime_error("Les opérations morphologiques n'acceptent que des images 8 bits.");
+    }
+
+    switch (operation) {
+        case MorphologyOperation::Erode:
+        case MorphologyOperation::Dilate:
+            dst = runSingle(src, operation, kernelSize);
+            break;
+        case MorphologyOperation::Open:
+            dst = runSingle(runSingle(src, MorphologyOperation::Erode, kernelSize), MorphologyOperation::Dilate, kernelSize);
+            break;
+        case MorphologyOperation::Close:
+            dst = runSingle(runSingle(src, MorphologyOperation::Dilate, kernelSize), MorphologyOperation::Erode, kernelSize);
+            break;
+        case MorphologyOperation::Gradient: {
+            Mat dilated = runSingle(src, MorphologyOperation::Dilate, kernelSize);
+            Mat eroded = runSingle(src, MorphologyOperation::Erode, kernelSize);
+            const int length = src.cols * src.channels();
+            parallelForRows(src.rows, 0, [&](int rowStart, int rowEnd) {
+                for (int y = rowStart; y < rowEnd; y++) {
+                    uchar* d = dilated.ptr<uchar>(y);
+                    const uchar* e = eroded.ptr<uchar>(y);
+                    for (int x = 0; x < length; x++) {
+                        d[x] = static_cast<uchar>(d[x] - e[x]); // dilatation >= érosion
+                    }
+                }
+            });
+            dst = dilated;
+            break;
+        }
+    }
+}
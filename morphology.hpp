@@ -0,0 +1,20 @@
+#ifndef MORPHOLOGY_HPP
+#define MORPHOLOGY_HPP
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+enum class MorphologyOperation {
+    Erode,
+    Dilate,
+    Open,
+    Close,
+    Gradient
+};
+
+void morphologyFilter(const Mat& src, Mat& dst, MorphologyOperation operation, int kernelSize);
+void morphologyFilterRows(const Mat& src, Mat& dst, MorphologyOperation operation, int kernelSize, int rowStart, int rowEnd);
+
+#endif // MORPHOLOGY_HPP
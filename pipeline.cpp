@@ -0,0 +1,354 @@
+#include "pipeline.hpp"
+#include "gaussianblur.hpp"
+#include "medianfilter.hpp"
+#include "morphology.hpp"
+#include "edgedetection.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+using StageType = FilterPipeline::StageType;
+
+// Étape après fusion : un filtre, suivi éventuellement d'une table appliquée sur ses lignes de sortie.
+struct FusedStage {
+    StageType type;
+    string name;
+    int kernelSize = 0;
+    SeparableKernel gaussianKernel;
+    PointOperation post;
+    bool hasPost = false;
+    int halo = 0;              // lignes lues au-dessus et en dessous de chaque ligne calculée
+    int outputChannels = 1;
+};
+
+/**
+ * @brief Fusionne les étapes de la pile pour une entrée à `inputChannels` canaux.
+ *
+ * Les opérations ponctuelles sont rattachées à l'étape précédente (ou composées entre elles si la pile
+ * commence par l'une d'elles), une conversion en gris d'une image déjà grise est supprimée, et une
+ * conversion en gris est insérée devant Sobel si nécessaire.
+ */
+vector<FusedStage> fuseStages(const vector<FilterPipeline::Stage>& stages, int inputChannels) {
+    vector<FusedStage> fused;
+    int channels = inputChannels;
+
+    auto addGray = [&](const string& name) {
+        if (channels != 3 && channels != 4) {
+            throw runtime_error("Nombre de canaux non supporté pour la conversion en niveaux de gris.");
+        }
+        FusedStage gray;
+        gray.type = StageType::Gray;
+        gray.name = name;
+        gray.outputChannels = 1;
+        fused.push_back(gray);
+        channels = 1;
+    };
+
+    for (const FilterPipeline::Stage& stage : stages) {
+        switch (stage.type) {
+        case StageType::Point:
+            if (!fused.empty()) {
+                FusedStage& last = fused.back();
+                last.post = last.hasPost ? last.post.then(stage.operation) : stage.operation;
+                last.hasPost = true;
+                last.name += " + " + stage.name;
+            } else {
+                FusedStage point;
+                point.type = StageType::Point;
+                point.name = stage.name;
+                point.post = stage.operation;
+                point.hasPost = true;
+                point.outputChannels = channels;
+                fused.push_back(point);
+            }
+            break;
+
+        case StageType::Gray:
+            if (channels != 1) {
+                addGray(stage.name);
+            }
+            break;
+
+        case StageType::Sobel: {
+            if (channels != 1) {
+                addGray("Grayscale");
+            }
+            FusedStage sobel;
+            sobel.type = StageType::Sobel;
+            sobel.name = stage.name;
+            sobel.halo = 1;
+            sobel.outputChannels = 1;
+            fused.push_back(sobel);
+            break;
+        }
+
+        case StageType::Gaussian:
+        case StageType::Median:
+        case StageType::Erode:
+        case StageType::Dilate: {
+            FusedStage stencil;
+            stencil.type = stage.type;
+            stencil.name = stage.name;
+            stencil.kernelSize = stage.kernelSize;
+            stencil.outputChannels = channels;
+            if (stage.type == StageType::Gaussian) {
+                stencil.gaussianKernel = makeFixedPointGaussianKernel(stage.kernelSize, stage.sigma);
+                stencil.halo = stencil.gaussianKernel.radius;
+            } else {
+                stencil.halo = stage.kernelSize / 2;
+            }
+            fused.push_back(stencil);
+            break;
+        }
+        }
+    }
+    return fused;
+}
+
+/**
+ * @brief Calcule les lignes [rowStart, rowEnd) d'une étape, puis lui applique sa table tant qu'elles sont
+ *        dans le cache.
+ */
+void runStageRows(const FusedStage& stage, const Mat& src, Mat& dst, int rowStart, int rowEnd) {
+    switch (stage.type) {
+    case StageType::Gray:
+        grayWithPointOperationRows(src, dst, stage.post, rowStart, rowEnd);
+        return; // la table est déjà appliquée par la conversion
+    case StageType::Point:
+        applyPointOperationRows(src, dst, stage.post, rowStart, rowEnd);
+        return;
+    case StageType::Gaussian:
+        separableGaussianBlurRows(src, dst, stage.gaussianKernel, rowStart, rowEnd);
+        break;
+    case StageType::Median:
+        constantTimeMedianFilterRows(src, dst, stage.kernelSize, rowStart, rowEnd);
+        break;
+    case StageType::Erode:
+        morphologyFilterRows(src, dst, MorphologyOperation::Erode, stage.kernelSize, rowStart, rowEnd);
+        break;
+    case StageType::Dilate:
+        morphologyFilterRows(src, dst, MorphologyOperation::Dilate, stage.kernelSize, rowStart, rowEnd);
+        break;
+    case StageType::Sobel:
+        fusedSobelRows(src, dst, nullptr, rowStart, rowEnd);
+        break;
+    }
+    if (stage.hasPost) {
+        applyPointOperationRows(dst, dst, stage.post, rowStart, rowEnd);
+    }
+}
+
+void checkKernelSize(int kernelSize) {
+    if (kernelSize <= 0 || kernelSize % 2 == 0) {
+        throw invalid_argument("La taille du noyau doit être un entier positif impair.");
+    }
+}
+
+} // namespace
+
+FilterPipeline& FilterPipeline::grayscale() {
+    stages.push_back({StageType::Gray, "Grayscale", 0, 0.0, PointOperation()});
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::pointOperation(const PointOperation& operation, const string& name) {
+    stages.push_back({StageType::Point, name, 0, 0.0, operation});
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::threshold(int thresholdValue) {
+    return pointOperation(PointOperation::threshold(thresholdValue), "Threshold " + to_string(thresholdValue));
+}
+
+FilterPipeline& FilterPipeline::invert() {
+    return pointOperation(PointOperation::invert(), "Invert");
+}
+
+FilterPipeline& FilterPipeline::gamma(double gamma) {
+    return pointOperation(PointOperation::gamma(gamma), "Gamma");
+}
+
+/**
+ * @throws std::invalid_argument Si aucun noyau valide ne peut être construit (voir `makeFixedPointGaussianKernel`).
+ */
+FilterPipeline& FilterPipeline::gaussian(int kernelSize, double sigma) {
+    SeparableKernel kernel = makeFixedPointGaussianKernel(kernelSize, sigma);
+    const int size = 2 * kernel.radius + 1;
+    stages.push_back({StageType::Gaussian, "Gaussian " + to_string(size) + "x" + to_string(size), size, sigma, PointOperation()});
+    return *this;
+}
+
+/**
+ * @throws std::invalid_argument Si `kernelSize` n'est pas un nombre impair entre 3 et MEDIAN_MAX_KERNEL_SIZE.
+ */
+FilterPipeline& FilterPipeline::median(int kernelSize) {
+    if (kernelSize % 2 == 0 || kernelSize < 3 || kernelSize > MEDIAN_MAX_KERNEL_SIZE) {
+        throw invalid_argument("La taille du noyau doit être un nombre impair entre 3 et 255.");
+    }
+    stages.push_back({StageType::Median, "Median " + to_string(kernelSize) + "x" + to_string(kernelSize), kernelSize, 0.0, PointOperation()});
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::erode(int kernelSize) {
+    checkKernelSize(kernelSize);
+    stages.push_back({StageType::Erode, "Erosion " + to_string(kernelSize) + "x" + to_string(kernelSize), kernelSize, 0.0, PointOperation()});
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::dilate(int kernelSize) {
+    checkKernelSize(kernelSize);
+    stages.push_back({StageType::Dilate, "Dilation " + to_string(kernelSize) + "x" + to_string(kernelSize), kernelSize, 0.0, PointOperation()});
+    return *this;
+}
+
+FilterPipeline& FilterPipeline::sobel() {
+    stages.push_back({StageType::Sobel, "Sobel", 0, 0.0, PointOperation()});
+    return *this;
+}
+
+/**
+ * @brief Voisinage (en pixels, de chaque côté) dont dépend un pixel de sortie : somme des rayons des étapes.
+ *
+ * C'est la marge à lire autour d'une tuile pour que la chaîne donne sur la tuile le même résultat que sur
+ * l'image entière.
+ */
+int FilterPipeline::halo() const {
+    int total = 0;
+    for (const Stage& stage : stages) {
+        switch (stage.type) {
+        case StageType::Gaussian:
+        case StageType::Median:
+        case StageType::Erode:
+        case StageType::Dilate:
+            total += stage.kernelSize / 2;
+            break;
+        case StageType::Sobel:
+            total += 1;
+            break;
+        case StageType::Gray:
+        case StageType::Point:
+            break;
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Noms des étapes réellement exécutées pour une entrée à `inputChannels` canaux (après fusion).
+ */
+vector<string> FilterPipeline::fusedStageNames(int inputChannels) const {
+    vector<string> names;
+    for (const FusedStage& stage : fuseStages(stages, inputChannels)) {
+        names.push_back(stage.name);
+    }
+    return names;
+}
+
+/**
+ * @brief Exécute la chaîne sur une image, par bandes de lignes réparties sur le pool de threads.
+ *
+ * Pour une bande de sortie [a, b), l'étape k calcule les lignes [a - H, b + H), où H est la somme des
+ * halos des étapes suivantes (bornée à l'image). Les lignes de halo sont recalculées par les bandes
+ * voisines : c'est le prix à payer pour que les intermédiaires restent dans le cache. La hauteur de
+ * bande est donc d'au moins quatre fois ce halo.
+ *
+ * Les bords des tampons de bande ne coïncident avec ceux de l'image qu'en haut et en bas de celle-ci ;
+ * ailleurs, les lignes qui verraient la bordure d'un tampon ne sont jamais utilisées. Le résultat est
+ * donc identique à l'application successive des filtres sur l'image entière.
+ *
+ * @param input L'image d'entrée (CV_8U, 1 à 4 canaux).
+ * @param timings Si non nul, reçoit le temps de chaque étape fusionnée, cumulé sur tous les threads.
+ * @return Mat L'image résultante (l'entrée elle-même si la chaîne ne fait rien).
+ *
+ * @throws std::runtime_error Si l'image est vide, n'est pas en 8 bits ou n'a pas un nombre de canaux
+ *         compatible avec les étapes.
+ */
+Mat FilterPipeline::run(const Mat& input, vector<StageTiming>* timings) const {
+    if (input.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (input.depth() != CV_8U) {
+        throw runtime_error("La chaîne de filtres n'accepte que des images 8 bits.");
+    }
+
+    const vector<FusedStage> fused = fuseStages(stages, input.channels());
+    const int count = static_cast<int>(fused.size());
+    if (timings) {
+        timings->clear();
+    }
+    if (count == 0) {
+        return input;
+    }
+
+    // Halo cumulé des étapes qui suivent chaque étape
+    vector<int> haloAfter(count, 0);
+    for (int k = count - 2; k >= 0; k--) {
+        haloAfter[k] = haloAfter[k + 1] + fused[k + 1].halo;
+    }
+    const int totalHalo = haloAfter[0] + fused[0].halo;
+
+    // Hauteur de bande : les tampons de toutes les étapes tiennent dans PIPELINE_TILE_BYTES
+    size_t bytesPerRow = 0;
+    for (const FusedStage& stage : fused) {
+        bytesPerRow += static_cast<size_t>(input.cols) * stage.outputChannels;
+    }
+    int bandRows = static_cast<int>(PIPELINE_TILE_BYTES / max<size_t>(bytesPerRow, 1));
+    bandRows = max({bandRows, 4 * totalHalo, PARALLEL_MIN_BAND_ROWS});
+    bandRows = min(bandRows, input.rows);
+    const int bands = (input.rows + bandRows - 1) / bandRows;
+
+    Mat output = pooledMat(input.rows, input.cols, CV_MAKETYPE(CV_8U, fused.back().outputChannels));
+    vector<atomic<long long>> nanoseconds(count);
+    for (auto& value : nanoseconds) {
+        value = 0;
+    }
+
+    ThreadPool::instance().parallelFor(bands, [&](int band) {
+        const int rowStart = band * bandRows;
+        const int rowEnd = min(input.rows, rowStart + bandRows);
+
+        // Source de l'étape courante : une vue sur les lignes [sourceStart, sourceStart + source.rows) de l'image
+        int sourceStart = max(0, rowStart - totalHalo);
+        Mat source = input.rowRange(sourceStart, min(input.rows, rowEnd + totalHalo));
+        Mat buffers[2]; // tampons de bande, en alternance : l'étape k lit l'un et écrit l'autre
+
+        for (int k = 0; k < count; k++) {
+            const FusedStage& stage = fused[k];
+            const int computeStart = max(0, rowStart - haloAfter[k]);
+            const int computeEnd = min(input.rows, rowEnd + haloAfter[k]);
+
+            // La dernière étape écrit directement dans la sortie
+            Mat target;
+            if (k == count - 1) {
+                target = output.rowRange(sourceStart, sourceStart + source.rows);
+            } else {
+                buffers[k % 2] = pooledMat(source.rows, source.cols, CV_MAKETYPE(CV_8U, stage.outputChannels));
+                target = buffers[k % 2];
+            }
+
+            auto begin = chrono::steady_clock::now();
+            runStageRows(stage, source, target, computeStart - sourceStart, computeEnd - sourceStart);
+            nanoseconds[k] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - begin).count();
+
+            if (k < count - 1) {
+                source = target.rowRange(computeStart - sourceStart, computeEnd - sourceStart);
+                sourceStart = computeStart;
+            }
+        }
+    });
+
+    if (timings) {
+        for (int k = 0; k < count; k++) {
+            timings->push_back({fused[k].name, nanoseconds[k] / 1e6});
+        }
+    }
+    return output;
+}
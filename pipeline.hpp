@@ -0,0 +1,76 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+#include "pointoperation.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Budget mémoire des tampons intermédiaires d'une bande : ils doivent tenir dans le cache L2.
+const size_t PIPELINE_TILE_BYTES = 256 * 1024;
+
+// Temps passé dans une étape (après fusion), cumulé sur toutes les bandes et tous les threads.
+struct StageTiming {
+    string name;
+    double milliseconds;
+};
+
+/**
+ * @brief Chaîne de filtres exécutée en un seul passage sur l'image.
+ *
+ * Les étapes sont empilées (`grayscale().gaussian(5).threshold(128)`), puis `run` les fusionne :
+ * - les opérations ponctuelles consécutives sont composées en une seule table ;
+ * - une opération ponctuelle qui suit une étape est appliquée sur les lignes que cette étape vient
+ *   d'écrire (conversion en gris, flou, médian, morphologie, Sobel), sans passage supplémentaire.
+ *
+ * L'image est ensuite traitée par bandes de lignes : pour chaque bande, chaque étape calcule ses lignes
+ * plus le halo nécessaire aux étapes suivantes, dans des tampons de la taille de la bande
+ * (PIPELINE_TILE_BYTES). Aucun intermédiaire de la taille de l'image n'est alloué ; seule la sortie l'est.
+ */
+class FilterPipeline {
+public:
+    FilterPipeline& grayscale();
+    FilterPipeline& pointOperation(const PointOperation& operation, const string& name = "Point operation");
+    FilterPipeline& threshold(int thresholdValue);
+    FilterPipeline& invert();
+    FilterPipeline& gamma(double gamma);
+    FilterPipeline& gaussian(int kernelSize = 3, double sigma = 1.0);
+    FilterPipeline& median(int kernelSize);
+    FilterPipeline& erode(int kernelSize);
+    FilterPipeline& dilate(int kernelSize);
+    FilterPipeline& sobel();
+
+    bool empty() const { return stages.empty(); }
+    size_t size() const { return stages.size(); }
+    void clear() { stages.clear(); }
+
+    vector<string> fusedStageNames(int inputChannels) const;
+    int halo() const;
+    Mat run(const Mat& input, vector<StageTiming>* timings = nullptr) const;
+
+    enum class StageType {
+        Gray,
+        Point,
+        Gaussian,
+        Median,
+        Erode,
+        Dilate,
+        Sobel
+    };
+
+    struct Stage {
+        StageType type;
+        string name;
+        int kernelSize;
+        double sigma;
+        PointOperation operation;
+    };
+
+private:
+    vector<Stage> stages;
+};
+
+#endif // PIPELINE_HPP
@@ -0,0 +1,329 @@
+#include "pointoperation.hpp"
+#include "simd.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+uchar saturate(double value) {
+    return static_cast<uchar>(min(255.0, max(0.0, round(value))));
+}
+
+#if defined(LIBRARY_HAVE_AVX2)
+/**
+ * @brief Table de 256 octets découpée en 16 registres de 16 entrées (dupliqués dans les deux moitiés
+ *        d'un registre AVX2), pour la recherche par vpshufb.
+ */
+struct ShuffleTable {
+    __m256i parts[16];
+
+    explicit ShuffleTable(const array<uchar, 256>& lut) {
+        for (int k = 0; k < 16; k++) {
+            parts[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lut.data() + 16 * k)));
+        }
+    }
+};
+
+/**
+ * @brief Recherche de 32 octets dans la table de 256 entrées.
+ *
+ * À l'étape k, v - 16k est dans [0, 15] uniquement pour les octets de la k-ième tranche. L'addition
+ * saturée de 0x70 laisse ces indices dans [0x70, 0x7F] (vpshufb n'utilise que les 4 bits de poids
+ * faible) et pousse tous les autres à 0x80 ou plus, que vpshufb remplace par 0.
+ *
+ * @note Sur 16 octets (SSSE3), ces 16 étapes coûtent plus cher que 16 lectures scalaires dans la
+ *       table : le chemin vectoriel n'est donc utilisé qu'avec AVX2.
+ */
+inline __m256i lookup32(const ShuffleTable& table, __m256i v) {
+    const __m256i step = _mm256_set1_epi8(16);
+    const __m256i bias = _mm256_set1_epi8(0x70);
+    __m256i result = _mm256_setzero_si256();
+    for (int k = 0; k < 16; k++) {
+        result = _mm256_or_si256(result, _mm256_shuffle_epi8(table.parts[k], _mm256_adds_epu8(v, bias)));
+        v = _mm256_sub_epi8(v, step);
+    }
+    return result;
+}
+#endif
+
+/**
+ * @brief Applique la table sur `length` octets (in et out peuvent être identiques).
+ */
+void lookupRow(const uchar* in, uchar* out, int length, const PointOperation& operation) {
+    int i = 0;
+#if defined(LIBRARY_HAVE_AVX2)
+    if (length >= 32) {
+        const ShuffleTable table(operation.table());
+        for (; i + 32 <= length; i += 32) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), lookup32(table, v));
+        }
+    }
+#endif
+    const uchar* lut = operation.table().data();
+    for (; i < length; i++) {
+        out[i] = lut[in[i]];
+    }
+}
+
+/**
+ * @brief Conversion BGR(A) -> gris d'une ligne, en virgule fixe sur GRAY_SHIFT bits.
+ *
+ * Le chemin SSSE3 place chaque pixel dans quatre mots de 16 bits (B, G, R, 0) avec pshufb, puis
+ * madd + hadd donnent B*cB + G*cG + R*cR en 32 bits : 8 pixels par itération, même arrondi que le
+ * chemin scalaire.
+ */
+void grayRow(const uchar* in, uchar* out, int width, int cn) {
+    const int rounding = 1 << (GRAY_SHIFT - 1);
+    int x = 0;
+
+#if defined(LIBRARY_HAVE_SSSE3)
+    const int o = cn; // décalage d'un pixel au suivant
+    const __m128i lowPair = _mm_setr_epi8(0, -1, 1, -1, 2, -1, -1, -1,
+                                          static_cast<char>(o), -1, static_cast<char>(o + 1), -1, static_cast<char>(o + 2), -1, -1, -1);
+    const __m128i highPair = _mm_setr_epi8(static_cast<char>(2 * o), -1, static_cast<char>(2 * o + 1), -1, static_cast<char>(2 * o + 2), -1, -1, -1,
+                                           static_cast<char>(3 * o), -1, static_cast<char>(3 * o + 1), -1, static_cast<char>(3 * o + 2), -1, -1, -1);
+    const __m128i coeffs = _mm_setr_epi16(GRAY_COEFF_B, GRAY_COEFF_G, GRAY_COEFF_R, 0,
+                                          GRAY_COEFF_B, GRAY_COEFF_G, GRAY_COEFF_R, 0);
+    const __m128i round128 = _mm_set1_epi32(rounding);
+
+    auto fourPixels = [&](const uchar* p) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i a = _mm_madd_epi16(_mm_shuffle_epi8(v, lowPair), coeffs);
+        __m128i b = _mm_madd_epi16(_mm_shuffle_epi8(v, highPair), coeffs);
+        return _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(a, b), round128), GRAY_SHIFT);
+    };
+
+    // Chaque chargement lit 16 octets pour 4 pixels : on s'arrête avant de dépasser la ligne.
+    for (; (x + 4) * cn + 16 <= width * cn; x += 8) {
+        __m128i words = _mm_packs_epi32(fourPixels(in + x * cn), fourPixels(in + (x + 4) * cn));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(words, words));
+    }
+#endif
+
+    for (; x < width; x++) {
+        const uchar* p = in + x * cn;
+        out[x] = static_cast<uchar>((p[0] * GRAY_COEFF_B + p[1] * GRAY_COEFF_G + p[2] * GRAY_COEFF_R + rounding) >> GRAY_SHIFT);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Opération identité.
+ */
+PointOperation::PointOperation() {
+    for (int i = 0; i < 256; i++) {
+        lut[i] = static_cast<uchar>(i);
+    }
+}
+
+/**
+ * @brief Seuillage : 255 si la valeur est strictement supérieure au seuil, 0 sinon.
+ */
+PointOperation PointOperation::threshold(int thresholdValue) {
+    PointOperation operation;
+    for (int i = 0; i < 256; i++) {
+        operation.lut[i] = i > thresholdValue ? 255 : 0;
+    }
+    return operation;
+}
+
+/**
+ * @brief Négatif : 255 - valeur.
+ */
+PointOperation PointOperation::invert() {
+    PointOperation operation;
+    for (int i = 0; i < 256; i++) {
+        operation.lut[i] = static_cast<uchar>(255 - i);
+    }
+    return operation;
+}
+
+/**
+ * @brief Correction gamma : 255 * (valeur / 255)^(1 / gamma). Un gamma > 1 éclaircit les tons moyens.
+ *
+ * @throws std::invalid_argument Si gamma <= 0.
+ */
+PointOperation PointOperation::gamma(double gamma) {
+    if (gamma <= 0) {
+        throw invalid_argument("Le gamma doit être strictement positif.");
+    }
+    PointOperation operation;
+    for (int i = 0; i < 256; i++) {
+        operation.lut[i] = saturate(255.0 * pow(i / 255.0, 1.0 / gamma));
+    }
+    return operation;
+}
+
+/**
+ * @brief Luminosité / contraste : contrast * valeur + brightness, saturé dans [0, 255].
+ */
+PointOperation PointOperation::brightnessContrast(double contrast, int brightness) {
+    PointOperation operation;
+    for (int i = 0; i < 256; i++) {
+        operation.lut[i] = saturate(contrast * i + brightness);
+    }
+    return operation;
+}
+
+/**
+ * @brief Niveaux : ramène [inputBlack, inputWhite] sur [outputBlack, outputWhite] avec un gamma de tons moyens.
+ *
+ * Les valeurs hors de la plage d'entrée sont écrêtées.
+ *
+ * @throws std::invalid_argument Si la plage d'entrée est vide ou si gamma <= 0.
+ */
+PointOperation PointOperation::levels(int inputBlack, int inputWhite, double gamma, int outputBlack, int outputWhite) {
+    if (inputWhite <= inputBlack) {
+        throw invalid_argument("Le point blanc doit être supérieur au point noir.");
+    }
+    if (gamma <= 0) {
+        throw invalid_argument("Le gamma doit être strictement positif.");
+    }
+    PointOperation operation;
+    for (int i = 0; i < 256; i++) {
+        double t = min(1.0, max(0.0, static_cast<double>(i - inputBlack) / (inputWhite - inputBlack)));
+        operation.lut[i] = saturate(outputBlack + (outputWhite - outputBlack) * pow(t, 1.0 / gamma));
+    }
+    return operation;
+}
+
+/**
+ * @brief Opération définie directement par sa table (par exemple calculée à partir d'un histogramme).
+ */
+PointOperation PointOperation::fromTable(const array<uchar, 256>& table) {
+    PointOperation operation;
+    operation.lut = table;
+    return operation;
+}
+
+/**
+ * @brief Composition : applique cette opération puis `next`, en une seule table.
+ */
+PointOperation PointOperation::then(const PointOperation& next) const {
+    PointOperation operation;
+    for (int i = 0; i < 256; i++) {
+        operation.lut[i] = next.lut[lut[i]];
+    }
+    return operation;
+}
+
+bool PointOperation::isIdentity() const {
+    for (int i = 0; i < 256; i++) {
+        if (lut[i] != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Applique une opération ponctuelle sur chaque échantillon d'une image 8 bits.
+ *
+ * Un seul passage sur l'image, par bandes de lignes sur le pool de threads. Les canaux sont tous
+ * traités avec la même table.
+ *
+ * @param src L'image d'entrée (CV_8U, 1 à 4 canaux).
+ * @param dst L'image de sortie, de même taille et de même type.
+ * @param operation L'opération (éventuellement composée) à appliquer.
+ *
+ * @throws std::runtime_error Si l'image est vide ou n'est pas en 8 bits.
+ */
+void applyPointOperation(const Mat& src, Mat& dst, const PointOperation& operation) {
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.depth() != CV_8U) {
+        throw runtime_error("Les opérations ponctuelles n'acceptent que des images 8 bits.");
+    }
+
+    Mat output = pooledMat(src.rows, src.cols, src.type());
+    parallelForRows(src.rows, 0, [&](int rowStart, int rowEnd) {
+        applyPointOperationRows(src, output, operation, rowStart, rowEnd);
+    });
+    dst = output;
+}
+
+/**
+ * @brief Applique l'opération sur les lignes [rowStart, rowEnd) seulement.
+ *
+ * La sortie `dst` doit déjà être allouée (même taille et même type que `src`) ; elle peut être `src`
+ * elle-même.
+ */
+void applyPointOperationRows(const Mat& src, Mat& dst, const PointOperation& operation, int rowStart, int rowEnd) {
+    const int length = src.cols * src.channels();
+    for (int y = rowStart; y < rowEnd; y++) {
+        lookupRow(src.ptr<uchar>(y), dst.ptr<uchar>(y), length, operation);
+    }
+}
+
+/**
+ * @brief Conversion en niveaux de gris suivie d'une opération ponctuelle, en un seul passage.
+ *
+ * Chaque ligne est convertie en virgule fixe (coefficients BT.601 de cvtColor), puis la table est
+ * appliquée sur la ligne de sortie tant qu'elle est encore dans le cache. Une image déjà en niveaux
+ * de gris n'est pas copiée si l'opération est l'identité.
+ *
+ * @param src L'image d'entrée (CV_8U, 1, 3 (BGR) ou 4 (BGRA) canaux ; l'alpha est ignoré).
+ * @param dst L'image de sortie (CV_8UC1).
+ * @param operation L'opération appliquée après la conversion (identité par défaut).
+ *
+ * @throws std::runtime_error Si l'image est vide, n'est pas en 8 bits ou a un nombre de canaux non supporté.
+ */
+void grayWithPointOperation(const Mat& src, Mat& dst, const PointOperation& operation) {
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+    if (src.depth() != CV_8U) {
+        throw runtime_error("Les opérations ponctuelles n'acceptent que des images 8 bits.");
+    }
+
+    const int cn = src.channels();
+    if (cn == 1) {
+        if (operation.isIdentity()) {
+            dst = src;
+        } else {
+            applyPointOperation(src, dst, operation);
+        }
+        return;
+    }
+    if (cn != 3 && cn != 4) {
+        throw runtime_error("Nombre de canaux non supporté pour la conversion en niveaux de gris.");
+    }
+
+    Mat output = pooledMat(src.rows, src.cols, CV_8UC1);
+    parallelForRows(src.rows, 0, [&](int rowStart, int rowEnd) {
+        grayWithPointOperationRows(src, output, operation, rowStart, rowEnd);
+    });
+    dst = output;
+}
+
+/**
+ * @brief Conversion en gris + opération ponctuelle des lignes [rowStart, rowEnd) seulement.
+ *
+ * La sortie `dst` (CV_8UC1, même taille que `src`) doit déjà être allouée. Une entrée à un canal est
+ * simplement passée dans la table.
+ */
+void grayWithPointOperationRows(const Mat& src, Mat& dst, const PointOperation& operation, int rowStart, int rowEnd) {
+    const int cn = src.channels();
+    if (cn == 1) {
+        applyPointOperationRows(src, dst, operation, rowStart, rowEnd);
+        return;
+    }
+
+    const bool identity = operation.isIdentity();
+    for (int y = rowStart; y < rowEnd; y++) {
+        uchar* out = dst.ptr<uchar>(y);
+        grayRow(src.ptr<uchar>(y), out, src.cols, cn);
+        if (!identity) {
+            lookupRow(out, out, src.cols, operation);
+        }
+    }
+}
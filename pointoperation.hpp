@@ -0,0 +1,48 @@
+#ifndef POINTOPERATION_HPP
+#define POINTOPERATION_HPP
+
+#include <opencv2/opencv.hpp>
+#include <array>
+
+using namespace cv;
+using namespace std;
+
+// Coefficients BGR -> gris (BT.601 : 0.114, 0.587, 0.299) en virgule fixe sur 14 bits, comme cvtColor.
+const int GRAY_SHIFT = 14;
+const int GRAY_COEFF_B = 1868;
+const int GRAY_COEFF_G = 9617;
+const int GRAY_COEFF_R = 4899;
+
+/**
+ * @brief Opération ponctuelle sur des pixels 8 bits, compilée en une table de 256 entrées.
+ *
+ * Les opérations se composent avec `then` : une pile de réglages donne une seule table,
+ * appliquée en un seul passage sur l'image.
+ */
+class PointOperation {
+public:
+    PointOperation();
+
+    static PointOperation threshold(int thresholdValue);
+    static PointOperation invert();
+    static PointOperation gamma(double gamma);
+    static PointOperation brightnessContrast(double contrast, int brightness);
+    static PointOperation levels(int inputBlack, int inputWhite, double gamma = 1.0, int outputBlack = 0, int outputWhite = 255);
+    static PointOperation fromTable(const array<uchar, 256>& table);
+
+    PointOperation then(const PointOperation& next) const;
+    bool isIdentity() const;
+
+    uchar operator()(uchar value) const { return lut[value]; }
+    const array<uchar, 256>& table() const { return lut; }
+
+private:
+    array<uchar, 256> lut;
+};
+
+void applyPointOperation(const Mat& src, Mat& dst, const PointOperation& operation);
+void applyPointOperationRows(const Mat& src, Mat& dst, const PointOperation& operation, int rowStart, int rowEnd);
+void grayWithPointOperation(const Mat& src, Mat& dst, const PointOperation& operation = PointOperation());
+void grayWithPointOperationRows(const Mat& src, Mat& dst, const PointOperation& operation, int rowStart, int rowEnd);
+
+#endif // POINTOPERATION_HPP
@@ -0,0 +1,125 @@
+#include "preview.hpp"
+#include "imageprobe.hpp"
+#include "jpeg2000.hpp"
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+// Facteurs de réduction que libjpeg applique dans le domaine DCT, avec le drapeau imread correspondant.
+const int JPEG_SCALES[3][2] = {{8, IMREAD_REDUCED_COLOR_8}, {4, IMREAD_REDUCED_COLOR_4}, {2, IMREAD_REDUCED_COLOR_2}};
+
+/**
+ * @brief Plus grand facteur de réduction DCT (1, 2, 4 ou 8) qui garde `region` au moins aussi grande que
+ *        `targetSize` une fois ajustée dedans.
+ *
+ * L'orientation EXIF appliquée par imread peut échanger largeur et hauteur : le facteur retenu convient
+ * aux deux sens.
+ */
+int jpegScaleFor(const Rect& region, Size targetSize) {
+    if (targetSize.width <= 0 || targetSize.height <= 0) {
+        return 1;
+    }
+    const double scale = max(min(static_cast<double>(targetSize.width) / region.width,
+                                 static_cast<double>(targetSize.height) / region.height),
+                             min(static_cast<double>(targetSize.width) / region.height,
+                                 static_cast<double>(targetSize.height) / region.width));
+    for (const auto& jpegScale : JPEG_SCALES) {
+        if (scale * jpegScale[0] <= 1.0) {
+            return jpegScale[0];
+        }
+    }
+    return 1;
+}
+
+} // namespace
+
+/**
+ * @brief Taille de `source` ajustée dans `target` en gardant les proportions (comme Qt::KeepAspectRatio).
+ */
+Size fitWithin(Size source, Size target) {
+    if (source.width <= 0 || source.height <= 0 || target.width <= 0 || target.height <= 0) {
+        return source;
+    }
+    const double scale = min(static_cast<double>(target.width) / source.width,
+                             static_cast<double>(target.height) / source.height);
+    return Size(max(1, cvRound(source.width * scale)), max(1, cvRound(source.height * scale)));
+}
+
+/**
+ * @brief Charge une image pour l'affichage, ajustée dans `targetSize` en gardant ses proportions.
+ *
+ * Seul ce qui est nécessaire à l'affichage est décodé quand le format le permet :
+ * - JPEG 2000 : le niveau de résolution juste suffisant, et seulement la région demandée ;
+ * - JPEG : libjpeg réduit l'image de 2, 4 ou 8 directement dans le domaine DCT (IMREAD_REDUCED_COLOR_*),
+ *   ce qui évite l'essentiel de l'IDCT et de la conversion de couleurs d'une vignette.
+ * Les autres formats sont décodés entièrement puis réduits.
+ *
+ * @param targetSize Taille de la zone d'affichage ; vide pour garder la taille d'origine (de la région).
+ * @param region Région en pixels de l'image d'origine ; vide pour l'image entière. Elle est ramenée aux
+ *        bornes de l'image.
+ * @return Mat Image 8 bits BGR, vide si le fichier n'a pas pu être lu.
+ */
+Mat loadPreview(const string& path, Size targetSize, const Rect& region) {
+    Mat decoded;
+    Rect area = region;
+    ImageInfo header;
+
+    if (isJpeg2000File(path)) {
+        try {
+            Jpeg2000Info info;
+            if (readJpeg2000Info(path, info)) {
+                area = region.area() > 0 ? region & Rect(0, 0, info.width, info.height) : Rect();
+                if (region.area() > 0 && area.area() == 0) {
+                    return Mat();
+                }
+                decoded = decodeJpeg2000(path, targetSize, area);
+                area = Rect();    // Déjà recadrée par le décodeur
+            }
+        } catch (const exception&) {
+            decoded = Mat();    // Repli sur imread ci-dessous ; un échec rend une Mat vide
+        }
+    } else if (probeImage(path, header) && header.format == "jpeg") {
+        const int scale = jpegScaleFor(region.area() > 0 ? region : Rect(0, 0, header.width, header.height), targetSize);
+        if (scale > 1) {
+            for (const auto& jpegScale : JPEG_SCALES) {
+                if (jpegScale[0] == scale) {
+                    decoded = imread(path, jpegScale[1]);
+                }
+            }
+            // Région ramenée à l'échelle de l'image réduite (en couvrant les pixels partiels)
+            if (!decoded.empty() && area.area() > 0) {
+                const int x0 = area.x / scale, y0 = area.y / scale;
+                area = Rect(x0, y0, (area.x + area.width + scale - 1) / scale - x0,
+                            (area.y + area.height + scale - 1) / scale - y0);
+            }
+        }
+    }
+
+    if (decoded.empty()) {
+        decoded = imread(path, IMREAD_COLOR);
+        if (decoded.empty()) {
+            return decoded;
+        }
+    }
+    if (area.area() > 0) {
+        area &= Rect(0, 0, decoded.cols, decoded.rows);
+        if (area.area() == 0) {
+            return Mat();
+        }
+        decoded = decoded(area);
+    }
+
+    if (targetSize.width <= 0 || targetSize.height <= 0) {
+        return decoded.isContinuous() ? decoded : decoded.clone();
+    }
+    const Size size = fitWithin(decoded.size(), targetSize);
+    if (size == decoded.size()) {
+        return decoded.isContinuous() ? decoded : decoded.clone();
+    }
+    Mat preview;
+    resize(decoded, preview, size, 0, 0, size.area() < decoded.size().area() ? INTER_AREA : INTER_LINEAR);
+    return preview;
+}
@@ -0,0 +1,16 @@
+#ifndef PREVIEW_HPP
+#define PREVIEW_HPP
+
+#include <opencv2/opencv.hpp>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+// Taille des vignettes de la grille de la bibliothèque.
+const int THUMBNAIL_SIDE = 210;
+
+Size fitWithin(Size source, Size target);
+Mat loadPreview(const string& path, Size targetSize, const Rect& region = Rect());
+
+#endif // PREVIEW_HPP
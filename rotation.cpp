@@ -0,0 +1,450 @@
+#include "rotation.hpp"
+#include "simd.hpp"
+#include "threadpool.hpp"
+#include "bufferpool.hpp"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+// Pixel opaque de Bytes octets : l'affectation est une copie de taille fixe, sans boucle sur les canaux.
+template <int Bytes>
+struct Pixel {
+    uchar bytes[Bytes];
+};
+
+/**
+ * @brief Appelle f(integral_constant<int, N>) pour les tailles de pixel gérées, retourne false sinon.
+ */
+template <typename F>
+bool dispatchPixelBytes(size_t bytes, F&& f) {
+    switch (bytes) {
+    case 1: f(integral_constant<int, 1>()); return true;
+    case 2: f(integral_constant<int, 2>()); return true;
+    case 3: f(integral_constant<int, 3>()); return true;
+    case 4: f(integral_constant<int, 4>()); return true;
+    case 6: f(integral_constant<int, 6>()); return true;
+    case 8: f(integral_constant<int, 8>()); return true;
+    case 12: f(integral_constant<int, 12>()); return true;
+    case 16: f(integral_constant<int, 16>()); return true;
+    default: return false;
+    }
+}
+
+#if defined(LIBRARY_HAVE_SSE2)
+/**
+ * @brief Transposition d'un bloc 8x8 d'octets : out[c] reçoit la colonne c des lignes in[0..7].
+ */
+inline void transposeBlock8x8(const uchar* const* in, uchar* const* out) {
+    __m128i r[8];
+    for (int j = 0; j < 8; j++) {
+        r[j] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in[j]));
+    }
+    __m128i a0 = _mm_unpacklo_epi8(r[0], r[1]);
+    __m128i a1 = _mm_unpacklo_epi8(r[2], r[3]);
+    __m128i a2 = _mm_unpacklo_epi8(r[4], r[5]);
+    __m128i a3 = _mm_unpacklo_epi8(r[6], r[7]);
+    __m128i b0 = _mm_unpacklo_epi16(a0, a1);
+    __m128i b1 = _mm_unpackhi_epi16(a0, a1);
+    __m128i b2 = _mm_unpacklo_epi16(a2, a3);
+    __m128i b3 = _mm_unpackhi_epi16(a2, a3);
+    __m128i columns[4] = {_mm_unpacklo_epi32(b0, b2), _mm_unpackhi_epi32(b0, b2),
+                          _mm_unpacklo_epi32(b1, b3), _mm_unpackhi_epi32(b1, b3)};
+    for (int k = 0; k < 4; k++) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out[2 * k]), columns[k]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out[2 * k + 1]), _mm_srli_si128(columns[k], 8));
+    }
+}
+
+/**
+ * @brief Transposition d'un bloc 4x4 de pixels de 4 octets (BGRA, CV_32F...).
+ */
+inline void transposeBlock4x4(const uchar* const* in, uchar* const* out) {
+    __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[0]));
+    __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[1]));
+    __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[2]));
+    __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in[3]));
+    __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[0]), _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[1]), _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[2]), _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[3]), _mm_unpackhi_epi64(t2, t3));
+}
+#endif
+
+/**
+ * @brief Quart de tour d'une tuile de la destination [y0, y1) x [x0, x1).
+ *
+ * Sens horaire : dst(y, x) = src(H - 1 - x, y). Sens anti-horaire : dst(y, x) = src(x, W - 1 - y).
+ * Les blocs complets de 8x8 (pixels d'un octet) ou 4x4 (pixels de 4 octets) sont transposés en
+ * registres ; le sens de rotation ne change que l'ordre des lignes lues ou écrites.
+ */
+template <int Bytes, bool Clockwise>
+void rotateTile(const Mat& src, Mat& dst, int y0, int y1, int x0, int x1) {
+    const int height = src.rows;
+    const int width = src.cols;
+    int yEnd = y0;
+    int xEnd = x1;
+
+#if defined(LIBRARY_HAVE_SSE2)
+    if constexpr (Bytes == 1 || Bytes == 4) {
+        constexpr int M = Bytes == 1 ? 8 : 4;
+        yEnd = y0 + (y1 - y0) / M * M;
+        xEnd = x0 + (x1 - x0) / M * M;
+        const uchar* in[M];
+        uchar* out[M];
+        for (int yb = y0; yb < yEnd; yb += M) {
+            for (int xb = x0; xb < xEnd; xb += M) {
+                for (int j = 0; j < M; j++) {
+                    in[j] = Clockwise ? src.ptr<uchar>(height - 1 - xb - j) + yb * Bytes
+                                      : src.ptr<uchar>(xb + j) + (width - yb - M) * Bytes;
+                    out[j] = Clockwise ? dst.ptr<uchar>(yb + j) + xb * Bytes
+                                       : dst.ptr<uchar>(yb + M - 1 - j) + xb * Bytes;
+                }
+                if constexpr (Bytes == 1) {
+                    transposeBlock8x8(in, out);
+                } else {
+                    transposeBlock4x4(in, out);
+                }
+            }
+        }
+    }
+#endif
+
+    auto scalar = [&](int ys, int ye, int xs, int xe) {
+        for (int y = ys; y < ye; y++) {
+            Pixel<Bytes>* out = dst.ptr<Pixel<Bytes>>(y);
+            for (int x = xs; x < xe; x++) {
+                out[x] = Clockwise ? src.ptr<Pixel<Bytes>>(height - 1 - x)[y] : src.ptr<Pixel<Bytes>>(x)[width - 1 - y];
+            }
+        }
+    };
+    scalar(yEnd, y1, x0, x1);     // lignes restantes sous les blocs complets
+    scalar(y0, yEnd, xEnd, x1);   // colonnes restantes à droite
+}
+
+template <int Bytes, bool Clockwise>
+void rotateQuarterRows(const Mat& src, Mat& dst, int rowStart, int rowEnd) {
+    for (int ty = rowStart; ty < rowEnd; ty += ROTATION_BLOCK) {
+        for (int tx = 0; tx < dst.cols; tx += ROTATION_BLOCK) {
+            rotateTile<Bytes, Clockwise>(src, dst, ty, min(ty + ROTATION_BLOCK, rowEnd), tx, min(tx + ROTATION_BLOCK, dst.cols));
+        }
+    }
+}
+
+/**
+ * @brief Demi-tour des lignes [rowStart, rowEnd) : dst(y, x) = src(H - 1 - y, W - 1 - x).
+ */
+template <int Bytes>
+void rotateHalfRows(const Mat& src, Mat& dst, int rowStart, int rowEnd) {
+    const int width = src.cols;
+    for (int y = rowStart; y < rowEnd; y++) {
+        const Pixel<Bytes>* in = src.ptr<Pixel<Bytes>>(src.rows - 1 - y);
+        Pixel<Bytes>* out = dst.ptr<Pixel<Bytes>>(y);
+        int x = 0;
+#if defined(LIBRARY_HAVE_SSSE3)
+        if constexpr (Bytes == 1) {
+            const __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+            for (; x + 16 <= width; x += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + width - 16 - x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_shuffle_epi8(v, reverse));
+            }
+        }
+#endif
+#if defined(LIBRARY_HAVE_SSE2)
+        if constexpr (Bytes == 4) {
+            for (; x + 4 <= width; x += 4) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + width - 4 - x));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3)));
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            out[x] = in[width - 1 - x];
+        }
+    }
+}
+
+// Précision des poids de l'interpolation bilinéaire en virgule fixe (255 * 2^20 tient sur 32 bits).
+const int ROTATION_WEIGHT_BITS = 10;
+
+// Noyau cubique de Keys (a = -0.75, comme INTER_CUBIC d'OpenCV) pour une position fractionnaire f.
+inline void cubicWeights(float f, float w[4]) {
+    const float a = -0.75f;
+    w[0] = ((a * (f + 1) - 5 * a) * (f + 1) + 8 * a) * (f + 1) - 4 * a;
+    w[1] = ((a + 2) * f - (a + 3)) * f * f + 1;
+    w[2] = ((a + 2) * (1 - f) - (a + 3)) * (1 - f) * (1 - f) + 1;
+    w[3] = 1 - w[0] - w[1] - w[2];
+}
+
+/**
+ * @brief Interpole un pixel de la source en (fx, fy) ; les voisins hors de l'image valent 0.
+ *
+ * Avec Checked = false, tous les voisins sont supposés dans l'image (intérieur de la ligne).
+ */
+template <RotationInterpolation Interpolation, bool Checked, int CN>
+inline void samplePixel(const Mat& src, float fx, float fy, uchar* out) {
+    constexpr int taps = Interpolation == RotationInterpolation::Bilinear ? 2 : 4;
+    constexpr int offset = Interpolation == RotationInterpolation::Bilinear ? 0 : 1;
+    // À l'intérieur, fx et fy sont positifs : la troncature suffit
+    const int ix = Checked ? static_cast<int>(floor(fx)) : static_cast<int>(fx);
+    const int iy = Checked ? static_cast<int>(floor(fy)) : static_cast<int>(fy);
+    const float ax = fx - ix;
+    const float ay = fy - iy;
+
+    if constexpr (Interpolation == RotationInterpolation::Bilinear && !Checked) {
+        // Intérieur bilinéaire : poids entiers sur ROTATION_WEIGHT_BITS bits
+        const int one = 1 << ROTATION_WEIGHT_BITS;
+        const int wx1 = static_cast<int>(ax * one + 0.5f);
+        const int wy1 = static_cast<int>(ay * one + 0.5f);
+        const uchar* p0 = src.ptr<uchar>(iy) + ix * CN;
+        const uchar* p1 = src.ptr<uchar>(iy + 1) + ix * CN;
+        for (int c = 0; c < CN; c++) {
+            const int top = p0[c] * (one - wx1) + p0[c + CN] * wx1;
+            const int bottom = p1[c] * (one - wx1) + p1[c + CN] * wx1;
+            out[c] = static_cast<uchar>((top * (one - wy1) + bottom * wy1 + (1 << (2 * ROTATION_WEIGHT_BITS - 1))) >> (2 * ROTATION_WEIGHT_BITS));
+        }
+        return;
+    }
+
+    float wx[4], wy[4];
+    if (Interpolation == RotationInterpolation::Bilinear) {
+        wx[0] = 1 - ax; wx[1] = ax;
+        wy[0] = 1 - ay; wy[1] = ay;
+    } else {
+        cubicWeights(ax, wx);
+        cubicWeights(ay, wy);
+    }
+
+    float sum[4] = {0, 0, 0, 0};
+    for (int j = 0; j < taps; j++) {
+        const int y = iy - offset + j;
+        if (Checked && (y < 0 || y >= src.rows)) {
+            continue;
+        }
+        const uchar* row = src.ptr<uchar>(y);
+        for (int i = 0; i < taps; i++) {
+            const int x = ix - offset + i;
+            if (Checked && (x < 0 || x >= src.cols)) {
+                continue;
+            }
+            const float w = wx[i] * wy[j];
+            const uchar* p = row + x * CN;
+            for (int c = 0; c < CN; c++) {
+                sum[c] += w * p[c];
+            }
+        }
+    }
+    for (int c = 0; c < CN; c++) {
+        out[c] = static_cast<uchar>(min(255.0f, max(0.0f, sum[c] + 0.5f)));
+    }
+}
+
+/**
+ * @brief Une ligne de la rotation quelconque.
+ *
+ * Les coordonnées source sont colX[x] + rowX et colY[x] + rowY (termes de colonne précalculés une fois
+ * pour toute l'image). Elles varient linéairement le long de la ligne : les pixels dont tous les voisins
+ * sont dans l'image forment un seul intervalle, calculé analytiquement puis ajusté aux bornes. Seuls les
+ * pixels en dehors de cet intervalle testent leurs voisins un par un.
+ */
+template <RotationInterpolation Interpolation, int CN>
+void rotateArbitraryRow(const Mat& src, uchar* out, int width, const float* colX, const float* colY,
+                        float rowX, float rowY, double stepX, double stepY) {
+    constexpr int before = Interpolation == RotationInterpolation::Bilinear ? 0 : 1;
+    constexpr int after = Interpolation == RotationInterpolation::Bilinear ? 1 : 2;
+
+    // Le pixel x est « intérieur » si ses voisins [i - before, i + after] sont dans l'image sur les deux axes.
+    auto interior = [&](int x) {
+        const float fx = colX[x] + rowX;
+        const float fy = colY[x] + rowY;
+        return fx >= before && fy >= before && fx < src.cols - after && fy < src.rows - after;
+    };
+    // Intervalle réel des x tels que lo <= origin + step * x < hi.
+    double first = 0, last = width;
+    auto clip = [&](double origin, double step, double lo, double hi) {
+        if (fabs(step) < 1e-12) {
+            if (origin < lo || origin >= hi) {
+                last = first;
+            }
+            return;
+        }
+        double a = (lo - origin) / step;
+        double b = (hi - origin) / step;
+        first = max(first, min(a, b));
+        last = min(last, max(a, b));
+    };
+    clip(colX[0] + rowX, stepX, before, src.cols - after);
+    clip(colY[0] + rowY, stepY, before, src.rows - after);
+
+    int spanStart = min(width, max(0, static_cast<int>(ceil(first))));
+    int spanEnd = max(spanStart, min(width, static_cast<int>(ceil(last))));
+    // Ajuste les bornes au test exact en flottants (les arrondis peuvent décaler d'un pixel)
+    while (spanStart < spanEnd && !interior(spanStart)) {
+        spanStart++;
+    }
+    while (spanEnd > spanStart && !interior(spanEnd - 1)) {
+        spanEnd--;
+    }
+    while (spanStart > 0 && interior(spanStart - 1)) {
+        spanStart--;
+    }
+    while (spanEnd < width && interior(spanEnd)) {
+        spanEnd++;
+    }
+
+    auto border = [&](int xs, int xe) {
+        for (int x = xs; x < xe; x++) {
+            const float fx = colX[x] + rowX;
+            const float fy = colY[x] + rowY;
+            // Entièrement hors de l'image (aucun voisin) : fond noir
+            if (fx <= -1 - before || fy <= -1 - before || fx >= src.cols + before || fy >= src.rows + before) {
+                fill(out + x * CN, out + (x + 1) * CN, 0);
+            } else {
+                samplePixel<Interpolation, true, CN>(src, fx, fy, out + x * CN);
+            }
+        }
+    };
+    border(0, spanStart);
+    for (int x = spanStart; x < spanEnd; x++) {
+        samplePixel<Interpolation, false, CN>(src, colX[x] + rowX, colY[x] + rowY, out + x * CN);
+    }
+    border(spanEnd, width);
+}
+
+} // namespace
+
+/**
+ * @brief Rotation d'un multiple de 90 degrés dans le sens horaire, en un seul passage.
+ *
+ * 90 et 270 degrés : la destination est parcourue par tuiles de ROTATION_BLOCK x ROTATION_BLOCK pixels,
+ * dont les lectures (colonnes de la source) restent dans le cache ; le retournement est intégré à
+ * l'indexation, sans transpose + flip ni image intermédiaire. Les pixels de 1 et 4 octets sont transposés
+ * par blocs en registres SSE2. 180 degrés : chaque ligne est lue à l'envers (pshufb / pshufd).
+ * Les bandes de lignes de la destination sont réparties sur le pool de threads.
+ *
+ * @param src L'image d'entrée (tout type).
+ * @param dst L'image de sortie. Pour 0 quart de tour (modulo 4), `dst` partage les données de `src`
+ *        (aucune copie) : cloner avant de la modifier.
+ * @param quarterTurns Le nombre de quarts de tour horaires (négatif : anti-horaire).
+ *
+ * @throws std::runtime_error Si l'image d'entrée est vide.
+ */
+void rotateQuarterTurns(const Mat& src, Mat& dst, int quarterTurns) {
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+
+    const int turns = ((quarterTurns % 4) + 4) % 4;
+    if (turns == 0) {
+        dst = src;
+        return;
+    }
+
+    const bool swapped = turns != 2;
+    Mat output = pooledMat(swapped ? src.cols : src.rows, swapped ? src.rows : src.cols, src.type());
+    const bool handled = dispatchPixelBytes(src.elemSize(), [&](auto bytes) {
+        constexpr int Bytes = decltype(bytes)::value;
+        parallelForRows(output.rows, 0, [&](int rowStart, int rowEnd) {
+            if (turns == 1) {
+                rotateQuarterRows<Bytes, true>(src, output, rowStart, rowEnd);
+            } else if (turns == 3) {
+                rotateQuarterRows<Bytes, false>(src, output, rowStart, rowEnd);
+            } else {
+                rotateHalfRows<Bytes>(src, output, rowStart, rowEnd);
+            }
+        });
+    });
+    if (!handled) {
+        // Pixels de taille inhabituelle (CV_64FC3...) : implémentation d'OpenCV
+        rotate(src, output, turns == 1 ? ROTATE_90_CLOCKWISE : turns == 2 ? ROTATE_180 : ROTATE_90_COUNTERCLOCKWISE);
+    }
+    dst = output;
+}
+
+/**
+ * @brief Rotation d'un angle quelconque (sens horaire) autour du centre de l'image.
+ *
+ * Chaque pixel de la destination est ramené dans la source par la rotation inverse. Les termes qui ne
+ * dépendent que de la colonne sont précalculés une fois ; une ligne n'ajoute qu'une constante par axe.
+ * Les lignes sont réparties sur le pool de threads. Les zones découvertes sont noires. Un angle multiple
+ * de 90 degrés passe par `rotateQuarterTurns` (exact, sans interpolation).
+ *
+ * @param src L'image d'entrée (tout type pour un multiple de 90 degrés, sinon CV_8U de 1 à 4 canaux).
+ * @param dst L'image de sortie.
+ * @param angle L'angle en degrés, positif dans le sens horaire.
+ * @param interpolation Bilinéaire (2x2 voisins) ou bicubique (4x4, noyau de Keys).
+ * @param expand Si vrai, la sortie est agrandie pour contenir toute l'image tournée ; sinon elle garde
+ *        la taille de l'entrée (les coins sont rognés), ce qui convient au redressement de scans.
+ *
+ * @throws std::runtime_error Si l'image est vide, ou si l'angle n'est pas un multiple de 90 degrés et que
+ *         l'image n'est pas en 8 bits ou a plus de 4 canaux.
+ */
+void rotateArbitrary(const Mat& src, Mat& dst, double angle, RotationInterpolation interpolation, bool expand) {
+    if (src.empty()) {
+        throw runtime_error("L'image d'entrée est vide.");
+    }
+
+    const double turns = angle / 90.0;
+    const long quarter = lround(turns);
+    if (fabs(turns - quarter) < 1e-9 && (expand || quarter % 2 == 0 || src.rows == src.cols)) {
+        rotateQuarterTurns(src, dst, static_cast<int>(quarter % 4));
+        return;
+    }
+    if (src.depth() != CV_8U || src.channels() > 4) {
+        throw runtime_error("La rotation d'angle quelconque n'accepte que des images 8 bits de 1 à 4 canaux.");
+    }
+
+    const double radians = angle * CV_PI / 180.0;
+    const double c = cos(radians);
+    const double s = sin(radians);
+    const int width = expand ? static_cast<int>(ceil(fabs(src.cols * c) + fabs(src.rows * s) - 1e-6)) : src.cols;
+    const int height = expand ? static_cast<int>(ceil(fabs(src.cols * s) + fabs(src.rows * c) - 1e-6)) : src.rows;
+
+    // Rotation inverse : sx = c * dx + s * dy + cx, sy = -s * dx + c * dy + cy (dx, dy relatifs au centre de la sortie)
+    const double cx = (src.cols - 1) / 2.0;
+    const double cy = (src.rows - 1) / 2.0;
+    const double dcx = (width - 1) / 2.0;
+    const double dcy = (height - 1) / 2.0;
+    vector<float> colX(width), colY(width);
+    for (int x = 0; x < width; x++) {
+        colX[x] = static_cast<float>(c * (x - dcx));
+        colY[x] = static_cast<float>(-s * (x - dcx));
+    }
+
+    Mat output = pooledMat(height, width, src.type());
+    auto run = [&](auto channels, auto method) {
+        constexpr int CN = decltype(channels)::value;
+        constexpr RotationInterpolation Interpolation = decltype(method)::value;
+        parallelForRows(height, 0, [&](int rowStart, int rowEnd) {
+            for (int y = rowStart; y < rowEnd; y++) {
+                const float rowX = static_cast<float>(s * (y - dcy) + cx);
+                const float rowY = static_cast<float>(c * (y - dcy) + cy);
+                rotateArbitraryRow<Interpolation, CN>(src, output.ptr<uchar>(y), width, colX.data(), colY.data(), rowX, rowY, c, -s);
+            }
+        });
+    };
+    auto withChannels = [&](auto method) {
+        switch (src.channels()) {
+        case 1: run(integral_constant<int, 1>(), method); break;
+        case 2: run(integral_constant<int, 2>(), method); break;
+        case 3: run(integral_constant<int, 3>(), method); break;
+        default: run(integral_constant<int, 4>(), method); break;
+        }
+    };
+    if (interpolation == RotationInterpolation::Bicubic) {
+        withChannels(integral_constant<RotationInterpolation, RotationInterpolation::Bicubic>());
+    } else {
+        withChannels(integral_constant<RotationInterpolation, RotationInterpolation::Bilinear>());
+    }
+    dst = output;
+}
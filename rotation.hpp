@@ -0,0 +1,21 @@
+#ifndef ROTATION_HPP
+#define ROTATION_HPP
+
+#include <opencv2/opencv.hpp>
+
+using namespace cv;
+using namespace std;
+
+// Côté (en pixels) des tuiles de la rotation par quarts de tour : source et destination d'une tuile tiennent dans L1.
+const int ROTATION_BLOCK = 64;
+
+enum class RotationInterpolation {
+    Bilinear,
+    Bicubic
+};
+
+void rotateQuarterTurns(const Mat& src, Mat& dst, int quarterTurns);
+void rotateArbitrary(const Mat& src, Mat& dst, double angle,
+                     RotationInterpolation interpolation = RotationInterpolation::Bilinear, bool expand = true);
+
+#endif // ROTATION_HPP
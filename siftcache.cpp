@@ -0,0 +1,457 @@
+#include "siftcache.hpp"
+#include "imageprobe.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+const char SIDECAR_MAGIC[8] = {'L', 'I', 'B', 'S', 'I', 'F', 'T', '\0'};
+const uint32_t SIDECAR_VERSION = 2;
+const uint32_t FLAG_BYTE_DESCRIPTORS = 1;   // descripteurs entiers dans [0, 255], stockés sur un octet
+const uint32_t MAX_DESCRIPTOR_COLS = 4096;  // garde-fou contre un en-tête corrompu (SIFT : 128)
+
+// En-tête du fichier compagnon (boutisme de la machine : le cache est local, il n'est pas échangé).
+struct SidecarHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t fileSize;        // taille de l'image au moment du calcul
+    int64_t modified;         // date de modification de l'image (horloge du système de fichiers)
+    uint64_t contentHash;     // hashFileContent de l'image
+    int32_t imageWidth;       // dimensions de l'image décodée sur laquelle les points-clés ont été détectés
+    int32_t imageHeight;
+    uint32_t keypointCount;
+    uint32_t descriptorCols;
+};
+
+static_assert(sizeof(SidecarHeader) == 56, "SidecarHeader ne doit pas contenir de remplissage");
+
+struct KeypointRecord {
+    float x, y, size, angle, response;
+    int32_t octave, classId;
+};
+static_assert(sizeof(KeypointRecord) == 28, "KeypointRecord doit rester compact");
+
+// Position du champ `modified` dans l'en-tête, pour le mettre à jour sur place.
+const streamoff MODIFIED_OFFSET = offsetof(SidecarHeader, modified);
+
+const uint64_t PRIME1 = 11400714785074694791ULL;
+const uint64_t PRIME2 = 14029467366897019727ULL;
+const uint64_t PRIME3 = 1609587929392839161ULL;
+const uint64_t PRIME4 = 9650029242287828579ULL;
+const uint64_t PRIME5 = 2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const uchar* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t round64(uint64_t acc, uint64_t input) {
+    return rotl(acc + input * PRIME2, 31) * PRIME1;
+}
+
+inline uint64_t merge64(uint64_t acc, uint64_t value) {
+    return (acc ^ round64(0, value)) * PRIME1 + PRIME4;
+}
+
+/**
+ * @brief État de xxHash64 (graine 0), alimenté par blocs successifs.
+ */
+class ContentHasher {
+public:
+    void update(const uchar* data, size_t length) {
+        total += length;
+        // Compléter le bloc de 32 octets en attente
+        if (pendingLength > 0) {
+            size_t take = min(length, sizeof(pending) - pendingLength);
+            memcpy(pending + pendingLength, data, take);
+            pendingLength += take;
+            data += take;
+            length -= take;
+            if (pendingLength < sizeof(pending)) {
+                return;
+            }
+            consume(pending);
+            pendingLength = 0;
+        }
+        for (; length >= 32; data += 32, length -= 32) {
+            consume(data);
+        }
+        memcpy(pending, data, length);
+        pendingLength = length;
+    }
+
+    uint64_t digest() const {
+        uint64_t h;
+        if (total >= 32) {
+            h = rotl(lanes[0], 1) + rotl(lanes[1], 7) + rotl(lanes[2], 12) + rotl(lanes[3], 18);
+            for (uint64_t lane : lanes) {
+                h = merge64(h, lane);
+            }
+        } else {
+            h = PRIME5;
+        }
+        h += total;
+
+        const uchar* p = pending;
+        size_t remaining = pendingLength;
+        for (; remaining >= 8; p += 8, remaining -= 8) {
+            h = rotl(h ^ round64(0, read64(p)), 27) * PRIME1 + PRIME4;
+        }
+        if (remaining >= 4) {
+            uint32_t v;
+            memcpy(&v, p, sizeof(v));
+            h = rotl(h ^ (static_cast<uint64_t>(v) * PRIME1), 23) * PRIME2 + PRIME3;
+            p += 4;
+            remaining -= 4;
+        }
+        for (; remaining > 0; p++, remaining--) {
+            h = rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+        }
+
+        h ^= h >> 33;
+        h *= PRIME2;
+        h ^= h >> 29;
+        h *= PRIME3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    void consume(const uchar* block) {
+        for (int i = 0; i < 4; i++) {
+            lanes[i] = round64(lanes[i], read64(block + 8 * i));
+        }
+    }
+
+    uint64_t lanes[4] = {PRIME1 + PRIME2, PRIME2, 0, 0ULL - PRIME1};
+    uchar pending[32];
+    size_t pendingLength = 0;
+    uint64_t total = 0;
+};
+
+// Les descripteurs SIFT d'OpenCV sont des entiers saturés dans [0, 255] : un octet suffit.
+bool fitsInBytes(const Mat& descriptors) {
+    for (int y = 0; y < descriptors.rows; y++) {
+        const float* row = descriptors.ptr<float>(y);
+        for (int x = 0; x < descriptors.cols; x++) {
+            if (row[x] < 0 || row[x] > 255 || row[x] != static_cast<float>(static_cast<int>(row[x]))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Mêmes dimensions, à l'orientation près (le décodeur applique l'orientation EXIF, pas l'en-tête lu par probeImage).
+bool sameDimensions(int width, int height, const Size& size) {
+    return (width == size.width && height == size.height) || (width == size.height && height == size.width);
+}
+
+/**
+ * @brief Dimensions attendues des points-clés : celles de l'image fournie, sinon la pleine résolution lue
+ *        dans l'en-tête du fichier (taille vide si le format n'est pas reconnu).
+ */
+Size expectedSize(const string& imagePath, const Mat& image) {
+    if (!image.empty()) {
+        return image.size();
+    }
+    ImageInfo info;
+    return probeImage(imagePath, info) ? Size(info.width, info.height) : Size();
+}
+
+} // namespace
+
+/**
+ * @brief Empreinte 64 bits (xxHash64) du contenu d'un fichier, lu par blocs de 1 Mo.
+ *
+ * @throws std::runtime_error Si le fichier ne peut pas être lu.
+ */
+uint64_t hashFileContent(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        throw runtime_error("Impossible d'ouvrir le fichier : " + path);
+    }
+    ContentHasher hasher;
+    vector<char> buffer(1 << 20);
+    while (file) {
+        file.read(buffer.data(), static_cast<streamsize>(buffer.size()));
+        hasher.update(reinterpret_cast<const uchar*>(buffer.data()), static_cast<size_t>(file.gcount()));
+    }
+    return hasher.digest();
+}
+
+/**
+ * @brief Taille et date de modification d'un fichier ; false s'il n'existe pas.
+ */
+bool fileStamp(const string& path, uint64_t& size, int64_t& modified) {
+    error_code error;
+    size = filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    auto time = filesystem::last_write_time(path, error);
+    if (error) {
+        return false;
+    }
+    modified = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+string siftSidecarPath(const string& imagePath) {
+    return imagePath + SIFT_SIDECAR_EXTENSION;
+}
+
+/**
+ * @brief Détecte les points-clés SIFT et calcule leurs descripteurs (l'image est convertie en gris).
+ *
+ * @throws std::invalid_argument Si l'image est vide.
+ */
+SiftFeatures computeSiftFeatures(const Mat& image) {
+    if (image.empty()) {
+        throw invalid_argument("L'image d'entrée est vide.");
+    }
+    Mat gray;
+    if (image.channels() == 3) {
+        cvtColor(image, gray, COLOR_BGR2GRAY);
+    } else if (image.channels() == 4) {
+        cvtColor(image, gray, COLOR_BGRA2GRAY);
+    } else {
+        gray = image;
+    }
+
+    SiftFeatures features;
+    Ptr<SIFT> sift = SIFT::create();
+    sift->detectAndCompute(gray, noArray(), features.keypoints, features.descriptors);
+    return features;
+}
+
+/**
+ * @brief Charge les caractéristiques SIFT depuis le fichier compagnon de l'image, s'il est à jour.
+ *
+ * Le cache est valide si l'image a la même taille et, soit la même date de modification (aucune lecture
+ * de l'image), soit le même contenu (empreinte recalculée ; la date enregistrée est alors mise à jour).
+ * Un fichier compagnon absent, tronqué ou d'une autre version est ignoré.
+ *
+ * @param decodedSize Dimensions de l'image décodée sur laquelle les points-clés doivent avoir été détectés
+ *        (un aperçu réduit n'a pas les mêmes coordonnées que l'image entière). Vide : non vérifiées.
+ * @return true si `features` a été rempli depuis le cache.
+ */
+bool loadSiftSidecar(const string& imagePath, SiftFeatures& features, const Size& decodedSize) {
+    uint64_t size;
+    int64_t modified;
+    if (!fileStamp(imagePath, size, modified)) {
+        return false;
+    }
+
+    const string sidecar = siftSidecarPath(imagePath);
+    ifstream file(sidecar, ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    SidecarHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || memcmp(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC)) != 0
+        || header.version != SIDECAR_VERSION || header.fileSize != size
+        || header.descriptorCols > MAX_DESCRIPTOR_COLS
+        || (!decodedSize.empty() && !sameDimensions(header.imageWidth, header.imageHeight, decodedSize))) {
+        return false;
+    }
+
+    if (header.modified != modified) {
+        try {
+            if (hashFileContent(imagePath) != header.contentHash) {
+                return false;
+            }
+        } catch (const exception&) {
+            return false;
+        }
+        // Même contenu, fichier simplement touché : la prochaine lecture n'aura pas à le relire
+        fstream update(sidecar, ios::binary | ios::in | ios::out);
+        if (update.is_open()) {
+            update.seekp(MODIFIED_OFFSET);
+            update.write(reinterpret_cast<const char*>(&modified), sizeof(modified));
+        }
+    }
+
+    // La taille annoncée doit correspondre exactement au fichier, avant toute allocation
+    const bool bytes = (header.flags & FLAG_BYTE_DESCRIPTORS) != 0;
+    const uint64_t descriptorBytes = static_cast<uint64_t>(header.keypointCount) * header.descriptorCols * (bytes ? 1 : sizeof(float));
+    error_code error;
+    const uint64_t sidecarSize = filesystem::file_size(sidecar, error);
+    if (error || sidecarSize != sizeof(header) + header.keypointCount * sizeof(KeypointRecord) + descriptorBytes) {
+        return false;
+    }
+
+    vector<KeypointRecord> records(header.keypointCount);
+    if (!file.read(reinterpret_cast<char*>(records.data()), static_cast<streamsize>(records.size() * sizeof(KeypointRecord)))) {
+        return false;
+    }
+    SiftFeatures loaded;
+    loaded.keypoints.reserve(records.size());
+    for (const KeypointRecord& r : records) {
+        loaded.keypoints.emplace_back(r.x, r.y, r.size, r.angle, r.response, r.octave, r.classId);
+    }
+
+    if (header.keypointCount > 0) {
+        const int rows = static_cast<int>(header.keypointCount);
+        const int cols = static_cast<int>(header.descriptorCols);
+        if (bytes) {
+            Mat stored(rows, cols, CV_8UC1);
+            if (!file.read(reinterpret_cast<char*>(stored.ptr<uchar>(0)), static_cast<streamsize>(descriptorBytes))) {
+                return false;
+            }
+            stored.convertTo(loaded.descriptors, CV_32F);
+        } else {
+            loaded.descriptors.create(rows, cols, CV_32FC1);
+            if (!file.read(reinterpret_cast<char*>(loaded.descriptors.ptr<float>(0)), static_cast<streamsize>(descriptorBytes))) {
+                return false;
+            }
+        }
+    }
+
+    features = loaded;
+    return true;
+}
+
+/**
+ * @brief Écrit le fichier compagnon de l'image (écriture dans un fichier temporaire puis renommage,
+ *        pour qu'un lecteur ne voie jamais un cache à moitié écrit).
+ *
+ * Les descripteurs sont stockés sur un octet par valeur quand c'est sans perte (cas de SIFT), soit
+ * 128 octets + 28 octets par point-clé.
+ *
+ * @param decodedSize Dimensions de l'image sur laquelle les points-clés ont été détectés.
+ * @return false si l'image n'existe pas ou si le fichier ne peut pas être écrit.
+ */
+bool saveSiftSidecar(const string& imagePath, const SiftFeatures& features, const Size& decodedSize) {
+    SidecarHeader header;
+    memcpy(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    header.version = SIDECAR_VERSION;
+    header.flags = 0;
+    header.imageWidth = decodedSize.width;
+    header.imageHeight = decodedSize.height;
+    if (!fileStamp(imagePath, header.fileSize, header.modified)) {
+        return false;
+    }
+    try {
+        header.contentHash = hashFileContent(imagePath);
+    } catch (const exception&) {
+        return false;
+    }
+
+    Mat descriptors = features.descriptors;
+    if (!descriptors.empty() && descriptors.type() != CV_32FC1) {
+        descriptors.convertTo(descriptors, CV_32F);
+    }
+    header.keypointCount = static_cast<uint32_t>(features.keypoints.size());
+    header.descriptorCols = descriptors.empty() ? 0 : static_cast<uint32_t>(descriptors.cols);
+    if (!descriptors.empty() && descriptors.rows != static_cast<int>(header.keypointCount)) {
+        return false;
+    }
+    const bool bytes = fitsInBytes(descriptors);
+    if (bytes) {
+        header.flags |= FLAG_BYTE_DESCRIPTORS;
+    }
+
+    const string sidecar = siftSidecarPath(imagePath);
+    // Un fichier temporaire par thread : l'index et la fenêtre de détails peuvent calculer la même image en même temps
+    const string temporary = sidecar + "." + to_string(std::hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        vector<KeypointRecord> records;
+        records.reserve(features.keypoints.size());
+        for (const KeyPoint& k : features.keypoints) {
+            records.push_back({k.pt.x, k.pt.y, k.size, k.angle, k.response, k.octave, k.class_id});
+        }
+        file.write(reinterpret_cast<const char*>(records.data()), static_cast<streamsize>(records.size() * sizeof(KeypointRecord)));
+
+        vector<uchar> row(header.descriptorCols);
+        for (int y = 0; y < descriptors.rows; y++) {
+            const float* values = descriptors.ptr<float>(y);
+            if (bytes) {
+                transform(values, values + descriptors.cols, row.begin(), [](float v) { return static_cast<uchar>(v); });
+                file.write(reinterpret_cast<const char*>(row.data()), static_cast<streamsize>(row.size()));
+            } else {
+                file.write(reinterpret_cast<const char*>(values), static_cast<streamsize>(descriptors.cols * sizeof(float)));
+            }
+        }
+        if (!file) {
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::rename(temporary, sidecar, error);
+    if (error) {
+        filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Caractéristiques SIFT d'une image de la bibliothèque : depuis le cache si possible, sinon calculées
+ *        puis enregistrées à côté de l'image.
+ *
+ * Le cache n'est repris que s'il a été calculé à la même résolution : celle de `image` si elle est fournie
+ * (éventuellement un aperçu réduit), la pleine résolution sinon.
+ *
+ * @param imagePath Le chemin complet de l'image.
+ * @param image L'image déjà chargée, si l'appelant l'a (sinon elle est lue seulement si le cache est périmé).
+ *
+ * @throws std::invalid_argument Si le cache est périmé et que l'image ne peut pas être chargée.
+ */
+SiftFeatures siftFeaturesFor(const string& imagePath, const Mat& image) {
+    SiftFeatures features;
+    if (loadSiftSidecar(imagePath, features, expectedSize(imagePath, image))) {
+        return features;
+    }
+
+    const Mat decoded = image.empty() ? imread(imagePath, IMREAD_COLOR) : image;
+    features = computeSiftFeatures(decoded);
+    saveSiftSidecar(imagePath, features, decoded.size()); // Sans cache, les points-clés seront recalculés
+    return features;
+}
+
+/**
+ * @brief Nombre de correspondances fiables entre deux ensembles de descripteurs (test du ratio de Lowe).
+ *
+ * Pour chaque descripteur de `query`, les deux plus proches voisins de `candidate` sont cherchés
+ * (distance L2) ; la correspondance est retenue si le premier est nettement plus proche que le second.
+ */
+int countSiftMatches(const SiftFeatures& query, const SiftFeatures& candidate, float ratio) {
+    if (query.descriptors.rows == 0 || candidate.descriptors.rows < 2) {
+        return 0;
+    }
+    BFMatcher matcher(NORM_L2);
+    vector<vector<DMatch>> matches;
+    matcher.knnMatch(query.descriptors, candidate.descriptors, matches, 2);
+
+    int good = 0;
+    for (const vector<DMatch>& pair : matches) {
+        if (pair.size() == 2 && pair[0].distance < ratio * pair[1].distance) {
+            good++;
+        }
+    }
+    return good;
+}
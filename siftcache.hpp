@@ -0,0 +1,32 @@
+#ifndef SIFTCACHE_HPP
+#define SIFTCACHE_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+// Extension du fichier compagnon, ajoutée au nom complet de l'image (photo.jpg -> photo.jpg.sift).
+const string SIFT_SIDECAR_EXTENSION = ".sift";
+
+// Points-clés SIFT d'une image et leurs descripteurs (CV_32F, une ligne de 128 valeurs par point-clé).
+struct SiftFeatures {
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+};
+
+uint64_t hashFileContent(const string& path);
+bool fileStamp(const string& path, uint64_t& size, int64_t& modified);
+string siftSidecarPath(const string& imagePath);
+
+SiftFeatures computeSiftFeatures(const Mat& image);
+bool loadSiftSidecar(const string& imagePath, SiftFeatures& features, const Size& decodedSize = Size());
+bool saveSiftSidecar(const string& imagePath, const SiftFeatures& features, const Size& decodedSize);
+SiftFeatures siftFeaturesFor(const string& imagePath, const Mat& image = Mat());
+
+int countSiftMatches(const SiftFeatures& query, const SiftFeatures& candidate, float ratio = 0.75f);
+
+#endif // SIFTCACHE_HPP
@@ -0,0 +1,23 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+// Détection des jeux d'instructions disponibles pour les chemins vectorisés des filtres.
+// GCC/Clang définissent __SSE2__/__AVX2__, MSVC définit _M_X64 (SSE2 toujours présent)
+// et __AVX2__ lorsque /arch:AVX2 est utilisé.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LIBRARY_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define LIBRARY_HAVE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define LIBRARY_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+
+#endif // SIMD_HPP
@@ -0,0 +1,211 @@
+#include "threadpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+
+using namespace std;
+
+namespace {
+
+// Vrai dans les threads du pool : un parallelFor imbriqué s'exécute alors séquentiellement,
+// ce qui évite qu'un thread du pool attende des tâches qui ne pourront jamais démarrer.
+thread_local bool insideWorker = false;
+
+// État partagé d'un appel à parallelFor. Les threads auxiliaires peuvent démarrer après la fin
+// de l'appel : ils ne touchent alors qu'à `next`, d'où le shared_ptr.
+struct Batch {
+    atomic<int> next{0};
+    int taskCount = 0;
+    const function<void(int)>* task = nullptr;
+
+    mutex doneMutex;
+    condition_variable doneCondition;
+    int completed = 0;
+    exception_ptr error;
+
+    void run() {
+        for (int i = next++; i < taskCount; i = next++) {
+            exception_ptr failure;
+            try {
+                (*task)(i);
+            } catch (...) {
+                failure = current_exception();
+            }
+            lock_guard<mutex> lock(doneMutex);
+            if (failure && !error) {
+                error = failure;
+            }
+            if (++completed == taskCount) {
+                doneCondition.notify_all();
+            }
+        }
+    }
+};
+
+int defaultThreadCount() {
+    if (const char* value = getenv("LIBRARY_THREADS")) {
+        int threads = atoi(value);
+        if (threads > 0) {
+            return threads;
+        }
+    }
+    return max(1u, thread::hardware_concurrency());
+}
+
+} // namespace
+
+ThreadPool& ThreadPool::instance() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() : stopping(false), threads(1) {
+    startWorkers(defaultThreadCount());
+}
+
+ThreadPool::~ThreadPool() {
+    stopWorkers();
+}
+
+/**
+ * @brief Change le nombre de threads utilisés (thread appelant compris).
+ *
+ * Ne doit pas être appelée pendant un parallelFor.
+ */
+void ThreadPool::setThreadCount(int count) {
+    count = max(1, count);
+    if (count == threadCount()) {
+        return;
+    }
+    stopWorkers();
+    startWorkers(count);
+}
+
+int ThreadPool::threadCount() const {
+    lock_guard<mutex> lock(queueMutex);
+    return threads;
+}
+
+/**
+ * @brief Exécute task(0) ... task(taskCount - 1) en parallèle et attend la fin de toutes les tâches.
+ *
+ * Les indices sont distribués dynamiquement : le thread appelant participe au calcul, et un thread
+ * qui termine tôt prend la tâche suivante. La première exception levée par une tâche est relancée
+ * dans le thread appelant une fois toutes les tâches terminées.
+ */
+void ThreadPool::parallelFor(int taskCount, const function<void(int)>& task) {
+    if (taskCount <= 0) {
+        return;
+    }
+
+    int helpers;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        helpers = min(static_cast<int>(workers.size()), taskCount - 1);
+    }
+    if (helpers <= 0 || insideWorker) {
+        for (int i = 0; i < taskCount; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    auto batch = make_shared<Batch>();
+    batch->taskCount = taskCount;
+    batch->task = &task;
+    {
+        lock_guard<mutex> lock(queueMutex);
+        for (int i = 0; i < helpers; i++) {
+            jobs.emplace_back([batch]() { batch->run(); });
+        }
+    }
+    queueCondition.notify_all();
+
+    batch->run();
+
+    unique_lock<mutex> lock(batch->doneMutex);
+    batch->doneCondition.wait(lock, [&]() { return batch->completed == taskCount; });
+    if (batch->error) {
+        rethrow_exception(batch->error);
+    }
+}
+
+void ThreadPool::startWorkers(int count) {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = false;
+        threads = count;
+    }
+    for (int i = 0; i < count - 1; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+void ThreadPool::stopWorkers() {
+    {
+        lock_guard<mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::workerLoop() {
+    insideWorker = true;
+    while (true) {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(queueMutex);
+            queueCondition.wait(lock, [&]() { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return; // arrêt demandé et plus rien à exécuter
+            }
+            job = move(jobs.front());
+            jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void setParallelThreadCount(int threads) {
+    ThreadPool::instance().setThreadCount(threads);
+}
+
+int parallelThreadCount() {
+    return ThreadPool::instance().threadCount();
+}
+
+/**
+ * @brief Découpe les lignes [0, rows) en bandes et appelle body(rowStart, rowEnd) sur le pool.
+ *
+ * Chaque bande lit `halo` lignes au-dessus et en dessous d'elle dans l'image source partagée
+ * (rayon du noyau) : ces lignes de recouvrement sont recalculées par chaque bande. Les bandes font
+ * donc au moins 4 * halo lignes (et PARALLEL_MIN_BAND_ROWS) pour que ce surcoût reste marginal.
+ * Il y a jusqu'à 4 bandes par thread pour équilibrer la charge.
+ *
+ * @param rows Le nombre de lignes de la sortie.
+ * @param halo Le nombre de lignes lues de part et d'autre de chaque bande.
+ * @param body La fonction appelée pour chaque bande, qui ne doit écrire que dans ses propres lignes.
+ */
+void parallelForRows(int rows, int halo, const function<void(int, int)>& body) {
+    if (rows <= 0) {
+        return;
+    }
+    const int minBandRows = max(PARALLEL_MIN_BAND_ROWS, 4 * halo);
+    const int bands = max(1, min(rows / minBandRows, 4 * parallelThreadCount()));
+    if (bands == 1) {
+        body(0, rows);
+        return;
+    }
+
+    ThreadPool::instance().parallelFor(bands, [&](int band) {
+        int rowStart = static_cast<int>(static_cast<long long>(rows) * band / bands);
+        int rowEnd = static_cast<int>(static_cast<long long>(rows) * (band + 1) / bands);
+        body(rowStart, rowEnd);
+    });
+}
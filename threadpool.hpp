@@ -0,0 +1,54 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Hauteur minimale d'une bande de lignes, quel que soit le rayon du noyau.
+const int PARALLEL_MIN_BAND_ROWS = 16;
+
+/**
+ * @brief Pool de threads partagé par les filtres d'ImageProccessing.
+ *
+ * Les threads sont créés une seule fois. Le nombre de threads vaut par défaut le nombre de cœurs
+ * (ou la variable d'environnement LIBRARY_THREADS) et peut être changé avec `setThreadCount`.
+ */
+class ThreadPool {
+public:
+    static ThreadPool& instance();
+
+    ~ThreadPool();
+
+    void setThreadCount(int threads);
+    int threadCount() const;
+
+    void parallelFor(int taskCount, const function<void(int)>& task);
+
+private:
+    ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void startWorkers(int threads);
+    void stopWorkers();
+    void workerLoop();
+
+    vector<thread> workers;
+    deque<function<void()>> jobs;
+    mutable mutex queueMutex;
+    condition_variable queueCondition;
+    bool stopping;
+    int threads;
+};
+
+void setParallelThreadCount(int threads);
+int parallelThreadCount();
+void parallelForRows(int rows, int halo, const function<void(int, int)>& body);
+
+#endif // THREADPOOL_HPP
@@ -0,0 +1,580 @@
+#include "thumbnailcache.hpp"
+#include "imagehash.hpp"
+#include "preview.hpp"
+#include "siftcache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+const char ENTRY_MAGIC[8] = {'L', 'I', 'B', 'T', 'H', 'M', 'B', '\0'};
+const char INDEX_MAGIC[8] = {'L', 'I', 'B', 'T', 'I', 'D', 'X', '\0'};
+const uint32_t CACHE_VERSION = 1;
+const int LEVEL_COUNT = sizeof(THUMBNAIL_LEVELS) / sizeof(THUMBNAIL_LEVELS[0]);
+const int LARGEST_LEVEL = THUMBNAIL_LEVELS[LEVEL_COUNT - 1];
+const int JPEG_QUALITY = 90;
+const uint32_t MAX_INDEX_PATH = 4096;     // garde-fou contre un index corrompu
+const string INDEX_FILE = "index";
+const string JOURNAL_FILE = "index.journal";
+// Types d'enregistrement du journal, ajoutés à la suite entre deux écritures complètes de l'index.
+const uint8_t JOURNAL_SOURCE = 1;    // chemin, taille, date, empreinte
+const uint8_t JOURNAL_USE = 2;       // empreinte, dernière utilisation
+// Les utilisations restent en mémoire et sont journalisées par lots de cette taille (et à chaque flush()).
+const size_t JOURNAL_USE_BATCH = 256;
+// Au-delà de ce nombre d'enregistrements, l'index est réécrit et le journal vidé.
+const size_t JOURNAL_MAX_RECORDS = 16384;
+
+// En-tête d'un fichier de vignettes, suivi d'une table (côté, taille) par niveau puis des JPEG à la suite.
+struct EntryHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t levelCount;
+};
+static_assert(sizeof(EntryHeader) == 16, "EntryHeader ne doit pas contenir de remplissage");
+
+struct LevelRecord {
+    int32_t side;
+    uint32_t bytes;
+};
+static_assert(sizeof(LevelRecord) == 8, "LevelRecord doit rester compact");
+
+template <typename T>
+bool readValue(istream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return static_cast<bool>(in);
+}
+
+template <typename T>
+void writeValue(ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Lit un chemin précédé de sa longueur ; refuse les longueurs aberrantes d'un fichier corrompu.
+bool readPath(istream& in, string& path) {
+    uint32_t length;
+    if (!readValue(in, length) || length > MAX_INDEX_PATH) {
+        return false;
+    }
+    path.assign(length, '\0');
+    in.read(&path[0], length);
+    return static_cast<bool>(in);
+}
+
+void writePath(ostream& out, const string& path) {
+    writeValue(out, static_cast<uint32_t>(path.size()));
+    out.write(path.data(), static_cast<streamsize>(path.size()));
+}
+
+// Image ramenée dans un carré de `side` pixels (jamais agrandie).
+Mat fitDown(const Mat& image, int side) {
+    const Size size = fitWithin(image.size(), Size(side, side));
+    if (size.width >= image.cols) {
+        return image;
+    }
+    Mat smaller;
+    resize(image, smaller, size, 0, 0, INTER_AREA);
+    return smaller;
+}
+
+} // namespace
+
+ThumbnailCache& ThumbnailCache::instance() {
+    static ThumbnailCache cache;
+    return cache;
+}
+
+ThumbnailCache::ThumbnailCache()
+    : maxBytes(THUMBNAIL_CACHE_DEFAULT_BYTES), totalBytes(0), useCounter(0), dirty(false), journalRecords(0) {}
+
+ThumbnailCache::~ThumbnailCache() {
+    flush();
+}
+
+/**
+ * @brief Ouvre (ou crée) le cache dans `directory` et relit son index.
+ *
+ * Les entrées sont reprises des fichiers `.thumb` présents dans le répertoire ; l'index et son journal
+ * n'apportent que les chemins connus et l'ordre d'utilisation. Un index absent ou corrompu ne fait donc
+ * perdre aucune vignette. Un journal non vide (session interrompue) est fusionné dans l'index dès l'ouverture.
+ */
+void ThumbnailCache::open(const string& directory, size_t maxBytes) {
+    lock_guard<mutex> guard(lock);
+    if (!this->directory.empty()) {
+        saveIndex();
+        journal.close();
+    }
+    this->directory = directory;
+    this->maxBytes = maxBytes;
+    sources.clear();
+    entries.clear();
+    totalBytes = 0;
+    useCounter = 0;
+    dirty = false;
+
+    error_code error;
+    filesystem::create_directories(directory, error);
+    if (error) {
+        cerr << "Cannot create the thumbnail cache " << directory << ": " << error.message() << endl;
+        this->directory.clear();
+        return;
+    }
+    const bool replayed = loadIndex();
+
+    // Les chemins dont la vignette a disparu ne servent plus qu'à grossir l'index
+    for (auto source = sources.begin(); source != sources.end();) {
+        source = entries.count(source->second.hash) > 0 ? next(source) : sources.erase(source);
+    }
+    dirty = replayed;
+    evict();
+    if (dirty) {
+        saveIndex();
+    }
+    if (!journal.is_open()) {
+        openJournal(false);
+    }
+}
+
+bool ThumbnailCache::isOpen() const {
+    lock_guard<mutex> guard(lock);
+    return !directory.empty();
+}
+
+void ThumbnailCache::setMaxBytes(size_t maxBytes) {
+    lock_guard<mutex> guard(lock);
+    this->maxBytes = maxBytes;
+    evict();
+}
+
+size_t ThumbnailCache::usedBytes() const {
+    lock_guard<mutex> guard(lock);
+    return totalBytes;
+}
+
+/**
+ * @brief Vignette de l'image ajustée dans un carré de `side` pixels.
+ *
+ * Elle est lue depuis le plus petit niveau du cache qui suffit. Si l'image n'est pas dans le cache (ou a
+ * changé), elle est décodée une fois au plus grand niveau (loadPreview : décodage réduit JPEG / JPEG 2000)
+ * et sa pyramide est enregistrée. Au-delà du plus grand niveau, ou si le cache n'est pas ouvert, l'image est
+ * simplement chargée avec loadPreview.
+ *
+ * @return Mat Image 8 bits BGR, vide si l'image n'a pas pu être lue.
+ */
+Mat ThumbnailCache::thumbnail(const string& imagePath, int side) {
+    if (side > LARGEST_LEVEL || !isOpen()) {
+        return loadPreview(imagePath, Size(side, side));
+    }
+    uint64_t hash;
+    if (!contentHash(imagePath, hash)) {
+        return Mat();
+    }
+
+    bool cached;
+    {
+        lock_guard<mutex> guard(lock);
+        cached = entries.count(hash) > 0;
+    }
+    Mat level;
+    if (cached && readLevel(hash, side, level)) {
+        lock_guard<mutex> guard(lock);
+        auto entry = entries.find(hash);
+        if (entry != entries.end()) {
+            entry->second.lastUse = ++useCounter;
+            markUsed(hash);
+            dirty = true;
+        }
+        return fitDown(level, side);
+    }
+
+    level = loadPreview(imagePath, Size(LARGEST_LEVEL, LARGEST_LEVEL));
+    if (level.empty()) {
+        return level;
+    }
+    uint64_t bytes;
+    if (writeEntry(hash, level, bytes)) {
+        lock_guard<mutex> guard(lock);
+        auto entry = entries.find(hash);
+        if (entry != entries.end()) {
+            totalBytes -= entry->second.bytes;
+        }
+        entries[hash] = {bytes, ++useCounter};
+        totalBytes += bytes;
+        markUsed(hash);
+        dirty = true;
+        evict();
+    }
+    return fitDown(level, side);
+}
+
+// Réécrit l'index complet (chemins connus et ordre d'utilisation) s'il a changé, et vide le journal.
+void ThumbnailCache::flush() {
+    lock_guard<mutex> guard(lock);
+    saveIndex();
+    journalUses();    // Sans effet si l'index a été écrit ; sinon les utilisations restent au moins journalisées
+}
+
+// Supprime toutes les vignettes, l'index et son journal.
+void ThumbnailCache::clear() {
+    lock_guard<mutex> guard(lock);
+    if (directory.empty()) {
+        return;
+    }
+    error_code error;
+    for (const auto& entry : entries) {
+        filesystem::remove(entryPath(entry.first), error);
+    }
+    filesystem::remove(indexPath(), error);
+    sources.clear();
+    entries.clear();
+    totalBytes = 0;
+    dirty = false;
+    openJournal(true);
+}
+
+string ThumbnailCache::entryPath(uint64_t hash) const {
+    return (filesystem::path(directory) / (hashToHex(hash) + THUMBNAIL_EXTENSION)).string();
+}
+
+string ThumbnailCache::indexPath() const {
+    return (filesystem::path(directory) / INDEX_FILE).string();
+}
+
+string ThumbnailCache::journalPath() const {
+    return (filesystem::path(directory) / JOURNAL_FILE).string();
+}
+
+/**
+ * @brief Empreinte du contenu de l'image, recalculée seulement si sa taille ou sa date a changé.
+ */
+bool ThumbnailCache::contentHash(const string& imagePath, uint64_t& hash) {
+    uint64_t size;
+    int64_t modified;
+    if (!fileStamp(imagePath, size, modified)) {
+        return false;
+    }
+    {
+        lock_guard<mutex> guard(lock);
+        auto source = sources.find(imagePath);
+        if (source != sources.end() && source->second.size == size && source->second.modified == modified) {
+            hash = source->second.hash;
+            return true;
+        }
+    }
+    try {
+        hash = hashFileContent(imagePath);
+    } catch (const runtime_error&) {
+        return false;    // Image illisible : pas de vignette, l'appelant reçoit une Mat vide
+    }
+    lock_guard<mutex> guard(lock);
+    sources[imagePath] = {size, modified, hash};
+    journalSource(imagePath, sources[imagePath]);
+    dirty = true;
+    return true;
+}
+
+/**
+ * @brief Décode le plus petit niveau d'au moins `side` pixels (ou le plus grand s'il n'y en a pas).
+ *
+ * Les tailles de la table sont vérifiées contre celle du fichier avant toute allocation : une entrée
+ * tronquée ou corrompue est traitée comme absente (la vignette est alors régénérée).
+ */
+bool ThumbnailCache::readLevel(uint64_t hash, int side, Mat& level) const {
+    const string path = entryPath(hash);
+    error_code error;
+    const uint64_t fileSize = filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    ifstream file(path, ios::binary);
+    EntryHeader header;
+    if (!readValue(file, header) || memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) != 0
+        || header.version != CACHE_VERSION || header.levelCount == 0 || header.levelCount > 16) {
+        return false;
+    }
+    vector<LevelRecord> records(header.levelCount);
+    file.read(reinterpret_cast<char*>(records.data()), static_cast<streamsize>(records.size() * sizeof(LevelRecord)));
+    if (!file) {
+        return false;
+    }
+
+    size_t chosen = records.size() - 1;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].side >= side) {
+            chosen = i;
+            break;
+        }
+    }
+    uint64_t offset = 0;
+    for (size_t i = 0; i < chosen; i++) {
+        offset += records[i].bytes;
+    }
+    const uint64_t dataStart = sizeof(EntryHeader) + records.size() * sizeof(LevelRecord);
+    if (records[chosen].bytes == 0 || dataStart + offset + records[chosen].bytes > fileSize) {
+        return false;
+    }
+    vector<uchar> encoded(records[chosen].bytes);
+    file.seekg(static_cast<streamoff>(offset), ios::cur);
+    file.read(reinterpret_cast<char*>(encoded.data()), static_cast<streamsize>(encoded.size()));
+    if (!file) {
+        return false;
+    }
+    level = imdecode(encoded, IMREAD_COLOR);
+    return !level.empty();
+}
+
+/**
+ * @brief Écrit la pyramide de `image` (au plus grand niveau) dans le fichier de l'entrée.
+ *
+ * Le fichier est écrit à côté puis renommé : une vignette n'est jamais lue à moitié écrite, même si deux
+ * threads produisent la même entrée.
+ */
+bool ThumbnailCache::writeEntry(uint64_t hash, const Mat& image, uint64_t& bytes) const {
+    vector<LevelRecord> records(LEVEL_COUNT);
+    vector<vector<uchar>> encoded(LEVEL_COUNT);
+    const vector<int> parameters = {IMWRITE_JPEG_QUALITY, JPEG_QUALITY};
+    for (int i = 0; i < LEVEL_COUNT; i++) {
+        if (!imencode(".jpg", fitDown(image, THUMBNAIL_LEVELS[i]), encoded[i], parameters)) {
+            return false;
+        }
+        records[i] = {THUMBNAIL_LEVELS[i], static_cast<uint32_t>(encoded[i].size())};
+    }
+
+    const string path = entryPath(hash);
+    const string temporary = path + "." + to_string(std::hash<thread::id>()(this_thread::get_id())) + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        EntryHeader header;
+        memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+        header.version = CACHE_VERSION;
+        header.levelCount = static_cast<uint32_t>(LEVEL_COUNT);
+        writeValue(file, header);
+        file.write(reinterpret_cast<const char*>(records.data()), static_cast<streamsize>(records.size() * sizeof(LevelRecord)));
+        for (const vector<uchar>& level : encoded) {
+            file.write(reinterpret_cast<const char*>(level.data()), static_cast<streamsize>(level.size()));
+        }
+        if (!file) {
+            return false;
+        }
+        bytes = static_cast<uint64_t>(file.tellp());
+    }
+    error_code error;
+    filesystem::rename(temporary, path, error);
+    if (error) {
+        filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Supprime les entrées les moins récemment utilisées jusqu'à revenir sous `maxBytes`.
+ *
+ * L'entrée la plus récente est toujours gardée, et les chemins qui menaient aux entrées supprimées sont
+ * retirés de l'index. Appelée avec `lock` déjà pris.
+ */
+void ThumbnailCache::evict() {
+    if (totalBytes <= maxBytes || entries.size() <= 1) {
+        return;
+    }
+    vector<pair<uint64_t, uint64_t>> byUse;    // (dernière utilisation, empreinte)
+    byUse.reserve(entries.size());
+    for (const auto& entry : entries) {
+        byUse.emplace_back(entry.second.lastUse, entry.first);
+    }
+    sort(byUse.begin(), byUse.end());
+
+    error_code error;
+    unordered_set<uint64_t> evicted;
+    for (size_t i = 0; i + 1 < byUse.size() && totalBytes > maxBytes; i++) {
+        auto entry = entries.find(byUse[i].second);
+        filesystem::remove(entryPath(entry->first), error);
+        totalBytes -= entry->second.bytes;
+        evicted.insert(entry->first);
+        entries.erase(entry);
+    }
+    for (auto source = sources.begin(); source != sources.end();) {
+        source = evicted.count(source->second.hash) > 0 ? sources.erase(source) : next(source);
+    }
+    dirty = true;
+}
+
+/**
+ * @brief Relit l'index, rejoue son journal puis recense les fichiers de vignettes présents.
+ *
+ * Un enregistrement incomplet en fin de journal (arrêt pendant l'écriture) est ignoré. Appelée avec `lock`
+ * déjà pris.
+ *
+ * @return true si le journal contenait des modifications qui ne sont pas encore dans l'index.
+ */
+bool ThumbnailCache::loadIndex() {
+    unordered_map<uint64_t, uint64_t> lastUses;
+    ifstream file(indexPath(), ios::binary);
+    char magic[8];
+    uint32_t version, sourceCount, entryCount;
+    if (file.is_open() && file.read(magic, sizeof(magic)) && memcmp(magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+        && readValue(file, version) && version == CACHE_VERSION && readValue(file, sourceCount)
+        && readValue(file, entryCount)) {
+        for (uint32_t i = 0; i < sourceCount; i++) {
+            string path;
+            Source source;
+            if (!readPath(file, path) || !readValue(file, source.size) || !readValue(file, source.modified)
+                || !readValue(file, source.hash)) {
+                break;
+            }
+            sources[path] = source;
+        }
+        for (uint32_t i = 0; i < entryCount; i++) {
+            uint64_t hash, lastUse;
+            if (!readValue(file, hash) || !readValue(file, lastUse)) {
+                break;
+            }
+            lastUses[hash] = lastUse;
+        }
+    }
+
+    bool replayed = false;
+    ifstream log(journalPath(), ios::binary);
+    uint8_t kind;
+    while (log.is_open() && readValue(log, kind)) {
+        if (kind == JOURNAL_SOURCE) {
+            string path;
+            Source source;
+            if (!readPath(log, path) || !readValue(log, source.size) || !readValue(log, source.modified)
+                || !readValue(log, source.hash)) {
+                break;
+            }
+            sources[path] = source;
+        } else if (kind == JOURNAL_USE) {
+            uint64_t hash, lastUse;
+            if (!readValue(log, hash) || !readValue(log, lastUse)) {
+                break;
+            }
+            lastUses[hash] = lastUse;
+        } else {
+            break;
+        }
+        replayed = true;
+    }
+
+    error_code error;
+    for (const filesystem::directory_entry& item : filesystem::directory_iterator(directory, error)) {
+        uint64_t hash;
+        if (item.path().extension() != THUMBNAIL_EXTENSION || !hashFromHex(item.path().stem().string(), hash)) {
+            continue;
+        }
+        const uint64_t bytes = item.file_size(error);
+        if (error) {
+            continue;
+        }
+        auto lastUse = lastUses.find(hash);
+        entries[hash] = {bytes, lastUse != lastUses.end() ? lastUse->second : 0};
+        totalBytes += bytes;
+        useCounter = max(useCounter, entries[hash].lastUse);
+    }
+    return replayed;
+}
+
+// Écrit l'index s'il a changé. Appelée avec `lock` déjà pris.
+void ThumbnailCache::saveIndex() {
+    if (!dirty || directory.empty()) {
+        return;
+    }
+    const string path = indexPath();
+    const string temporary = path + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        file.write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        writeValue(file, CACHE_VERSION);
+        writeValue(file, static_cast<uint32_t>(sources.size()));
+        writeValue(file, static_cast<uint32_t>(entries.size()));
+        for (const auto& source : sources) {
+            writePath(file, source.first);
+            writeValue(file, source.second.size);
+            writeValue(file, source.second.modified);
+            writeValue(file, source.second.hash);
+        }
+        for (const auto& entry : entries) {
+            writeValue(file, entry.first);
+            writeValue(file, entry.second.lastUse);
+        }
+        if (!file) {
+            cerr << "Cannot write the thumbnail cache index " << temporary << endl;
+            return;
+        }
+    }
+    error_code error;
+    filesystem::rename(temporary, path, error);
+    if (!error) {
+        dirty = false;
+        openJournal(true);
+    }
+}
+
+// Ouvre le journal en ajout, ou le vide quand l'index vient d'être réécrit. Appelée avec `lock` déjà pris.
+void ThumbnailCache::openJournal(bool truncate) {
+    journal.close();
+    journal.clear();
+    journal.open(journalPath(), ios::binary | (truncate ? ios::trunc : ios::app));
+    journalRecords = 0;
+    usedSinceJournal.clear();    // Soit dans l'index qui vient d'être écrit, soit perdus avec la session précédente
+}
+
+// Ajoute un chemin au journal. Appelée avec `lock` déjà pris.
+void ThumbnailCache::journalSource(const string& imagePath, const Source& source) {
+    if (!journal.is_open()) {
+        return;
+    }
+    writeValue(journal, JOURNAL_SOURCE);
+    writePath(journal, imagePath);
+    writeValue(journal, source.size);
+    writeValue(journal, source.modified);
+    writeValue(journal, source.hash);
+    journal.flush();
+    journalRecords++;
+    compactJournal();
+}
+
+// Note l'utilisation d'une entrée ; elle n'est écrite qu'avec le lot suivant. Appelée avec `lock` déjà pris.
+void ThumbnailCache::markUsed(uint64_t hash) {
+    usedSinceJournal.insert(hash);
+    if (usedSinceJournal.size() >= JOURNAL_USE_BATCH) {
+        journalUses();
+    }
+}
+
+// Écrit d'un bloc les utilisations en attente. Appelée avec `lock` déjà pris.
+void ThumbnailCache::journalUses() {
+    if (usedSinceJournal.empty() || !journal.is_open()) {
+        return;
+    }
+    for (uint64_t hash : usedSinceJournal) {
+        auto entry = entries.find(hash);
+        if (entry != entries.end()) {
+            writeValue(journal, JOURNAL_USE);
+            writeValue(journal, hash);
+            writeValue(journal, entry->second.lastUse);
+            journalRecords++;
+        }
+    }
+    usedSinceJournal.clear();
+    journal.flush();
+    compactJournal();
+}
+
+// Réécrit l'index (ce qui vide le journal) quand le journal est devenu trop long. Appelée avec `lock` déjà pris.
+void ThumbnailCache::compactJournal() {
+    if (journalRecords >= JOURNAL_MAX_RECORDS) {
+        dirty = true;
+        saveIndex();
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef THUMBNAILCACHE_HPP
+#define THUMBNAILCACHE_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace cv;
+using namespace std;
+
+// Côtés des niveaux de la pyramide gardée pour chaque image, du plus petit au plus grand.
+const int THUMBNAIL_LEVELS[] = {64, 128, 256};
+// Taille maximale du cache sur disque, au-delà de laquelle les vignettes les moins utilisées sont supprimées.
+const size_t THUMBNAIL_CACHE_DEFAULT_BYTES = 256 * 1024 * 1024;
+// Extension des fichiers de vignettes (un fichier par contenu d'image, nommé par son empreinte).
+const string THUMBNAIL_EXTENSION = ".thumb";
+
+/**
+ * @brief Cache sur disque de vignettes multi-résolutions, adressé par le contenu des images.
+ *
+ * Chaque image est représentée par un fichier `<empreinte>.thumb` qui contient ses vignettes de 64, 128 et
+ * 256 pixels, encodées en JPEG. Deux copies d'une même image partagent donc la même entrée. Un index associe
+ * chaque chemin à sa taille, sa date de modification et son empreinte : tant que le fichier n'a pas changé,
+ * ni l'image ni son contenu ne sont relus. Chaque nouvelle empreinte est aussi ajoutée à un journal, et l'ordre
+ * d'utilisation par lots : un arrêt brutal ne fait perdre aucune empreinte et au plus un lot d'utilisations. La taille du cache est bornée ; les entrées les moins récemment
+ * utilisées sont supprimées en premier.
+ *
+ * Les méthodes peuvent être appelées depuis plusieurs threads.
+ */
+class ThumbnailCache {
+public:
+    static ThumbnailCache& instance();
+
+    ~ThumbnailCache();
+
+    void open(const string& directory, size_t maxBytes = THUMBNAIL_CACHE_DEFAULT_BYTES);
+    bool isOpen() const;
+    void setMaxBytes(size_t maxBytes);
+    size_t usedBytes() const;
+
+    Mat thumbnail(const string& imagePath, int side);
+    void flush();
+    void clear();
+
+private:
+    ThumbnailCache();
+    ThumbnailCache(const ThumbnailCache&) = delete;
+    ThumbnailCache& operator=(const ThumbnailCache&) = delete;
+
+    // Dernier état connu d'une image : l'empreinte reste valide tant que la taille et la date n'ont pas changé.
+    struct Source {
+        uint64_t size;
+        int64_t modified;
+        uint64_t hash;
+    };
+
+    // Fichier de vignettes présent dans le répertoire du cache.
+    struct Entry {
+        uint64_t bytes;
+        uint64_t lastUse;
+    };
+
+    string entryPath(uint64_t hash) const;
+    string indexPath() const;
+    string journalPath() const;
+    bool contentHash(const string& imagePath, uint64_t& hash);
+    bool readLevel(uint64_t hash, int side, Mat& level) const;
+    bool writeEntry(uint64_t hash, const Mat& image, uint64_t& bytes) const;
+    void evict();
+    bool loadIndex();
+    void saveIndex();
+    void openJournal(bool truncate);
+    void journalSource(const string& imagePath, const Source& source);
+    void markUsed(uint64_t hash);
+    void journalUses();
+    void compactJournal();
+
+    mutable mutex lock;
+    string directory;
+    size_t maxBytes;
+    size_t totalBytes;
+    uint64_t useCounter;
+    bool dirty;
+    unordered_map<string, Source> sources;
+    unordered_map<uint64_t, Entry> entries;
+    ofstream journal;
+    size_t journalRecords;                  // enregistrements ajoutés depuis la dernière écriture de l'index
+    unordered_set<uint64_t> usedSinceJournal;  // entrées utilisées dont l'utilisation n'est pas encore journalisée
+};
+
+#endif // THUMBNAILCACHE_HPP
@@ -0,0 +1,113 @@
+#include "thumbnailloader.hpp"
+#include "thumbnailcache.hpp"
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <functional>
+
+namespace {
+
+// QRunnable::create is only available from Qt 5.15
+class Task : public QRunnable {
+public:
+    explicit Task(std::function<void()> body) : body(std::move(body)) {}
+    void run() override { body(); }
+
+private:
+    std::function<void()> body;
+};
+
+// Deep copy, the Mat buffer does not outlive the worker
+QImage toQImage(const cv::Mat &mat) {
+    if (mat.empty()) {
+        return QImage();
+    }
+    cv::Mat rgb;
+    cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
+    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+}
+
+} // namespace
+
+ThumbnailLoader::ThumbnailLoader(QObject *parent)
+    : QObject(parent), generation(0), nextTicket(0)
+{
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    cancelAll();
+    pool.waitForDone();
+}
+
+// Queue a thumbnail of at most side x side pixels; the returned ticket identifies it in thumbnailReady.
+int ThumbnailLoader::request(const QString &path, int side)
+{
+    const quint64 current = generation.load();
+    int ticket;
+    {
+        QMutexLocker locker(&mutex);
+        ticket = nextTicket++;
+        pending.append({ticket, path, side});
+    }
+    // Each task serves whichever request is at the front when a thread becomes free
+    pool.start(new Task([this, current]() { runNext(current); }));
+    return ticket;
+}
+
+// Move the given requests (if still pending) to the front of the queue, keeping their order.
+void ThumbnailLoader::prioritize(const QList<int> &tickets)
+{
+    QMutexLocker locker(&mutex);
+    QList<Request> first;
+    for (int ticket : tickets) {
+        for (int i = 0; i < pending.size(); i++) {
+            if (pending[i].ticket == ticket) {
+                first.append(pending.takeAt(i));
+                break;
+            }
+        }
+    }
+    pending = first + pending;
+}
+
+// Drop every pending request; thumbnails already being decoded are discarded when they finish.
+void ThumbnailLoader::cancelAll()
+{
+    {
+        QMutexLocker locker(&mutex);
+        pending.clear();
+        generation++;
+    }
+    pool.clear();
+}
+
+void ThumbnailLoader::runNext(quint64 requestGeneration)
+{
+    Request request;
+    {
+        QMutexLocker locker(&mutex);
+        if (requestGeneration != generation.load() || pending.isEmpty()) {
+            return;
+        }
+        request = pending.takeFirst();
+    }
+
+    const QImage image = toQImage(ThumbnailCache::instance().thumbnail(request.path.toStdString(), request.side));
+
+    bool idle;
+    {
+        QMutexLocker locker(&mutex);
+        if (requestGeneration != generation.load()) {
+            return;
+        }
+        idle = pending.isEmpty();
+    }
+    emit thumbnailReady(request.ticket, image);
+
+    // Save the cache index once the grid is complete
+    if (idle) {
+        ThumbnailCache::instance().flush();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef THUMBNAILLOADER_HPP
+#define THUMBNAILLOADER_HPP
+
+#include <QObject>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+
+// Decodes grid thumbnails on a background thread pool and delivers them to the GUI thread.
+// Pending requests are served front first; prioritize() moves the visible cells to the front
+// and cancelAll() drops everything that belongs to the previous grid.
+class ThumbnailLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ThumbnailLoader(QObject *parent = nullptr);
+    ~ThumbnailLoader();
+
+    int request(const QString &path, int side);
+    void prioritize(const QList<int> &tickets);
+    void cancelAll();
+
+signals:
+    // Emitted from a worker thread, so connections to widgets are queued. A null image means the file could not be read.
+    void thumbnailReady(int ticket, const QImage &image);
+
+private:
+    struct Request {
+        int ticket;
+        QString path;
+        int side;
+    };
+
+    void runNext(quint64 generation);
+
+    QThreadPool pool;
+    QMutex mutex;
+    QList<Request> pending;
+    std::atomic<quint64> generation;
+    int nextTicket;
+};
+
+#endif // THUMBNAILLOADER_HPP
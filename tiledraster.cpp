@@ -0,0 +1,354 @@
+#include "tiledraster.hpp"
+#include <gdal_priv.h>
+#include <cpl_conv.h>
+#include <cpl_error.h>
+#include <cpl_string.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+once_flag gdalRegistered;
+
+// Enregistre les pilotes GDAL une seule fois et borne son cache de blocs, sauf si GDAL_CACHEMAX est fixé.
+void ensureGdalRegistered() {
+    call_once(gdalRegistered, [] {
+        GDALAllRegister();
+        if (CPLGetConfigOption("GDAL_CACHEMAX", nullptr) == nullptr) {
+            GDALSetCacheMax64(static_cast<GIntBig>(RASTER_DEFAULT_CACHE_BYTES));
+        }
+    });
+}
+
+GDALDataType gdalType(int depth) {
+    switch (depth) {
+    case CV_8U: return GDT_Byte;
+    case CV_16U: return GDT_UInt16;
+    case CV_16S: return GDT_Int16;
+    case CV_32S: return GDT_Int32;
+    case CV_32F: return GDT_Float32;
+    case CV_64F: return GDT_Float64;
+    default: throw runtime_error("Profondeur d'image non supportée par GDAL.");
+    }
+}
+
+int matDepth(GDALDataType type) {
+    switch (type) {
+    case GDT_Byte: return CV_8U;
+    case GDT_UInt16: return CV_16U;
+    case GDT_Int16: return CV_16S;
+    case GDT_Int32: return CV_32S;
+    case GDT_Float32: return CV_32F;
+    case GDT_Float64: return CV_64F;
+    default: throw runtime_error("Type de pixel GDAL non supporté.");
+    }
+}
+
+// Bandes GDAL (numérotées à partir de 1) dans l'ordre des canaux OpenCV : RGB(A) -> BGR(A).
+vector<int> bandMap(int channels) {
+    switch (channels) {
+    case 3: return {3, 2, 1};
+    case 4: return {3, 2, 1, 4};
+    default: return {1};
+    }
+}
+
+// Lit ou écrit `region` du raster dans `pixels`, entrelacés comme dans une Mat (ROI acceptée).
+CPLErr transfer(GDALDataset* dataset, GDALRWFlag direction, const Rect& region, Mat& pixels,
+                GDALRasterIOExtraArg* extra = nullptr) {
+    vector<int> bands = bandMap(pixels.channels());
+    return dataset->RasterIO(direction, region.x, region.y, region.width, region.height, pixels.data,
+                             pixels.cols, pixels.rows, gdalType(pixels.depth()), static_cast<int>(bands.size()),
+                             bands.data(), static_cast<GSpacing>(pixels.elemSize()),
+                             static_cast<GSpacing>(pixels.step[0]), static_cast<GSpacing>(pixels.elemSize1()),
+                             extra);
+}
+
+} // namespace
+
+/**
+ * @brief Taille du cache de blocs partagé par tous les rasters GDAL ouverts.
+ *
+ * Le traitement par tuiles relit les halos des tuiles voisines : un cache qui contient une rangée de tuiles
+ * évite de les relire sur le disque. La mémoire consommée reste bornée par cette taille.
+ */
+void setRasterCacheSize(size_t bytes) {
+    ensureGdalRegistered();
+    GDALSetCacheMax64(static_cast<GIntBig>(bytes));
+}
+
+size_t rasterCacheSize() {
+    ensureGdalRegistered();
+    return static_cast<size_t>(GDALGetCacheMax64());
+}
+
+/**
+ * @brief Dimensions d'une image lues dans son en-tête par GDAL, sans décoder les pixels.
+ *
+ * @return false (sans message) si GDAL ne sait pas ouvrir le fichier.
+ */
+bool rasterDimensions(const string& path, int& width, int& height, int& channels) {
+    ensureGdalRegistered();
+    CPLPushErrorHandler(CPLQuietErrorHandler);
+    GDALDataset* dataset = static_cast<GDALDataset*>(GDALOpen(path.c_str(), GA_ReadOnly));
+    CPLPopErrorHandler();
+    if (!dataset) {
+        return false;
+    }
+    const bool valid = dataset->GetRasterCount() > 0;
+    if (valid) {
+        width = dataset->GetRasterXSize();
+        height = dataset->GetRasterYSize();
+        channels = dataset->GetRasterCount() >= 3 ? (dataset->GetRasterCount() == 4 ? 4 : 3) : 1;
+    }
+    GDALClose(dataset);
+    return valid;
+}
+
+/**
+ * @brief Ouvre un raster en lecture. Seul l'en-tête est lu.
+ *
+ * Un raster à 2 bandes (gris + alpha) est lu en gris ; au-delà de 4 bandes, les trois premières sont
+ * lues comme RGB.
+ *
+ * @throws std::runtime_error Si le fichier ne peut pas être ouvert ou si son type de pixel n'est pas supporté.
+ */
+TiledRaster::TiledRaster(const string& path) {
+    ensureGdalRegistered();
+    dataset = static_cast<GDALDataset*>(GDALOpen(path.c_str(), GA_ReadOnly));
+    if (!dataset || dataset->GetRasterCount() == 0) {
+        if (dataset) {
+            GDALClose(dataset);
+        }
+        throw runtime_error("Impossible d'ouvrir le raster : " + path);
+    }
+    bandCount = dataset->GetRasterCount();
+    const int channels = bandCount >= 3 ? (bandCount == 4 ? 4 : 3) : 1;
+    try {
+        matType = CV_MAKETYPE(matDepth(dataset->GetRasterBand(1)->GetRasterDataType()), channels);
+    } catch (...) {
+        GDALClose(dataset);
+        throw;
+    }
+}
+
+TiledRaster::~TiledRaster() {
+    GDALClose(dataset);
+}
+
+int TiledRaster::width() const {
+    return dataset->GetRasterXSize();
+}
+
+int TiledRaster::height() const {
+    return dataset->GetRasterYSize();
+}
+
+int TiledRaster::channels() const {
+    return CV_MAT_CN(matType);
+}
+
+int TiledRaster::type() const {
+    return matType;
+}
+
+/**
+ * @brief Lit une région du raster à pleine résolution. Seuls les blocs qui la recouvrent sont décodés.
+ *
+ * @throws std::invalid_argument Si la région sort de l'image.
+ * @throws std::runtime_error Si la lecture échoue.
+ */
+Mat TiledRaster::read(const Rect& region) const {
+    if (region.width <= 0 || region.height <= 0 || (region & Rect(0, 0, width(), height())) != region) {
+        throw invalid_argument("La région demandée sort du raster.");
+    }
+    Mat pixels(region.height, region.width, matType);
+    if (transfer(dataset, GF_Read, region, pixels) != CE_None) {
+        throw runtime_error("Erreur de lecture du raster.");
+    }
+    return pixels;
+}
+
+/**
+ * @brief Lit l'image entière réduite pour que son plus grand côté fasse au plus `maxSide` pixels.
+ *
+ * GDAL utilise les aperçus (overviews) du fichier s'il en a ; sinon il moyenne les pixels à la volée,
+ * bloc par bloc, sans charger l'image en mémoire.
+ *
+ * @throws std::runtime_error Si la lecture échoue.
+ */
+Mat TiledRaster::readOverview(int maxSide) const {
+    const double scale = min(1.0, static_cast<double>(maxSide) / max(width(), height()));
+    const int overviewWidth = max(1, cvRound(width() * scale));
+    const int overviewHeight = max(1, cvRound(height() * scale));
+
+    GDALRasterIOExtraArg extra;
+    INIT_RASTERIO_EXTRA_ARG(extra);
+    extra.eResampleAlg = GRIORA_Average;
+
+    Mat pixels(overviewHeight, overviewWidth, matType);
+    if (transfer(dataset, GF_Read, Rect(0, 0, width(), height()), pixels, &extra) != CE_None) {
+        throw runtime_error("Erreur de lecture du raster.");
+    }
+    return pixels;
+}
+
+/**
+ * @brief Crée un GeoTIFF tuilé (blocs de RASTER_BLOCK_SIZE, compression LZW, BigTIFF au besoin).
+ *
+ * @param type Type OpenCV des pixels qui seront écrits (1, 3 ou 4 canaux).
+ * @param georeference Raster dont la transformation géographique et la projection sont reprises, s'il y en a.
+ * @throws std::runtime_error Si le fichier ne peut pas être créé.
+ */
+TiledRasterWriter::TiledRasterWriter(const string& path, int width, int height, int type,
+                                     const TiledRaster* georeference)
+    : dataset(nullptr), matType(type) {
+    ensureGdalRegistered();
+    const int channels = CV_MAT_CN(type);
+    if (channels != 1 && channels != 3 && channels != 4) {
+        throw runtime_error("Nombre de canaux non supporté pour l'écriture du raster.");
+    }
+    GDALDriver* driver = GetGDALDriverManager()->GetDriverByName("GTiff");
+    if (!driver) {
+        throw runtime_error("Le pilote GeoTIFF de GDAL n'est pas disponible.");
+    }
+
+    const string blockSize = to_string(RASTER_BLOCK_SIZE);
+    char** options = nullptr;
+    options = CSLSetNameValue(options, "TILED", "YES");
+    options = CSLSetNameValue(options, "BLOCKXSIZE", blockSize.c_str());
+    options = CSLSetNameValue(options, "BLOCKYSIZE", blockSize.c_str());
+    options = CSLSetNameValue(options, "COMPRESS", "LZW");
+    options = CSLSetNameValue(options, "BIGTIFF", "IF_SAFER");
+    if (channels >= 3) {
+        options = CSLSetNameValue(options, "PHOTOMETRIC", "RGB");
+    }
+    if (channels == 4) {
+        options = CSLSetNameValue(options, "ALPHA", "YES");
+    }
+    dataset = driver->Create(path.c_str(), width, height, channels, gdalType(CV_MAT_DEPTH(type)), options);
+    CSLDestroy(options);
+    if (!dataset) {
+        throw runtime_error("Impossible de créer le raster : " + path);
+    }
+
+    if (georeference) {
+        double transform[6];
+        if (georeference->dataset->GetGeoTransform(transform) == CE_None) {
+            dataset->SetGeoTransform(transform);
+        }
+        const char* projection = georeference->dataset->GetProjectionRef();
+        if (projection && *projection) {
+            dataset->SetProjection(projection);
+        }
+    }
+}
+
+TiledRasterWriter::~TiledRasterWriter() {
+    close();
+}
+
+/**
+ * @brief Écrit des pixels (du type donné à la création) dans une région du raster.
+ *
+ * @throws std::invalid_argument Si le type ou la taille ne correspondent pas.
+ * @throws std::runtime_error Si le raster est fermé ou si l'écriture échoue.
+ */
+void TiledRasterWriter::write(const Rect& region, const Mat& pixels) {
+    if (!dataset) {
+        throw runtime_error("Le raster de sortie est fermé.");
+    }
+    if (pixels.type() != matType || pixels.size() != region.size()) {
+        throw invalid_argument("Les pixels ne correspondent pas à la région ou au type du raster.");
+    }
+    Mat view = pixels;
+    if (transfer(dataset, GF_Write, region, view) != CE_None) {
+        throw runtime_error("Erreur d'écriture du raster.");
+    }
+}
+
+// Vide les blocs encore en cache dans le fichier et le ferme.
+void TiledRasterWriter::close() {
+    if (dataset) {
+        GDALClose(dataset);
+        dataset = nullptr;
+    }
+}
+
+/**
+ * @brief Applique un filtre à une image de taille quelconque, tuile par tuile, du fichier d'entrée au GeoTIFF
+ *        de sortie.
+ *
+ * Chaque tuile est lue avec `halo` pixels de voisinage de chaque côté (bornés à l'image), filtrée, puis
+ * seul son centre est écrit : le résultat est identique au filtre appliqué sur l'image entière, pourvu que
+ * `halo` couvre le rayon du filtre. La mémoire utilisée est celle de quelques tuiles plus le cache de blocs
+ * de GDAL ; les tuiles sont parcourues ligne par ligne pour écrire les blocs de sortie dans l'ordre. Le
+ * filtre lui-même peut être parallèle (les filtres d'ImageProccessing le sont).
+ *
+ * Le GeoTIFF est écrit dans un fichier temporaire renommé à la fin : en cas d'erreur, `outputPath` n'est
+ * jamais laissé à moitié écrit (un fichier existant est conservé tel quel).
+ *
+ * @param filter Filtre qui conserve la taille de l'image ; le type de sa sortie fixe celui du fichier écrit.
+ * @param tileSize Côté des tuiles ; un multiple de RASTER_BLOCK_SIZE aligne les écritures sur les blocs.
+ * @param progress Si non nul, appelé après chaque tuile avec (tuiles faites, nombre de tuiles).
+ *
+ * @throws std::invalid_argument Si `halo` ou `tileSize` sont invalides.
+ * @throws std::runtime_error Si la lecture, l'écriture ou le filtre échouent.
+ */
+void processTiledRaster(const string& inputPath, const string& outputPath, int halo,
+                        const function<Mat(const Mat&)>& filter, int tileSize,
+                        const function<void(int, int)>& progress) {
+    if (halo < 0 || tileSize <= 0) {
+        throw invalid_argument("Paramètres de tuilage invalides.");
+    }
+    TiledRaster source(inputPath);
+    const Rect bounds(0, 0, source.width(), source.height());
+    const int tilesX = (source.width() + tileSize - 1) / tileSize;
+    const int tilesY = (source.height() + tileSize - 1) / tileSize;
+
+    const string temporary = outputPath + ".tmp";
+    unique_ptr<TiledRasterWriter> writer;
+    int done = 0;
+    try {
+        for (int y = 0; y < source.height(); y += tileSize) {
+            for (int x = 0; x < source.width(); x += tileSize) {
+                const Rect core(x, y, min(tileSize, source.width() - x), min(tileSize, source.height() - y));
+                const Rect expanded = Rect(core.x - halo, core.y - halo, core.width + 2 * halo, core.height + 2 * halo) & bounds;
+
+                Mat result = filter(source.read(expanded));
+                if (result.size() != expanded.size()) {
+                    throw runtime_error("Le filtre doit conserver la taille de l'image.");
+                }
+                if (!writer) {
+                    writer = make_unique<TiledRasterWriter>(temporary, source.width(), source.height(), result.type(), &source);
+                }
+                writer->write(core, result(Rect(core.x - expanded.x, core.y - expanded.y, core.width, core.height)));
+
+                if (progress) {
+                    progress(++done, tilesX * tilesY);
+                }
+            }
+        }
+        if (!writer) {
+            throw runtime_error("Le raster source est vide.");
+        }
+        writer->close();
+    } catch (...) {
+        writer.reset();
+        error_code error;
+        filesystem::remove(temporary, error);
+        throw;
+    }
+
+    error_code error;
+    filesystem::rename(temporary, outputPath, error);
+    if (error) {
+        filesystem::remove(temporary, error);
+        throw runtime_error("Impossible d'écrire le raster : " + outputPath);
+    }
+}
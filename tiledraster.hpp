@@ -0,0 +1,75 @@
+#ifndef TILEDRASTER_HPP
+#define TILEDRASTER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+class GDALDataset;
+
+// Côté des tuiles traitées par processTiledRaster : quelques Mo par tuile, quelle que soit la taille de l'image.
+const int RASTER_TILE_SIZE = 1024;
+// Côté des blocs du GeoTIFF écrit (tuilé, pour être relu efficacement par région).
+const int RASTER_BLOCK_SIZE = 256;
+// Cache de blocs de GDAL par défaut : il absorbe la relecture des halos entre tuiles voisines.
+const size_t RASTER_DEFAULT_CACHE_BYTES = 64 * 1024 * 1024;
+
+void setRasterCacheSize(size_t bytes);
+size_t rasterCacheSize();
+bool rasterDimensions(const string& path, int& width, int& height, int& channels);
+
+/**
+ * @brief Image lue par régions à travers GDAL, sans jamais la charger entièrement.
+ *
+ * Les pixels sont rendus dans l'ordre d'OpenCV : 1 canal, ou BGR / BGRA pour les rasters à 3 ou 4 bandes.
+ */
+class TiledRaster {
+public:
+    explicit TiledRaster(const string& path);
+    ~TiledRaster();
+    TiledRaster(const TiledRaster&) = delete;
+    TiledRaster& operator=(const TiledRaster&) = delete;
+
+    int width() const;
+    int height() const;
+    int channels() const;
+    int type() const;
+
+    Mat read(const Rect& region) const;
+    Mat readOverview(int maxSide) const;
+
+private:
+    friend class TiledRasterWriter;
+
+    GDALDataset* dataset;
+    int bandCount;
+    int matType;
+};
+
+/**
+ * @brief GeoTIFF tuilé écrit région par région (le géoréférencement peut être repris d'une source).
+ */
+class TiledRasterWriter {
+public:
+    TiledRasterWriter(const string& path, int width, int height, int type, const TiledRaster* georeference = nullptr);
+    ~TiledRasterWriter();
+    TiledRasterWriter(const TiledRasterWriter&) = delete;
+    TiledRasterWriter& operator=(const TiledRasterWriter&) = delete;
+
+    void write(const Rect& region, const Mat& pixels);
+    void close();
+
+private:
+    GDALDataset* dataset;
+    int matType;
+};
+
+void processTiledRaster(const string& inputPath, const string& outputPath, int halo,
+                        const function<Mat(const Mat&)>& filter, int tileSize = RASTER_TILE_SIZE,
+                        const function<void(int, int)>& progress = nullptr);
+
+#endif // TILEDRASTER_HPP
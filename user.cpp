@@ -9,75 +9,137 @@
 #include <QDebug>
 #include <QPushButton>
 #include <QCoreApplication>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "libraryfile.hpp"
+#include "threadpool.hpp"
 
 User::User(bool access):access(access) {}
 
-ManageLibrary User::loadLibrary(const QString& path) const {
-    // Load the file that contains the information of the library and create the ManageLibrary object
-    // and display the library
-    QFile file(path);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qDebug() << "Error: Could not open file";
-        exit(1);
+ManageLibrary User::loadLibrary(const QString& path, const function<void(int, int)>& progress,
+                                bool* ok, QHash<int, QJsonObject>* refreshedMetadata) const {
+    // Load the file that contains the information of the library and create the ManageLibrary object.
+    // The entries are built in parallel; progress(done, total) may be called from any worker thread.
+    // Metadata probed again because it was missing or stale is returned by id in refreshedMetadata rather than
+    // written here, so the caller can save it on the thread that owns the library file (see saveImageMetadata).
+    if (ok) {
+        *ok = false;
     }
-    qDebug() << "In load library : " << path;
 
-    QByteArray data = file.readAll();
-    QJsonDocument doc(QJsonDocument::fromJson(data));
-    QJsonObject obj = doc.object();
-    QJsonArray array = obj["library"].toArray();
+    // Binary libraries are read in place from the mapped file; JSON ones are parsed first
+    LibraryFile binary;
+    vector<QJsonObject> entries;
+    int count;
+    if (binary.open(path)) {
+        count = binary.count();
+    } else {
+        bool readOk;
+        QJsonObject obj = readLibraryDocument(path, &readOk);
+        if (!readOk) {
+            qWarning() << "Could not open the library" << path;
+            return ManageLibrary(1, nullptr, path);
+        }
+        QJsonArray array = obj["library"].toArray();
+        count = array.size();
+        entries.reserve(count);
+        for (int i = 0; i < count; i++) {
+            entries.push_back(array[i].toObject());
+        }
+    }
 
-    if (array.isEmpty()) {
+    if (ok) {
+        *ok = true;
+    }
+    if (count == 0) {
         qDebug() << "The library is empty.";
-        file.close();
         ManageLibrary library(1, nullptr,path);
 
         return library; // Return an empty ManageLibrary object
     }
-    
 
-    Descriptor* head = nullptr;
-    Descriptor* current = nullptr;
+    // Each worker only touches its own slots, so the list keeps the order of the file
+    vector<Descriptor*> descriptors(count, nullptr);
+    vector<char> metadataChanged(count, 0);
+    atomic<int> done(0);
+    const int progressStep = max(1, count / 100);
 
-    for (int i = 0; i < array.size(); i++) {
-        QJsonObject obj = array[i].toObject();
-        qDebug() << "ID: " << obj["id"].toInt();
-        // qDebug() << "Library ID: " << obj["libraryID"].toInt();
-        qDebug() << "Cost: " << obj["cost"].toDouble();
-        qDebug() << "Title: " << obj["title"].toString();
-        qDebug() << "Source: " << obj["source"].toString();
-        qDebug() << "Access: " << obj["access"].toString();
-        qDebug() << "Imagepath: " << obj["Imagepath"].toString();
-        
-
-        Descriptor* newDescriptor = new Descriptor(
-            obj["id"].toInt(),
-            obj["cost"].toDouble(),
-            obj["title"].toString(),
-            obj["source"].toString(),
-            obj["access"].toString().toStdString().c_str()[0],
-            Image(obj["Imagepath"].toString())
-            ); 
-            if (head == nullptr) {
-            head = newDescriptor;
-            current = head;
+    ThreadPool::instance().parallelFor(count, [&](int i) {
+        QJsonObject storedMetadata;
+        Descriptor* newDescriptor;
+        if (binary.isOpen()) {
+            storedMetadata = binary.imageMetadata(i);
+            newDescriptor = new Descriptor(
+                static_cast<int>(binary.id(i)),
+                binary.cost(i),
+                binary.title(i),
+                binary.source(i),
+                binary.access(i),
+                Image(binary.imagePath(i), storedMetadata)
+                );
+            newDescriptor->setPerceptualHash(binary.perceptualHash(i));
         } else {
-            current->setNextDescriptor(newDescriptor);
-            current = newDescriptor;
+            const QJsonObject& entry = entries[i];
+            storedMetadata = entry["imageMetadata"].toObject();
+            newDescriptor = new Descriptor(
+                entry["id"].toInt(),
+                entry["cost"].toDouble(),
+                entry["title"].toString(),
+                entry["source"].toString(),
+                entry["access"].toString().toStdString().c_str()[0],
+                Image(entry["Imagepath"].toString(), storedMetadata)
+                );
+            newDescriptor->setPerceptualHash(entry["dhash"].toString());
         }
-    }
+        descriptors[i] = newDescriptor;
 
-    file.close();
+        // Missing or stale metadata (the image changed since it was saved) was probed again: keep it for next time
+        metadataChanged[i] = newDescriptor->getImage().metadataToJson() != storedMetadata;
 
-    ManageLibrary library(1, head,path);
-    qDebug() << "Displaying Library second time";
-    library.display();
-    return library;
+        const int finished = ++done;
+        if (progress && (finished % progressStep == 0 || finished == count)) {
+            progress(finished, count);
+        }
+    });
+
+    for (int i = 0; i < count; i++) {
+        if (i + 1 < count) {
+            descriptors[i]->setNextDescriptor(descriptors[i + 1]);
+        }
+        if (metadataChanged[i] && refreshedMetadata) {
+            refreshedMetadata->insert(static_cast<int>(descriptors[i]->getIdDescriptor()),
+                                      descriptors[i]->getImage().metadataToJson());
+        }
+    }
+
+    qDebug() << "Loaded" << count << "descriptors from" << path;
+    return ManageLibrary(1, descriptors[0], path);
 }
 
 
 
 
+// Write the metadata returned by loadLibrary into the entries with the same id, keeping any other change made
+// to the file since it was loaded.
+bool User::saveImageMetadata(const QString& path, const QHash<int, QJsonObject>& metadata) const {
+    bool ok;
+    QJsonObject document = readLibraryDocument(path, &ok);
+    if (!ok) {
+        return false;
+    }
+    QJsonArray array = document["library"].toArray();
+    for (int i = 0; i < array.size(); i++) {
+        QJsonObject entry = array[i].toObject();
+        auto refreshed = metadata.constFind(entry["id"].toInt());
+        if (refreshed != metadata.constEnd()) {
+            entry["imageMetadata"] = *refreshed;
+            array[i] = entry;
+        }
+    }
+    document["library"] = array;
+    return writeLibraryDocument(path, document);
+}
+
 QJsonArray User::loadLibraries(const QString& librariesFilePath) {
     qDebug() << "in loadLibraries function";
     // Load the file that contains the libraries path
@@ -3,6 +3,9 @@
 #include <QString>
 #include "librarymanagement.hpp"
 #include <QJsonArray>
+#include <QJsonObject>
+#include <QHash>
+#include <functional>
 
 class User
 {
@@ -14,7 +17,9 @@ public:
     QString libraryPath;
     User() : access("") {};
     User(bool access);
-    ManageLibrary loadLibrary(const QString& path) const  ;
+    ManageLibrary loadLibrary(const QString& path, const function<void(int, int)>& progress = nullptr,
+                              bool* ok = nullptr, QHash<int, QJsonObject>* refreshedMetadata = nullptr) const  ;
+    bool saveImageMetadata(const QString& path, const QHash<int, QJsonObject>& metadata) const;
     QJsonArray loadLibraries(const QString& librariesFilePath);
     // create a new library method
     void createLibrary(QString libraryName);
@@ -0,0 +1,634 @@
+#include "visualindex.hpp"
+#include "threadpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace cv;
+using namespace std;
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'L', 'I', 'B', 'V', 'I', 'D', 'X', '\0'};
+const uint32_t INDEX_VERSION = 1;
+const uint32_t MAX_DESCRIPTOR_COLS = 1024;
+
+// Graine fixe des k-moyennes : la même bibliothèque donne toujours le même vocabulaire.
+const uint64 VOCABULARY_SEED = 0x5eed5eedULL;
+
+// L'idf a assez bougé pour justifier de recalculer toutes les normes quand le nombre d'images varie de 10 %.
+// Au même seuil d'emplacements morts (images retirées ou remplacées), l'index est compacté.
+const double NORM_REFRESH_RATIO = 1.1;
+
+struct IndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t descriptorCols;
+    uint32_t wordCount;
+    uint64_t entryCount;
+};
+static_assert(sizeof(IndexHeader) == 32, "En-tête de l'index mal aligné");
+
+float squaredDistance(const float* a, const float* b, int n) {
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float d0 = a[i] - b[i], d1 = a[i + 1] - b[i + 1];
+        const float d2 = a[i + 2] - b[i + 2], d3 = a[i + 3] - b[i + 3];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+    for (; i < n; i++) {
+        const float d = a[i] - b[i];
+        s0 += d * d;
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+// Au plus `count` lignes réparties régulièrement dans la matrice.
+Mat sampleRows(const Mat& descriptors, int count) {
+    if (descriptors.rows <= count) {
+        return descriptors;
+    }
+    Mat sampled(count, descriptors.cols, descriptors.type());
+    for (int i = 0; i < count; i++) {
+        descriptors.row(static_cast<int>(static_cast<int64_t>(i) * descriptors.rows / count)).copyTo(sampled.row(i));
+    }
+    return sampled;
+}
+
+template <typename T>
+bool readValue(ifstream& file, T& value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+void writeValue(ofstream& file, const T& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+/**
+ * @brief Apprend l'arbre de vocabulaire par k-moyennes hiérarchiques sur des descripteurs échantillons.
+ *
+ * Chaque nœud partage ses descripteurs en `branching` groupes, jusqu'à `depth` niveaux ; les feuilles sont
+ * les mots visuels. Un nœud qui a trop peu de descripteurs pour être partagé devient une feuille plus tôt.
+ * Les images déjà indexées sont retirées : leurs mots ne correspondent plus au nouveau vocabulaire.
+ *
+ * @param samples Un descripteur par ligne (converti en CV_32F).
+ * @throws std::invalid_argument Si `samples` est vide ou si les paramètres sont invalides.
+ */
+void VisualIndex::trainVocabulary(const Mat& samples, int branching, int depth) {
+    if (samples.empty()) {
+        throw invalid_argument("Aucun descripteur pour apprendre le vocabulaire.");
+    }
+    if (branching < 2 || depth < 1 || samples.cols > static_cast<int>(MAX_DESCRIPTOR_COLS)) {
+        throw invalid_argument("Paramètres du vocabulaire invalides.");
+    }
+    Mat data;
+    samples.convertTo(data, CV_32F);
+
+    firstChild.assign(1, -1);
+    childCount.assign(1, 0);
+    leafWord.assign(1, -1);
+    words = 0;
+    vector<Mat> centerRows(1, Mat::zeros(1, data.cols, CV_32F));
+
+    struct Pending {
+        int node;
+        vector<int> rows;
+        int level;
+    };
+    deque<Pending> pending;
+    pending.push_back({0, vector<int>(data.rows), 0});
+    for (int i = 0; i < data.rows; i++) {
+        pending.front().rows[i] = i;
+    }
+
+    const uint64 savedState = theRNG().state;
+    theRNG().state = VOCABULARY_SEED;
+    while (!pending.empty()) {
+        Pending current = move(pending.front());
+        pending.pop_front();
+        if (current.level == depth || static_cast<int>(current.rows.size()) <= branching) {
+            leafWord[current.node] = words++;
+            continue;
+        }
+
+        Mat subset(static_cast<int>(current.rows.size()), data.cols, CV_32F);
+        for (int i = 0; i < subset.rows; i++) {
+            data.row(current.rows[i]).copyTo(subset.row(i));
+        }
+        Mat labels, clusterCenters;
+        kmeans(subset, branching, labels, TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 10, 1e-3),
+               1, KMEANS_PP_CENTERS, clusterCenters);
+
+        vector<vector<int>> groups(branching);
+        for (int i = 0; i < subset.rows; i++) {
+            groups[labels.at<int>(i)].push_back(current.rows[i]);
+        }
+        firstChild[current.node] = static_cast<int>(firstChild.size());
+        childCount[current.node] = branching;
+        for (int c = 0; c < branching; c++) {
+            const int child = static_cast<int>(firstChild.size());
+            firstChild.push_back(-1);
+            childCount.push_back(0);
+            leafWord.push_back(-1);
+            centerRows.push_back(clusterCenters.row(c));
+            pending.push_back({child, move(groups[c]), current.level + 1});
+        }
+    }
+    theRNG().state = savedState;
+    vconcat(centerRows, centers);
+
+    entries.clear();
+    slots.clear();
+    postings.assign(words, vector<Posting>());
+    liveCount = 0;
+    norms.clear();
+    normsLiveCount = 0;
+}
+
+bool VisualIndex::hasVocabulary() const {
+    return words > 0;
+}
+
+int VisualIndex::wordCount() const {
+    return words;
+}
+
+/**
+ * @brief Histogramme creux des mots visuels d'une image : (mot, fréquence) triés par mot, fréquences de somme 1.
+ *
+ * Chaque descripteur descend l'arbre en prenant à chaque niveau le centre le plus proche.
+ *
+ * @throws std::runtime_error Si aucun vocabulaire n'a été appris.
+ * @throws std::invalid_argument Si les descripteurs n'ont pas la dimension du vocabulaire.
+ */
+vector<pair<int, float>> VisualIndex::bagOfWords(const SiftFeatures& features) const {
+    if (!hasVocabulary()) {
+        throw runtime_error("Le vocabulaire visuel n'a pas été appris.");
+    }
+    if (features.descriptors.empty()) {
+        return {};
+    }
+    if (features.descriptors.cols != centers.cols) {
+        throw invalid_argument("Les descripteurs ne correspondent pas au vocabulaire.");
+    }
+    Mat descriptors = features.descriptors;
+    if (descriptors.type() != CV_32FC1) {
+        descriptors.convertTo(descriptors, CV_32F);
+    }
+
+    vector<int> found(descriptors.rows);
+    for (int y = 0; y < descriptors.rows; y++) {
+        const float* descriptor = descriptors.ptr<float>(y);
+        int node = 0;
+        while (leafWord[node] < 0) {
+            int best = firstChild[node];
+            float bestDistance = squaredDistance(descriptor, centers.ptr<float>(best), centers.cols);
+            for (int c = best + 1; c < firstChild[node] + childCount[node]; c++) {
+                const float distance = squaredDistance(descriptor, centers.ptr<float>(c), centers.cols);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = c;
+                }
+            }
+            node = best;
+        }
+        found[y] = leafWord[node];
+    }
+
+    sort(found.begin(), found.end());
+    vector<pair<int, float>> histogram;
+    const float unit = 1.0f / static_cast<float>(found.size());
+    for (int word : found) {
+        if (!histogram.empty() && histogram.back().first == word) {
+            histogram.back().second += unit;
+        } else {
+            histogram.emplace_back(word, unit);
+        }
+    }
+    return histogram;
+}
+
+/**
+ * @brief Ajoute (ou remplace) une image dans l'index.
+ *
+ * @throws std::runtime_error Si aucun vocabulaire n'a été appris.
+ */
+void VisualIndex::addImage(unsigned int id, const SiftFeatures& features) {
+    insertHistogram(id, bagOfWords(features));
+}
+
+/**
+ * @brief Ajoute (ou remplace) un lot d'images, en parallèle.
+ *
+ * Les caractéristiques SIFT viennent de `siftFeaturesFor` (fichier compagnon, ou calcul puis enregistrement).
+ * Sans vocabulaire, il est d'abord appris sur un échantillon régulier des descripteurs du lot ; les
+ * caractéristiques lues pour cela sont gardées (jusqu'à VOCABULARY_KEPT_FEATURE_BYTES) et servent ensuite
+ * à la quantification, si bien que chaque image n'est lue qu'une fois. Les images
+ * sont insérées dans l'ordre du lot, si bien que le résultat ne dépend pas du nombre de threads ; une image
+ * illisible est ignorée (elle sera de nouveau proposée à la prochaine mise à jour de l'index).
+ *
+ * @param images Paires (id, chemin complet de l'image).
+ * @param progress Appelée avec (étapes faites, total) depuis n'importe quel thread du pool ; une image compte
+ *                 pour une étape, deux quand le vocabulaire est appris.
+ */
+void VisualIndex::addImages(const vector<pair<unsigned int, string>>& images,
+                            const function<void(int, int)>& progress) {
+    const int count = static_cast<int>(images.size());
+    if (count == 0) {
+        return;
+    }
+    const int total = hasVocabulary() ? count : 2 * count;
+    const int progressStep = max(1, total / 100);
+    atomic<int> done(0);
+    auto step = [&]() {
+        const int finished = ++done;
+        if (progress && (finished % progressStep == 0 || finished == total)) {
+            progress(finished, total);
+        }
+    };
+
+    vector<SiftFeatures> kept(count);
+    vector<char> state(count, 0);    // 1 : caractéristiques gardées dans `kept` ; -1 : image illisible
+    if (!hasVocabulary()) {
+        const int perImage = max(1, VOCABULARY_TRAINING_DESCRIPTORS / count);
+        vector<Mat> sampled(count);
+        atomic<size_t> keptBytes(0);
+        ThreadPool::instance().parallelFor(count, [&](int i) {
+            SiftFeatures features;
+            try {
+                features = siftFeaturesFor(images[i].second);
+            } catch (const exception&) {
+                state[i] = -1;    // Image illisible : pas d'échantillons, et pas de nouvel essai plus bas
+                step();
+                return;
+            }
+            step();
+            sampled[i] = sampleRows(features.descriptors, perImage);
+            const size_t bytes = features.descriptors.total() * features.descriptors.elemSize()
+                                 + features.keypoints.size() * sizeof(KeyPoint);
+            if (keptBytes.fetch_add(bytes) + bytes <= VOCABULARY_KEPT_FEATURE_BYTES) {
+                kept[i] = move(features);
+                state[i] = 1;
+            } else {
+                keptBytes -= bytes;
+            }
+        });
+        vector<Mat> nonEmpty;
+        for (const Mat& rows : sampled) {
+            if (!rows.empty()) {
+                nonEmpty.push_back(rows);
+            }
+        }
+        if (nonEmpty.empty()) {
+            return;
+        }
+        Mat samples;
+        vconcat(nonEmpty, samples);
+        trainVocabulary(samples);
+    }
+
+    vector<vector<pair<int, float>>> histograms(count);
+    vector<char> valid(count, 0);
+    ThreadPool::instance().parallelFor(count, [&](int i) {
+        if (state[i] < 0) {
+            step();
+            return;
+        }
+        try {
+            histograms[i] = state[i] > 0 ? bagOfWords(kept[i]) : bagOfWords(siftFeaturesFor(images[i].second));
+            valid[i] = 1;
+        } catch (const exception&) {
+            // Image illisible : non indexée
+        }
+        kept[i] = SiftFeatures();
+        step();
+    });
+    for (int i = 0; i < count; i++) {
+        if (valid[i]) {
+            insertHistogram(images[i].first, move(histograms[i]));
+        }
+    }
+}
+
+void VisualIndex::removeImage(unsigned int id) {
+    auto it = slots.find(id);
+    if (it == slots.end()) {
+        return;
+    }
+    const uint32_t slot = it->second;
+    Entry& entry = entries[slot];
+    for (const pair<int, float>& word : entry.words) {
+        vector<Posting>& list = postings[word.first];
+        list.erase(find_if(list.begin(), list.end(), [slot](const Posting& p) { return p.slot == slot; }));
+    }
+    entry.live = false;
+    vector<pair<int, float>>().swap(entry.words);
+    slots.erase(it);
+    liveCount--;
+
+    // Les requêtes allouent et parcourent un score par emplacement, morts compris
+    if (entries.size() > liveCount * NORM_REFRESH_RATIO) {
+        compact();
+    }
+}
+
+// Retire les emplacements des images supprimées et renumérote les autres (entrées, normes, listes inversées).
+void VisualIndex::compact() {
+    vector<uint32_t> renumbered(entries.size(), 0);
+    vector<Entry> live;
+    vector<float> liveNorms;
+    live.reserve(liveCount);
+    liveNorms.reserve(liveCount);
+    for (size_t slot = 0; slot < entries.size(); slot++) {
+        if (!entries[slot].live) {
+            continue;
+        }
+        renumbered[slot] = static_cast<uint32_t>(live.size());
+        liveNorms.push_back(slot < norms.size() ? norms[slot] : 0.0f);
+        live.push_back(move(entries[slot]));
+    }
+    // removeImage a déjà retiré les emplacements morts des listes : l'ordre des autres est conservé
+    for (vector<Posting>& list : postings) {
+        for (Posting& posting : list) {
+            posting.slot = renumbered[posting.slot];
+        }
+    }
+    for (auto& slot : slots) {
+        slot.second = renumbered[slot.second];
+    }
+    entries = move(live);
+    norms = move(liveNorms);
+}
+
+bool VisualIndex::contains(unsigned int id) const {
+    return slots.count(id) != 0;
+}
+
+size_t VisualIndex::size() const {
+    return liveCount;
+}
+
+// Les ids des images indexées, dans l'ordre d'insertion.
+vector<unsigned int> VisualIndex::imageIds() const {
+    vector<unsigned int> ids;
+    ids.reserve(liveCount);
+    for (const Entry& entry : entries) {
+        if (entry.live) {
+            ids.push_back(entry.id);
+        }
+    }
+    return ids;
+}
+
+/**
+ * @brief Les images de l'index les plus semblables à des caractéristiques SIFT, par score décroissant.
+ */
+vector<SimilarImage> VisualIndex::query(const SiftFeatures& features, size_t maxResults) const {
+    return rank(bagOfWords(features), maxResults, -1);
+}
+
+/**
+ * @brief Les images les plus semblables à une image déjà indexée (elle-même exclue), par score décroissant.
+ *
+ * @return Une liste vide si `id` n'est pas dans l'index.
+ */
+vector<SimilarImage> VisualIndex::querySimilar(unsigned int id, size_t maxResults) const {
+    auto it = slots.find(id);
+    if (it == slots.end()) {
+        return {};
+    }
+    return rank(entries[it->second].words, maxResults, static_cast<int>(it->second));
+}
+
+void VisualIndex::insertHistogram(unsigned int id, vector<pair<int, float>> histogram) {
+    removeImage(id);
+    const uint32_t slot = static_cast<uint32_t>(entries.size());
+    for (const pair<int, float>& word : histogram) {
+        postings[word.first].push_back({slot, word.second});
+    }
+    entries.push_back({id, true, move(histogram)});
+    slots[id] = slot;
+    liveCount++;
+
+    double norm = 0;
+    for (const pair<int, float>& word : entries.back().words) {
+        const double weight = word.second * idf(word.first);
+        norm += weight * weight;
+    }
+    norms.resize(entries.size());
+    norms[slot] = static_cast<float>(sqrt(norm));
+}
+
+// log(N / df) ; nul pour un mot absent de l'index, qui ne peut rapprocher aucune image.
+float VisualIndex::idf(int word) const {
+    const size_t frequency = postings[word].size();
+    return frequency == 0 ? 0.0f : static_cast<float>(log(static_cast<double>(liveCount) / frequency));
+}
+
+void VisualIndex::refreshNorms() const {
+    if (normsLiveCount != 0 && liveCount <= normsLiveCount * NORM_REFRESH_RATIO
+        && liveCount * NORM_REFRESH_RATIO >= normsLiveCount) {
+        return;
+    }
+    norms.assign(entries.size(), 0.0f);
+    const int blocks = (static_cast<int>(entries.size()) + 1023) / 1024;
+    ThreadPool::instance().parallelFor(blocks, [&](int block) {
+        const size_t end = min(entries.size(), static_cast<size_t>(block + 1) * 1024);
+        for (size_t slot = static_cast<size_t>(block) * 1024; slot < end; slot++) {
+            double norm = 0;
+            for (const pair<int, float>& word : entries[slot].words) {
+                const double weight = word.second * idf(word.first);
+                norm += weight * weight;
+            }
+            norms[slot] = static_cast<float>(sqrt(norm));
+        }
+    });
+    normsLiveCount = liveCount;
+}
+
+/**
+ * @brief Similarité cosinus tf-idf entre un histogramme et toutes les images qui partagent au moins un mot.
+ *
+ * Seules les listes inversées des mots de la requête sont parcourues ; les ex æquo sont départagés par id.
+ */
+vector<SimilarImage> VisualIndex::rank(const vector<pair<int, float>>& histogram, size_t maxResults,
+                                       int excludedSlot) const {
+    refreshNorms();
+
+    vector<float> scores(entries.size(), 0.0f);
+    vector<uint32_t> touched;
+    double queryNorm = 0;
+    for (const pair<int, float>& word : histogram) {
+        const float weight = idf(word.first);
+        if (weight == 0.0f) {
+            continue;
+        }
+        queryNorm += static_cast<double>(word.second * weight) * (word.second * weight);
+        const float factor = word.second * weight * weight;
+        for (const Posting& posting : postings[word.first]) {
+            if (scores[posting.slot] == 0.0f) {
+                touched.push_back(posting.slot);
+            }
+            scores[posting.slot] += factor * posting.frequency;
+        }
+    }
+    if (queryNorm == 0) {
+        return {};
+    }
+    queryNorm = sqrt(queryNorm);
+
+    vector<SimilarImage> results;
+    results.reserve(touched.size());
+    for (uint32_t slot : touched) {
+        if (static_cast<int>(slot) == excludedSlot || norms[slot] == 0.0f) {
+            continue;
+        }
+        results.push_back({entries[slot].id, min(1.0, scores[slot] / (queryNorm * norms[slot]))});
+    }
+    const auto better = [](const SimilarImage& a, const SimilarImage& b) {
+        return a.score != b.score ? a.score > b.score : a.id < b.id;
+    };
+    const size_t kept = min(maxResults, results.size());
+    partial_sort(results.begin(), results.begin() + static_cast<ptrdiff_t>(kept), results.end(), better);
+    results.resize(kept);
+    return results;
+}
+
+/**
+ * @brief Enregistre le vocabulaire et les histogrammes des images (fichier temporaire puis renommage).
+ *
+ * Les listes inversées ne sont pas stockées : elles se reconstruisent à partir des histogrammes.
+ */
+bool VisualIndex::save(const string& path) const {
+    IndexHeader header;
+    memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.nodeCount = static_cast<uint32_t>(firstChild.size());
+    header.descriptorCols = static_cast<uint32_t>(centers.cols);
+    header.wordCount = static_cast<uint32_t>(words);
+    header.entryCount = liveCount;
+
+    const string temporary = path + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        writeValue(file, header);
+        for (size_t node = 0; node < firstChild.size(); node++) {
+            writeValue(file, static_cast<int32_t>(firstChild[node]));
+            writeValue(file, static_cast<int32_t>(childCount[node]));
+            writeValue(file, static_cast<int32_t>(leafWord[node]));
+            file.write(reinterpret_cast<const char*>(centers.ptr<float>(static_cast<int>(node))),
+                       static_cast<streamsize>(centers.cols * sizeof(float)));
+        }
+        for (const Entry& entry : entries) {
+            if (!entry.live) {
+                continue;
+            }
+            writeValue(file, static_cast<uint32_t>(entry.id));
+            writeValue(file, static_cast<uint32_t>(entry.words.size()));
+            for (const pair<int, float>& word : entry.words) {
+                writeValue(file, static_cast<int32_t>(word.first));
+                writeValue(file, word.second);
+            }
+        }
+        if (!file) {
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::rename(temporary, path, error);
+    if (error) {
+        filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Recharge un index enregistré par `save`. L'index courant n'est remplacé que si le fichier est valide.
+ *
+ * @return false si le fichier est absent, tronqué, d'une autre version ou incohérent.
+ */
+bool VisualIndex::load(const string& path) {
+    error_code error;
+    const uintmax_t fileSize = filesystem::file_size(path, error);
+    ifstream file(path, ios::binary);
+    IndexHeader header;
+    if (error || !file.is_open() || !readValue(file, header)
+        || memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION
+        || header.nodeCount == 0 || header.descriptorCols == 0 || header.descriptorCols > MAX_DESCRIPTOR_COLS
+        || header.wordCount == 0) {
+        return false;
+    }
+    // Tailles annoncées bornées par celle du fichier avant toute allocation
+    const uint64_t nodeBytes = 3 * sizeof(int32_t) + header.descriptorCols * sizeof(float);
+    if (header.nodeCount > (fileSize - sizeof(header)) / nodeBytes || header.wordCount > header.nodeCount) {
+        return false;
+    }
+    uint64_t remaining = fileSize - sizeof(header) - header.nodeCount * nodeBytes;
+
+    VisualIndex loaded;
+    const int nodeCount = static_cast<int>(header.nodeCount);
+    loaded.centers.create(nodeCount, static_cast<int>(header.descriptorCols), CV_32F);
+    loaded.firstChild.resize(nodeCount);
+    loaded.childCount.resize(nodeCount);
+    loaded.leafWord.resize(nodeCount);
+    loaded.words = static_cast<int>(header.wordCount);
+    for (int node = 0; node < nodeCount; node++) {
+        int32_t first, children, word;
+        if (!readValue(file, first) || !readValue(file, children) || !readValue(file, word)
+            || !file.read(reinterpret_cast<char*>(loaded.centers.ptr<float>(node)),
+                          static_cast<streamsize>(header.descriptorCols * sizeof(float)))) {
+            return false;
+        }
+        const bool leaf = word >= 0 && word < loaded.words && children == 0;
+        const bool inner = word == -1 && children > 0 && first > node && first + children <= nodeCount;
+        if (!leaf && !inner) {
+            return false;
+        }
+        loaded.firstChild[node] = first;
+        loaded.childCount[node] = children;
+        loaded.leafWord[node] = word;
+    }
+    loaded.postings.assign(loaded.words, vector<Posting>());
+
+    for (uint64_t i = 0; i < header.entryCount; i++) {
+        uint32_t id, wordCount;
+        if (remaining < 2 * sizeof(uint32_t) || !readValue(file, id) || !readValue(file, wordCount)) {
+            return false;
+        }
+        remaining -= 2 * sizeof(uint32_t);
+        if (wordCount > remaining / (sizeof(int32_t) + sizeof(float))) {
+            return false;
+        }
+        remaining -= wordCount * (sizeof(int32_t) + sizeof(float));
+        vector<pair<int, float>> histogram(wordCount);
+        for (pair<int, float>& word : histogram) {
+            int32_t value;
+            if (!readValue(file, value) || !readValue(file, word.second) || value < 0 || value >= loaded.words) {
+                return false;
+            }
+            word.first = value;
+        }
+        loaded.insertHistogram(id, move(histogram));
+    }
+
+    *this = move(loaded);
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef VISUALINDEX_HPP
+#define VISUALINDEX_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "siftcache.hpp"
+
+using namespace cv;
+using namespace std;
+
+// Arbre de vocabulaire par défaut : 10 branches sur 4 niveaux, soit jusqu'à 10 000 mots visuels.
+const int VOCABULARY_BRANCHING = 10;
+const int VOCABULARY_DEPTH = 4;
+// Nombre maximal de descripteurs échantillonnés dans la bibliothèque pour apprendre le vocabulaire.
+const int VOCABULARY_TRAINING_DESCRIPTORS = 100000;
+// Mémoire au plus gardée pour les caractéristiques lues pendant l'apprentissage du vocabulaire, afin de ne pas
+// les relire pour quantifier les images ; au-delà, elles sont relues depuis leur fichier compagnon.
+const size_t VOCABULARY_KEPT_FEATURE_BYTES = 512 * 1024 * 1024;
+// Extension du fichier d'index, ajoutée au chemin du JSON de la bibliothèque.
+const string VISUAL_INDEX_EXTENSION = ".index";
+
+struct SimilarImage {
+    unsigned int id;
+    double score;   // Similarité cosinus tf-idf, dans [0, 1]
+};
+
+/**
+ * @brief Index de similarité visuelle d'une bibliothèque : sac de mots visuels SIFT et fichier inversé.
+ *
+ * Les descripteurs SIFT sont quantifiés par un arbre de vocabulaire (k-moyennes hiérarchiques) ; chaque image
+ * devient un histogramme creux de mots, rangé dans les listes inversées de ses mots. Une requête ne parcourt que
+ * les listes des mots qu'elle contient, quelle que soit la taille de la bibliothèque.
+ *
+ * Les images sont identifiées par l'id de leur descripteur. La classe n'est pas synchronisée : l'index ne doit
+ * pas être modifié pendant une requête.
+ */
+class VisualIndex {
+public:
+    void trainVocabulary(const Mat& samples, int branching = VOCABULARY_BRANCHING, int depth = VOCABULARY_DEPTH);
+    bool hasVocabulary() const;
+    int wordCount() const;
+
+    vector<pair<int, float>> bagOfWords(const SiftFeatures& features) const;
+
+    void addImage(unsigned int id, const SiftFeatures& features);
+    void addImages(const vector<pair<unsigned int, string>>& images,
+                   const function<void(int, int)>& progress = nullptr);
+    void removeImage(unsigned int id);
+    bool contains(unsigned int id) const;
+    size_t size() const;
+    vector<unsigned int> imageIds() const;
+
+    vector<SimilarImage> query(const SiftFeatures& features, size_t maxResults) const;
+    vector<SimilarImage> querySimilar(unsigned int id, size_t maxResults) const;
+
+    bool save(const string& path) const;
+    bool load(const string& path);
+
+private:
+    struct Posting {
+        uint32_t slot;
+        float frequency;
+    };
+    struct Entry {
+        unsigned int id;
+        bool live;
+        vector<pair<int, float>> words;
+    };
+
+    void insertHistogram(unsigned int id, vector<pair<int, float>> words);
+    void compact();
+    void refreshNorms() const;
+    float idf(int word) const;
+    vector<SimilarImage> rank(const vector<pair<int, float>>& words, size_t maxResults, int excludedSlot) const;
+
+    // Arbre : nœud 0 = racine ; les enfants d'un nœud sont contigus, leurs centres sont les lignes de `centers`.
+    Mat centers;
+    vector<int> firstChild;
+    vector<int> childCount;
+    vector<int> leafWord;
+    int words = 0;
+
+    vector<Entry> entries;
+    unordered_map<unsigned int, uint32_t> slots;
+    vector<vector<Posting>> postings;
+    size_t liveCount = 0;
+
+    // Normes tf-idf des images, recalculées quand la bibliothèque a assez changé pour que l'idf ait bougé.
+    mutable vector<float> norms;
+    mutable size_t normsLiveCount = 0;
+};
+
+#endif // VISUALINDEX_HPP
@@ -0,0 +1,55 @@
+#include "visualindexbuilder.hpp"
+#include <QDebug>
+#include <QRunnable>
+#include <functional>
+
+namespace {
+
+// QRunnable::create is only available from Qt 5.15
+class Task : public QRunnable {
+public:
+    explicit Task(std::function<void()> body) : body(std::move(body)) {}
+    void run() override { body(); }
+
+private:
+    std::function<void()> body;
+};
+
+} // namespace
+
+VisualIndexBuilder::VisualIndexBuilder(QObject *parent)
+    : QObject(parent), currentTicket(0), pending(0)
+{
+    // Updates of the same index must not overlap; each one is spread over the shared ThreadPool
+    pool.setMaxThreadCount(1);
+}
+
+VisualIndexBuilder::~VisualIndexBuilder()
+{
+    pool.waitForDone();
+}
+
+// Start updating update.index; the returned ticket identifies the update in progress() and built().
+int VisualIndexBuilder::build(const VisualIndexUpdate &update)
+{
+    const int ticket = ++currentTicket;
+    pending++;
+    pool.start(new Task([this, ticket, update]() {
+        try {
+            updateVisualIndex(update, [this, ticket](int done, int total) {
+                emit progress(ticket, done, total);
+            });
+        } catch (const std::exception &e) {
+            qWarning() << "Could not build the visual index:" << e.what();
+        }
+        pending--;
+        emit built(ticket);
+    }));
+    return ticket;
+}
+
+// True while an update is queued or running: the indexes it works on must be left alone.
+bool VisualIndexBuilder::isBuilding() const
+{
+    return pending.load() > 0;
+}
@@ -0,0 +1,32 @@
+#ifndef VISUALINDEXBUILDER_HPP
+#define VISUALINDEXBUILDER_HPP
+
+#include <QObject>
+#include <QThreadPool>
+#include <atomic>
+#include "librarymanagement.hpp"
+
+// Brings a library's visual index up to date on a background thread (SIFT features, vocabulary training),
+// reporting progress as it goes. The index must not be used by anyone else until built() is emitted.
+class VisualIndexBuilder : public QObject {
+    Q_OBJECT
+
+public:
+    explicit VisualIndexBuilder(QObject *parent = nullptr);
+    ~VisualIndexBuilder();
+
+    int build(const VisualIndexUpdate &update);
+    bool isBuilding() const;
+
+signals:
+    // Both are emitted from a worker thread, so connections to widgets are queued.
+    void progress(int ticket, int done, int total);
+    void built(int ticket);
+
+private:
+    QThreadPool pool;
+    std::atomic<int> currentTicket;
+    std::atomic<int> pending;
+};
+
+#endif // VISUALINDEXBUILDER_HPP